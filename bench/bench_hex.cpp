@@ -0,0 +1,111 @@
+/**
+ * Project: nerdminer-rpi
+ * File: bench_hex.cpp
+ * Description: benchmark of the hex codec against the previous stringstream/strtol helpers
+ *
+ * Author: Regis Araujo Melo
+ * Date: 2025-04-21
+ * Version: 0.1.0
+ *
+ * MIT License
+ * © 2025 Regis Araujo Melo
+ */
+
+#include "nerdminer/hex.h"
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace legacy {
+
+    // Implementações anteriores, mantidas aqui só como base de comparação.
+    std::vector<uint8_t> hexStringToBytes(const std::string& hex) {
+        std::vector<uint8_t> bytes;
+        for (size_t i = 0; i < hex.length(); i += 2) {
+            std::string byteString = hex.substr(i, 2);
+            uint8_t byte = (uint8_t)strtol(byteString.c_str(), nullptr, 16);
+            bytes.push_back(byte);
+        }
+        return bytes;
+    }
+
+    std::string bytesToHex(const std::vector<uint8_t>& bytes) {
+        std::stringstream ss;
+        for (size_t i = 0; i < bytes.size(); ++i) {
+            ss << std::setw(2) << std::setfill('0') << std::hex << (int)bytes[i];
+        }
+        return ss.str();
+    }
+
+    std::string toHex(uint32_t value, int width = 8) {
+        std::stringstream ss;
+        ss << std::hex << std::setfill('0') << std::setw(width) << value;
+        return ss.str();
+    }
+
+} // namespace legacy
+
+template <typename Fn>
+static void bench(const char* name, std::size_t bytesPerIter, Fn&& fn) {
+    const int iterations = 200000;
+    volatile std::size_t sink = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i) {
+        sink = sink + fn(i);
+    }
+    auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    double nsPerIter = elapsed * 1e9 / iterations;
+    double mbPerSec = bytesPerIter * iterations / elapsed / 1e6;
+    std::cout << std::left << std::setw(34) << name
+              << std::right << std::setw(10) << std::fixed << std::setprecision(1) << nsPerIter << " ns/op"
+              << std::setw(10) << mbPerSec << " MB/s\n";
+}
+
+int main() {
+    // Tamanhos típicos: hash/ramo merkle (32 bytes) e coinbase (~100 bytes).
+    for (std::size_t size : {32u, 100u}) {
+        std::vector<uint8_t> bytes(size);
+        for (std::size_t i = 0; i < size; ++i) {
+            bytes[i] = static_cast<uint8_t>(i * 37 + 11);
+        }
+        const std::string hex = nerdminer::encodeHex(bytes.data(), bytes.size());
+        std::cout << "--- " << size << " bytes ---\n";
+
+        bench("legacy hexStringToBytes", size, [&](int) {
+            return legacy::hexStringToBytes(hex).size();
+        });
+        bench("decodeHex (vector)", size, [&](int) {
+            return nerdminer::decodeHex(hex).size();
+        });
+        std::vector<uint8_t> out(size);
+        bench("decodeHex (span, no alloc)", size, [&](int) {
+            return static_cast<std::size_t>(nerdminer::decodeHex(hex, out.data(), out.size())) + out[0];
+        });
+
+        bench("legacy bytesToHex", size, [&](int) {
+            return legacy::bytesToHex(bytes).size();
+        });
+        bench("encodeHex (string)", size, [&](int) {
+            return nerdminer::encodeHex(bytes.data(), bytes.size()).size();
+        });
+        std::string buf(2 * size, '\0');
+        bench("encodeHex (span, no alloc)", size, [&](int) {
+            nerdminer::encodeHex(bytes.data(), bytes.size(), &buf[0]);
+            return static_cast<std::size_t>(buf[0]);
+        });
+    }
+
+    std::cout << "--- uint32 nonce ---\n";
+    bench("legacy toHex", 4, [&](int i) {
+        return legacy::toHex(static_cast<uint32_t>(i)).size();
+    });
+    bench("hexU32", 4, [&](int i) {
+        return nerdminer::hexU32(static_cast<uint32_t>(i)).size();
+    });
+    return 0;
+}
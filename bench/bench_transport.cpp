@@ -0,0 +1,142 @@
+/**
+ * Project: nerdminer-rpi
+ * File: bench_transport.cpp
+ * Description: notify-to-hash latency and bytes on wire, Stratum V1 JSON vs Stratum V2 frames
+ *
+ * Author: Regis Araujo Melo
+ * Date: 2025-04-21
+ * Version: 0.1.0
+ *
+ * MIT License
+ * © 2025 Regis Araujo Melo
+ */
+
+#include "nerdminer/hash_kernel.h"
+#include "nerdminer/hex.h"
+#include "nerdminer/offline_work_source.h"
+#include "nerdminer/reference_pool.h"
+#include "nerdminer/stratum_work_source.h"
+#include "nerdminer/sv2_codec.h"
+#include "nerdminer/sv2_work_source.h"
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+namespace {
+
+    const int kJobs = 200;
+    const uint32_t kFirstBatch = 64; // nonces do primeiro lote: marca o "primeiro hash"
+
+    struct Result {
+        std::vector<double> latencyUs;
+        double bytesPerJob = 0;
+        std::size_t bytesPerSubmit = 0;
+    };
+
+    double percentile(std::vector<double> values, double p) {
+        std::sort(values.begin(), values.end());
+        return values[static_cast<std::size_t>(p * (values.size() - 1))];
+    }
+
+    /**
+     * Mede, contra o pool de referência local, o tempo entre o pool publicar
+     * um job e a fonte de trabalho entregá-lo já hasheado (parse + preparo do
+     * cabeçalho + primeiro lote), do mesmo jeito que o engine faz.
+     */
+    Result measure(nerdminer::PoolProtocol protocol) {
+        nerdminer::ReferencePoolConfig config;
+        config.protocol = protocol;
+        config.port = 0;
+        config.jobSeconds = 0;
+        nerdminer::ReferencePool pool(config);
+        pool.start();
+
+        std::unique_ptr<nerdminer::WorkSource> source;
+        if (protocol == nerdminer::PoolProtocol::Sv2) {
+            source = std::make_unique<nerdminer::Sv2WorkSource>("127.0.0.1", pool.port(), "bench");
+        } else {
+            source = std::make_unique<nerdminer::StratumWorkSource>("127.0.0.1", pool.port(), "bench", "x");
+        }
+
+        std::mutex mutex;
+        std::condition_variable cv;
+        std::string lastJob;
+        Clock::time_point published;
+        Result result;
+        std::unique_ptr<nerdminer::HashKernel> kernel = nerdminer::makeKernel("openssl");
+        std::vector<nerdminer::HashHit> hits;
+
+        source->onJob = [&](const nerdminer::MiningJob& job, const std::string& extranonce1,
+            std::size_t extranonce2Size, uint64_t) {
+            const std::string extranonce2(2 * extranonce2Size, '0');
+            auto tmpl = nerdminer::HeaderTemplate::fromHeader(job.buildHeader(extranonce1, extranonce2, 0));
+            kernel->hashHeaders(tmpl, 0, kFirstBatch, nerdminer::makeTarget(job.target()), hits);
+            const auto done = Clock::now();
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!lastJob.empty()) {
+                result.latencyUs.push_back(std::chrono::duration<double, std::micro>(done - published).count());
+            }
+            lastJob = job.jobId;
+            cv.notify_all();
+        };
+        source->start();
+
+        // O primeiro job chega na abertura da sessão; os medidos vêm depois.
+        std::unique_lock<std::mutex> lock(mutex);
+        cv.wait(lock, [&] { return !lastJob.empty(); });
+        const uint64_t bytesBefore = pool.stats().bytesOut;
+        for (int i = 0; i < kJobs; ++i) {
+            const std::string previous = lastJob;
+            published = Clock::now();
+            pool.publishJob();
+            cv.wait(lock, [&] { return lastJob != previous; });
+        }
+        lock.unlock();
+        result.bytesPerJob = static_cast<double>(pool.stats().bytesOut - bytesBefore) / kJobs;
+        source->stop();
+        pool.stop();
+
+        if (protocol == nerdminer::PoolProtocol::Sv2) {
+            result.bytesPerSubmit = nerdminer::sv2::SubmitSharesStandard().encode().size();
+        } else {
+            nerdminer::json submit = {{"id", 1234}, {"method", "mining.submit"},
+                {"params", {"bc1qcdlauj9j9jnxcdlxqkrrus40p7cp9ph6ermkfz.raspberrypi", "0000002a", "00000001",
+                    "6630a1b2", "1f2e3d4c"}}};
+            result.bytesPerSubmit = submit.dump().size() + 1;
+        }
+        return result;
+    }
+
+    void report(const char* name, const Result& result) {
+        std::cout << std::left << std::setw(12) << name << std::right << std::fixed << std::setprecision(1)
+                  << std::setw(10) << percentile(result.latencyUs, 0.5) << " us p50"
+                  << std::setw(10) << percentile(result.latencyUs, 0.99) << " us p99"
+                  << std::setw(10) << result.bytesPerJob << " B/job"
+                  << std::setw(8) << result.bytesPerSubmit << " B/submit\n";
+    }
+
+} // namespace
+
+int main() {
+    // Os logs das fontes (um por job) atrapalhariam a leitura do resultado.
+    std::ostringstream discard;
+    std::streambuf* original = std::cout.rdbuf(discard.rdbuf());
+    const Result json = measure(nerdminer::PoolProtocol::Json);
+    const Result sv2 = measure(nerdminer::PoolProtocol::Sv2);
+    std::cout.rdbuf(original);
+
+    std::cout << "--- notify -> first hash over loopback (" << kJobs << " jobs, " << kFirstBatch
+              << " nonces) ---\n";
+    report("json (v1)", json);
+    report("sv2", sv2);
+    return 0;
+}
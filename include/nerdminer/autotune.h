@@ -0,0 +1,36 @@
+/**
+* Project: nerdminer-rpi
+* File: autotune.h
+* Description: header file for the kernel autotuner
+*
+* Author: Regis Araujo Melo
+* Date: 2025-04-21
+* Version: 0.1.0
+*
+* MIT License
+* © 2025 Regis Araujo Melo
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+namespace nerdminer {
+
+struct TuneResult {
+    std::string kernel;
+    uint32_t batchSize = 0;
+    double hashrate = 0.0;
+};
+
+std::string cpuModel();
+// Identifica a build (compilador e kernels); medições de outra build não valem aqui.
+std::string buildId();
+std::string defaultTuneCachePath();
+bool loadTuneResult(const std::string& path, const std::string& cpu, TuneResult& result);
+bool saveTuneResult(const std::string& path, const std::string& cpu, const TuneResult& result);
+TuneResult autotune(double secondsPerRun);
+TuneResult resolveTuning(const std::string& cachePath, bool forceRetune);
+
+} // namespace nerdminer
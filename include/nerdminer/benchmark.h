@@ -0,0 +1,39 @@
+/**
+* Project: nerdminer-rpi
+* File: benchmark.h
+* Description: header file for the kernel benchmark mode
+*
+* Author: Regis Araujo Melo
+* Date: 2025-04-21
+* Version: 0.1.0
+*
+* MIT License
+* © 2025 Regis Araujo Melo
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "nerdminer/hash_kernel.h"
+#include "nerdminer/perf_counters.h"
+
+namespace nerdminer {
+
+struct KernelBenchResult {
+    std::string kernel;
+    bool agreesWithReference = false;
+    uint64_t hashes = 0;
+    double seconds = 0.0;
+    double hashrate = 0.0;
+    PerfSample perf;
+};
+
+HeaderTemplate makeBenchmarkTemplate();
+bool checkKernelAgainstReference(HashKernel& kernel, const HeaderTemplate& tmpl, uint32_t count);
+// perf: mede também os contadores de hardware (resultado em KernelBenchResult::perf).
+KernelBenchResult benchmarkKernel(HashKernel& kernel, double seconds, uint32_t batchSize, bool perf = false);
+int runBenchmark(double secondsPerKernel, bool perf);
+
+} // namespace nerdminer
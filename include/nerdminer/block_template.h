@@ -0,0 +1,57 @@
+/**
+* Project: nerdminer-rpi
+* File: block_template.h
+* Description: header file for getblocktemplate parsing and block/coinbase serialization
+*
+* Author: Regis Araujo Melo
+* Date: 2025-04-21
+* Version: 0.1.0
+*
+* MIT License
+* © 2025 Regis Araujo Melo
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+namespace nerdminer {
+
+using json = nlohmann::json;
+
+// Resultado do getblocktemplate (BIP 22/23), só com o que a mineração solo usa.
+// Hashes guardados como o nó os mostra (hex invertido).
+struct BlockTemplate {
+    uint32_t version = 0;
+    uint32_t height = 0;
+    uint32_t bits = 0;
+    uint32_t curtime = 0;
+    uint64_t coinbaseValue = 0;
+    std::string previousBlockHash;
+    std::string witnessCommitment; // scriptPubKey da saída de commitment; vazio sem segwit
+    std::string longpollId;
+    std::vector<std::string> txids;
+    std::vector<std::string> txData;
+
+    static BlockTemplate fromJson(const json& result);
+};
+
+// Coinbase dividida em volta do extranonce, no mesmo formato do mining.notify.
+struct CoinbaseParts {
+    std::string coinbase1;
+    std::string coinbase2;
+};
+
+std::string reverseHexBytes(const std::string& hex);
+std::string encodeVarInt(uint64_t value);
+std::string pushScriptNum(int64_t value);
+CoinbaseParts buildSoloCoinbase(const BlockTemplate& tmpl, const std::string& payoutScript,
+    std::size_t extranonceSize, const std::string& tag);
+std::string addCoinbaseWitness(const std::string& coinbase);
+std::vector<std::string> merkleBranchesFor(const std::vector<std::string>& txids);
+std::string merkleRootOf(const std::vector<std::string>& txids);
+
+} // namespace nerdminer
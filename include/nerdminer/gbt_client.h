@@ -0,0 +1,50 @@
+/**
+* Project: nerdminer-rpi
+* File: gbt_client.h
+* Description: header file for the bitcoind JSON-RPC client used by solo mining
+*
+* Author: Regis Araujo Melo
+* Date: 2025-04-21
+* Version: 0.1.0
+*
+* MIT License
+* © 2025 Regis Araujo Melo
+*/
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <nlohmann/json.hpp>
+
+namespace nerdminer {
+
+using json = nlohmann::json;
+
+// Cliente json-rpc sobre HTTP para o bitcoind (getblocktemplate, submitblock).
+// Cada chamada abre a própria conexão, então pode ser usado de várias threads
+// ao mesmo tempo, inclusive com um long poll bloqueado em outra.
+class GbtClient {
+public:
+    GbtClient(const std::string& host, uint16_t port, const std::string& user, const std::string& password);
+
+    // Lança std::runtime_error em erro de rede, HTTP ou do próprio RPC.
+    // timeout zero = sem limite (long poll).
+    json call(const std::string& method, const json& params,
+        std::chrono::seconds timeout = std::chrono::seconds(30)) const;
+    // Interrompe as chamadas em andamento (inclusive long poll) e as futuras.
+    void cancel() { cancelled_ = true; }
+    // Volta a aceitar chamadas depois de cancel().
+    void resume() { cancelled_ = false; }
+
+private:
+    std::string host_;
+    uint16_t port_;
+    std::string authorization_;
+    mutable std::atomic<int> requestId_{0};
+    std::atomic<bool> cancelled_{false};
+};
+
+} // namespace nerdminer
@@ -0,0 +1,80 @@
+/**
+* Project: nerdminer-rpi
+* File: gbt_work_source.h
+* Description: header file for the solo-mining work source (getblocktemplate)
+*
+* Author: Regis Araujo Melo
+* Date: 2025-04-21
+* Version: 0.1.0
+*
+* MIT License
+* © 2025 Regis Araujo Melo
+*/
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include "nerdminer/block_template.h"
+#include "nerdminer/gbt_client.h"
+#include "nerdminer/work_source.h"
+
+namespace nerdminer {
+
+struct SoloConfig {
+    std::string host = "127.0.0.1";
+    uint16_t port = 8332;
+    std::string rpcUser;
+    std::string rpcPassword;
+    std::string payoutAddress;
+    std::string coinbaseTag = "/nerdminer-rpi/";
+    unsigned pollSeconds = 5;      // sem long poll: intervalo entre getblocktemplate
+    unsigned refreshSeconds = 30;  // republica o mesmo bloco para pegar novas transações
+};
+
+// Mineração solo: monta a coinbase localmente a partir do getblocktemplate,
+// entrega o trabalho no mesmo formato de um mining.notify e envia o bloco
+// completo com submitblock quando um hash atinge o alvo da rede.
+class GbtWorkSource : public WorkSource {
+public:
+    explicit GbtWorkSource(const SoloConfig& config);
+    ~GbtWorkSource() override;
+
+    std::string name() const override;
+    void start() override;
+    void stop() override;
+    void submitShare(const ShareCandidate& share) override;
+
+private:
+    struct SoloJob {
+        std::string jobId;
+        BlockTemplate tmpl;
+        CoinbaseParts coinbase;
+    };
+
+    static constexpr std::size_t kExtranonce1Size = 4;
+    static constexpr std::size_t kExtranonce2Size = 4;
+    static constexpr std::size_t kKeptJobs = 4;
+
+    void pollLoop();
+    void publish(const BlockTemplate& tmpl);
+    std::shared_ptr<const SoloJob> findJob(const std::string& jobId);
+
+    SoloConfig config_;
+    GbtClient rpc_;
+    std::string payoutScript_;
+    std::string extranonce1_;
+    uint64_t nextJobId_ = 0;
+    std::atomic<bool> refresh_{false};
+    std::atomic<bool> stopping_{false};
+    std::mutex jobsMutex_;
+    std::deque<std::shared_ptr<const SoloJob>> jobs_;
+    std::thread poller_;
+};
+
+} // namespace nerdminer
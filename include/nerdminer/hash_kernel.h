@@ -0,0 +1,67 @@
+/**
+* Project: nerdminer-rpi
+* File: hash_kernel.h
+* Description: header file for the batched SHA-256d hashing kernels
+*
+* Author: Regis Araujo Melo
+* Date: 2025-04-21
+* Version: 0.1.0
+*
+* MIT License
+* © 2025 Regis Araujo Melo
+*/
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "nerdminer/nerdminer_block.h"
+
+namespace nerdminer {
+
+using Target = std::array<uint8_t, 32>;
+
+// Cabeçalho serializado (80 bytes) com o estado SHA-256 após o primeiro
+// bloco de 64 bytes. O nonce (bytes 76-79) é preenchido pelo kernel.
+struct HeaderTemplate {
+    static constexpr std::size_t kTimeOffset = 68;
+    static constexpr std::size_t kNonceOffset = 76;
+
+    std::array<uint8_t, 80> bytes{};
+    std::array<uint32_t, 8> midstate{};
+
+    static HeaderTemplate fromHeader(const BlockHeader& header);
+    // O ntime fica no segundo bloco: trocar o tempo não invalida o midstate
+    // nem exige recalcular a raiz Merkle.
+    void setTime(uint32_t ntime) { putHeaderField(bytes.data() + kTimeOffset, ntime); }
+};
+
+struct HashHit {
+    uint32_t nonce = 0;
+    std::array<uint8_t, 32> hash{};
+};
+
+class HashKernel {
+public:
+    virtual ~HashKernel() = default;
+    virtual const char* name() const = 0;
+
+    /**
+     * Calcula o SHA-256d de count cabeçalhos, com nonces a partir de nonceStart
+     * (o contador dá a volta em 2^32), e acrescenta em hitsOut apenas os que
+     * atendem ao alvo.
+     * @return Quantidade de hashes calculados.
+     */
+    virtual uint64_t hashHeaders(const HeaderTemplate& tmpl, uint32_t nonceStart, uint32_t count,
+        const Target& target, std::vector<HashHit>& hitsOut) = 0;
+};
+
+Target makeTarget(uint32_t bits);
+Target makeTarget(const std::vector<uint8_t>& expanded);
+std::vector<std::string> kernelNames();
+std::unique_ptr<HashKernel> makeKernel(const std::string& name);
+
+} // namespace nerdminer
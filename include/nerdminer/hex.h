@@ -0,0 +1,44 @@
+/**
+* Project: nerdminer-rpi
+* File: hex.h
+* Description: header file for the hex codec
+*
+* Author: Regis Araujo Melo
+* Date: 2025-04-21
+* Version: 0.1.0
+*
+* MIT License
+* © 2025 Regis Araujo Melo
+*/
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace nerdminer {
+
+    // Codec hexadecimal por tabela, sem alocação nas versões que recebem
+    // ponteiro + tamanho. Entradas vindas do pool são validadas de forma
+    // estrita: tamanho par e apenas [0-9a-fA-F].
+
+    void encodeHex(const uint8_t* data, std::size_t size, char* out);
+    std::string encodeHex(const uint8_t* data, std::size_t size);
+    bool decodeHex(std::string_view hex, uint8_t* out, std::size_t outSize);
+    std::vector<uint8_t> decodeHex(std::string_view hex);
+    bool isHex(std::string_view hex, std::size_t expectedBytes = std::string_view::npos);
+
+    void encodeHexU32(uint32_t value, char* out);
+    std::string hexU32(uint32_t value);
+    bool parseHexU32(std::string_view hex, uint32_t& value);
+
+    template <std::size_t N>
+    bool decodeHex(std::string_view hex, std::array<uint8_t, N>& out) {
+        return decodeHex(hex, out.data(), out.size());
+    }
+
+} // namespace nerdminer
@@ -16,6 +16,7 @@
 #include <string>
 #include <vector>
 #include <nlohmann/json.hpp>
+#include "nerdminer/nerdminer_block.h"
 
 namespace nerdminer {
 
@@ -37,8 +38,16 @@ struct MiningJob {
     uint32_t versionInt = 0;
     uint32_t bits = 0;
     uint32_t ntime = 0;
+    double difficulty = 0; // dificuldade de share do pool; 0 = alvo do próprio bloco
+    // Canal padrão (Stratum V2): o pool já manda a raiz Merkle e o alvo exato,
+    // sem coinbase nem extranonce. Vazios = calcula pela coinbase / difficulty.
+    std::string merkleRoot;
+    std::vector<uint8_t> shareTarget;
 
     static MiningJob fromNotification(const json& note);
+    BlockHeader buildHeader(const std::string& extranonce1, const std::string& extranonce2, uint32_t nonce) const;
+    std::vector<uint8_t> target() const;
+    bool headerOnly() const { return !merkleRoot.empty(); }
 };
 
 } // namespace nerdminer
\ No newline at end of file
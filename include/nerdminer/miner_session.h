@@ -13,41 +13,94 @@
 
 #pragma once
 
-#include <string>
-#include <vector>
 #include <atomic>
-#include <thread>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
 #include <mutex>
-#include "nerdminer/stratum_client.h"
-#include "nerdminer/miner_job.h"
+#include <string>
+#include <vector>
+#include "nerdminer/mining_engine.h"
+#include "nerdminer/work_source.h"
 
 namespace nerdminer {
 
+// Caminho padrão do arquivo de estado da sessão (ids de sessão dos pools).
+std::string defaultSessionStatePath();
+
+// Liga uma ou mais fontes de trabalho ao MiningEngine. Cada fonte ocupa um
+// slot do engine; o hashrate é dividido na proporção dos pesos.
 class MinerSession {
 public:
+    struct SourceConfig {
+        std::unique_ptr<WorkSource> source;
+        double weight = 1.0;
+    };
+
+    // Configuração aplicada com a sessão rodando. A lista de fontes é
+    // completa: fontes com o mesmo name() de uma atual são mantidas (sem
+    // reconectar), as ausentes são paradas e as novas iniciadas.
+    struct Reconfiguration {
+        int threads = 0;        // 0 = mantém
+        std::string kernel;     // vazio = mantém
+        uint32_t batchSize = 0; // 0 = mantém
+        std::vector<SourceConfig> sources;
+    };
+
+    MinerSession();
+    // Atalho para o caso comum: um único pool Stratum.
     MinerSession(const std::string& host, uint16_t port, const std::string& user, const std::string& password);
-    void handleNotification(const nerdminer::json& note);
-    void handleResponse(const json& response);
-    void handleSubmitResponse(const json& response);
+    ~MinerSession();
+
+    void addSource(std::unique_ptr<WorkSource> source, double weight = 1.0);
+    // Inicia engine e fontes e bloqueia até stop(). Então para os hashes,
+    // entrega os shares já encontrados, espera as respostas dos pools e
+    // grava o arquivo de estado antes de desconectar.
     void start();
-private:
-    bool running_ = true;
-    std::string extranonce1_;
-    void miningLoop(int threadId);
-    void startMiningThreads();
-    void stopMiningThreads();
+    // Pode ser chamado de qualquer thread (não de um handler de sinal).
+    void stop();
+    // Chamado de outra thread com start() em andamento; não concorrente com stop().
+    void reconfigure(Reconfiguration config);
+
+    void setThreads(int threads);
+    void setKernel(const std::string& kernel);
+    void setBatchSize(uint32_t batchSize);
+    void setNtimeRoll(uint32_t seconds);
+    void setPerfCounters(bool enabled);
+    // Arquivo json com o estado de cada fonte, para retomar a sessão no pool
+    // depois de reiniciar. Vazio = sem arquivo.
+    void setStateFile(const std::string& path);
 
 private:
-    StratumClient client_;
-    MiningJob currentJob_;
-    std::vector<std::thread> miners_;
-    std::atomic<bool> miningActive;
-    int numThreads_;
-    std::mutex currentJobMutex_;
-    std::vector<uint64_t> threadHashCounts_;
-    std::chrono::time_point<std::chrono::steady_clock> lastHashrateTime_;
-    mutable std::mutex outputMutex_;
-    std::unordered_map<int, std::chrono::steady_clock::time_point> pendingSubmits_;
+    struct SourceState {
+        std::unique_ptr<WorkSource> source;
+        double weight = 1.0;
+        std::atomic<double> difficulty{0};
+        // Protegidos por sourcesMutex_.
+        std::size_t slot = 0;
+        bool active = false;
+        bool hasWork = false;
+        MiningJob job;
+        std::string extranonce1;
+        std::size_t extranonce2Size = 0;
+    };
+
+    std::unique_ptr<SourceState> makeState(std::unique_ptr<WorkSource> source, double weight);
+    void applySlots();
+    std::size_t startSources(const std::vector<SourceState*>& states);
+    void shutdown();
+    json loadState() const;
+    void saveState() const;
+    void submitShare(const ShareCandidate& share);
+
+    std::mutex sourcesMutex_;
+    std::vector<std::unique_ptr<SourceState>> sources_;
+    std::string statePath_;
+    std::mutex stopMutex_;
+    std::condition_variable stopCv_;
+    bool stopRequested_ = false;
+    std::atomic<bool> running_{false};
+    MiningEngine engine_;
 };
 
-} // namespace nerdminer
\ No newline at end of file
+} // namespace nerdminer
@@ -0,0 +1,156 @@
+/**
+* Project: nerdminer-rpi
+* File: mining_engine.h
+* Description: header file for the hashing engine shared by pool and solo sessions
+*
+* Author: Regis Araujo Melo
+* Date: 2025-04-21
+* Version: 0.1.0
+*
+* MIT License
+* © 2025 Regis Araujo Melo
+*/
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "nerdminer/miner_job.h"
+#include "nerdminer/perf_counters.h"
+#include "nerdminer/share_verifier.h"
+
+namespace nerdminer {
+
+// Threads de mineração, kernels, verificação e estatísticas. Quem fornece
+// os jobs (pool Stratum, nó local) só chama setWork() e recebe os shares
+// já verificados pelo callback.
+//
+// Com mais de um slot (uma fonte de trabalho por slot), cada thread escolhe
+// a cada lote o slot mais atrasado em relação ao seu peso, então o hashrate
+// se divide na proporção dos pesos mesmo com poucas threads.
+class MiningEngine {
+public:
+    using ShareFn = std::function<void(const ShareCandidate&)>;
+
+    struct SlotConfig {
+        std::string name;
+        double weight = 1.0;
+    };
+
+    explicit MiningEngine(ShareFn onShare);
+    ~MiningEngine();
+
+    void setThreads(int threads);
+    void setKernel(const std::string& kernel);
+    void setBatchSize(uint32_t batchSize);
+    void setNtimeRoll(uint32_t seconds);
+    void setPerfCounters(bool enabled);
+    // Época de restart (quantas vezes as threads já pararam). Persistida no
+    // arquivo de estado para que uma sessão retomada não volte às lanes de
+    // extranonce2 da execução anterior; só antes de start().
+    void setRestartEpoch(uint32_t epoch) { restarts_ = epoch; }
+    uint32_t restartEpoch() const { return restarts_; }
+    // Só antes de start(); por padrão há um único slot.
+    void setSlots(const std::vector<SlotConfig>& slots);
+
+    void setWork(std::size_t slot, const MiningJob& job, const std::string& extranonce1,
+        std::size_t extranonce2Size, uint64_t receivedNs = 0);
+    void setWork(const MiningJob& job, const std::string& extranonce1, std::size_t extranonce2Size,
+        uint64_t receivedNs = 0) {
+        setWork(0, job, extranonce1, extranonce2Size, receivedNs);
+    }
+    // Troca o alvo de share do trabalho atual sem recomeçar a busca dele.
+    void setTarget(std::size_t slot, const std::vector<uint8_t>& shareTarget);
+    // Tira o trabalho do slot: as threads param de minerar nele até o próximo setWork.
+    void clearWork(std::size_t slot);
+    void start();
+    void stop();
+    // Espera o verificador entregar os candidatos já encontrados (após stop()).
+    void drainShares() { verifier_.drain(); }
+
+    int threads() const { return numThreads_; }
+    // Hashes contabilizados no slot: a base da divisão por peso.
+    uint64_t slotHashes(std::size_t slot) const { return slots_.at(slot)->hashes; }
+
+    // Lanes de busca: cada thread de cada época de restart minera com um
+    // extranonce2 próprio. O que da época não cabe num extranonce2 estreito
+    // (ou num job sem extranonce) escolhe um de kNtimeEpochs ntimes iniciais,
+    // e o ntime rola de ntimeStep() em ntimeStep() segundos, então épocas
+    // diferentes nunca chegam ao mesmo ntime. Só depois de kNtimeEpochs
+    // restarts sobre o mesmo job uma época volta a um ntime já usado.
+    static constexpr uint32_t kNtimeEpochs = 16;
+    static std::string laneExtranonce2(std::size_t extranonce2Size, uint32_t epoch, int threadId);
+    static uint32_t laneNtimeOffset(std::size_t extranonce2Size, uint32_t epoch, uint32_t ntimeRoll);
+    static uint32_t ntimeStep(uint32_t ntimeRoll);
+    // Próximo ntime da lane, se ainda couber na janela: até ntimeRoll segundos
+    // após o ntime do job e no máximo 2 horas à frente de now.
+    static bool rollNtime(uint32_t jobNtime, uint32_t ntimeRoll, uint64_t now, uint32_t& ntime);
+
+private:
+    struct Work {
+        MiningJob job;
+        std::string extranonce1;
+        std::size_t extranonce2Size = 0;
+    };
+
+    struct Slot {
+        SlotConfig config;
+        Work work;                               // protegido por workMutex_
+        std::atomic<uint64_t> generation{0};     // 0 = ainda sem trabalho
+        std::atomic<uint64_t> targetVersion{0};  // muda a cada setTarget
+        std::atomic<uint64_t> firstHashGeneration{0};
+        std::atomic<uint64_t> hashes{0};
+        uint64_t reportedHashes = 0;             // protegido por workMutex_
+    };
+
+    // Progresso de uma thread no trabalho atual de um slot.
+    struct Cursor;
+
+    struct PerfTotals {
+        PerfSample sample;
+        uint64_t hashes = 0;
+    };
+
+    int pickSlot(const std::vector<Cursor>& cursors) const;
+    void miningLoop(int threadId);
+    void reportHashrate();
+
+    std::vector<std::thread> miners_;
+    std::atomic<bool> miningActive{false};
+    int numThreads_;
+    // Quantas vezes as threads já foram paradas. Entra no extranonce2 (e no
+    // ntime, no que não couber nele ou em jobs sem extranonce; ver
+    // laneNtimeOffset) para que um restart não refaça o trabalho já feito
+    // no mesmo job e repita shares.
+    uint32_t restarts_ = 0;
+    std::string kernelName_ = "generic";
+    uint32_t batchSize_ = 4096;
+    uint32_t ntimeRoll_ = 300;
+    bool perfEnabled_ = false;
+
+    std::mutex workMutex_;
+    std::vector<std::unique_ptr<Slot>> slots_;
+    uint64_t jobGeneration_ = 0; // protegido por workMutex_; único entre slots (ids do trace)
+
+    // Um contador por thread, cada um na sua linha de cache; quem relata a
+    // hashrate zera com exchange, sem perder o que chegar no meio.
+    struct alignas(64) HashCounter {
+        std::atomic<uint64_t> value{0};
+    };
+    std::unique_ptr<HashCounter[]> threadHashCounts_;
+    std::chrono::time_point<std::chrono::steady_clock> lastHashrateTime_; // protegido por outputMutex_
+    mutable std::mutex outputMutex_;
+    std::mutex perfMutex_;
+    std::map<std::string, PerfTotals> perfTotals_;
+    ShareVerifier verifier_;
+};
+
+} // namespace nerdminer
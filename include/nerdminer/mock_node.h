@@ -0,0 +1,61 @@
+/**
+* Project: nerdminer-rpi
+* File: mock_node.h
+* Description: header file for a minimal bitcoind stand-in used to exercise solo mining
+*
+* Author: Regis Araujo Melo
+* Date: 2025-04-21
+* Version: 0.1.0
+*
+* MIT License
+* © 2025 Regis Araujo Melo
+*/
+
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <boost/asio.hpp>
+#include <nlohmann/json.hpp>
+
+namespace nerdminer {
+
+using json = nlohmann::json;
+
+struct MockNodeConfig {
+    uint16_t port = 18443;
+    uint32_t bits = 0x1e00ffff;  // ~16M hashes por bloco: alguns segundos num Pi
+    std::size_t mempoolSize = 3; // transações sintéticas por template
+    unsigned longpollSeconds = 30;
+};
+
+// Nó falso que fala o json-rpc do bitcoind: getblocktemplate (com long poll),
+// validateaddress e submitblock. Valida cabeçalho, raiz Merkle e prova de
+// trabalho de cada bloco e avança a cadeia quando ele é aceito, o que permite
+// testar a mineração solo sem um nó de verdade.
+class MockNode {
+public:
+    explicit MockNode(const MockNodeConfig& config);
+    void start();
+
+private:
+    void serve(boost::asio::ip::tcp::socket socket);
+    json dispatch(const std::string& method, const json& params);
+    json blockTemplate(const json& request);
+    json submitBlock(const std::string& blockHex);
+    void newTemplate();
+
+    MockNodeConfig config_;
+    std::mutex mutex_;
+    std::condition_variable changed_;
+    uint32_t height_ = 1;
+    uint64_t templateSerial_ = 0;
+    std::string tip_;              // hash exibido do último bloco
+    std::vector<std::string> txData_;
+    std::vector<std::string> txids_; // ordem interna
+};
+
+} // namespace nerdminer
@@ -31,7 +31,10 @@ namespace nerdminer {
     std::vector<uint8_t> doubleSHA256(const std::vector<uint8_t>& data);
     std::vector<uint8_t> buildBlockHeader(const BlockHeader& header);
     std::vector<uint8_t> targetFromBits(uint32_t bits);
+    std::vector<uint8_t> targetFromDifficulty(double difficulty);
     bool isHashBelowTarget(const std::vector<uint8_t>& hash, const std::vector<uint8_t>& target);
+    bool isHashBelowTarget(const uint8_t* hash, const uint8_t* target);
+    void putHeaderField(uint8_t* dst, uint32_t value);
     std::string bytesToHex(const std::vector<uint8_t>& bytes);
     std::string buildCoinbaseTransaction(const std::string& coinb1, const std::string& extranonce, const std::string& coinb2);
     std::string calculateMerkleRoot(const std::string& coinbaseTransaction, const std::vector<std::string>& merkleBranches);
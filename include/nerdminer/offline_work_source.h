@@ -0,0 +1,63 @@
+/**
+* Project: nerdminer-rpi
+* File: offline_work_source.h
+* Description: header file for the synthetic work source used for offline runs
+*
+* Author: Regis Araujo Melo
+* Date: 2025-04-21
+* Version: 0.1.0
+*
+* MIT License
+* © 2025 Regis Araujo Melo
+*/
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include "nerdminer/work_source.h"
+
+namespace nerdminer {
+
+struct OfflineConfig {
+    double difficulty = 0.001;  // ~4M hashes por share
+    unsigned jobSeconds = 30;   // intervalo entre jobs novos (clean_jobs)
+};
+
+// Job sintético determinístico (coinbase e ramos Merkle de tamanho realista),
+// com extranonce de 8 bytes no total. Também usado pelo pool de referência.
+MiningJob syntheticJob(uint64_t serial);
+
+// Gera jobs sintéticos e aceita os shares localmente: roda o pipeline
+// inteiro (jobs, kernels, verificador, submit) sem rede, para benchmark e testes.
+class OfflineWorkSource : public WorkSource {
+public:
+    explicit OfflineWorkSource(const OfflineConfig& config = OfflineConfig());
+    ~OfflineWorkSource() override;
+
+    std::string name() const override { return "offline"; }
+    void start() override;
+    void stop() override;
+    void submitShare(const ShareCandidate& share) override;
+
+    uint64_t accepted() const { return accepted_; }
+    uint64_t stale() const { return stale_; }
+
+private:
+    void run();
+
+    OfflineConfig config_;
+    std::thread worker_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    bool stopping_ = false;
+    std::string currentJobId_;
+    std::atomic<uint64_t> accepted_{0};
+    std::atomic<uint64_t> stale_{0};
+};
+
+} // namespace nerdminer
@@ -0,0 +1,80 @@
+/**
+* Project: nerdminer-rpi
+* File: perf_counters.h
+* Description: header file for the hardware performance counters (perf_event_open)
+*
+* Author: Regis Araujo Melo
+* Date: 2025-04-21
+* Version: 0.1.0
+*
+* MIT License
+* © 2025 Regis Araujo Melo
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+namespace nerdminer {
+
+enum PerfEvent {
+    PerfCycles = 0,
+    PerfInstructions,
+    PerfCacheMisses,
+    PerfBranchMisses,
+    PerfEventCount
+};
+
+struct PerfSample {
+    uint64_t values[PerfEventCount] = {};
+    bool valid[PerfEventCount] = {};
+
+    PerfSample& operator+=(const PerfSample& other);
+};
+
+// Leitura do grupo inteiro (PERF_FORMAT_GROUP), já na ordem de PerfEvent.
+struct PerfReading {
+    uint64_t values[PerfEventCount] = {};
+    bool present[PerfEventCount] = {}; // eventos que abriram nesta CPU
+    uint64_t enabled = 0;
+    uint64_t running = 0;
+};
+
+// Contagem entre duas leituras, extrapolada por tempo habilitado / tempo
+// rodando. Intervalo em que o grupo nunca rodou devolve uma amostra vazia.
+PerfSample perfDelta(const PerfReading& start, const PerfReading& now);
+
+// Contadores da thread que cria o objeto (pid = 0, cpu = -1), só user space.
+// Abertos como um grupo: o kernel agenda todos juntos na PMU, então as razões
+// (IPC, ciclos/hash) comparam o mesmo intervalo. Se a PMU foi multiplexada, os
+// valores são escalados por tempo habilitado / tempo rodando.
+// Se o kernel não permitir (perf_event_paranoid, container, VM sem PMU), os
+// contadores ficam indisponíveis e begin()/end() viram no-op.
+class PerfCounters {
+public:
+    PerfCounters();
+    ~PerfCounters();
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+
+    bool available() const;
+    void begin();
+    void end();
+    PerfSample take();
+
+private:
+    bool readAll(PerfReading& out) const;
+
+    int fds_[PerfEventCount];
+    int leader_ = -1;
+    int members_ = 0;
+    int slot_[PerfEventCount] = {}; // posição de cada evento na leitura do grupo
+    PerfReading start_;
+    PerfSample total_;
+};
+
+void printPerfLine(std::ostream& os, const std::string& label, const PerfSample& sample, uint64_t hashes);
+
+} // namespace nerdminer
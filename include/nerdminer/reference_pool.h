@@ -0,0 +1,101 @@
+/**
+* Project: nerdminer-rpi
+* File: reference_pool.h
+* Description: header file for the local reference pool (Stratum V1 JSON or Stratum V2 binary)
+*
+* Author: Regis Araujo Melo
+* Date: 2025-04-21
+* Version: 0.1.0
+*
+* MIT License
+* © 2025 Regis Araujo Melo
+*/
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <boost/asio.hpp>
+#include "nerdminer/miner_job.h"
+
+namespace nerdminer {
+
+enum class PoolProtocol { Json, Sv2 };
+
+struct ReferencePoolConfig {
+    PoolProtocol protocol = PoolProtocol::Json;
+    uint16_t port = 3333;     // 0 = porta livre escolhida pelo sistema
+    double difficulty = 0.001;
+    unsigned jobSeconds = 30; // 0 = jobs só via publishJob()
+};
+
+struct ReferencePoolStats {
+    uint64_t bytesIn = 0;
+    uint64_t bytesOut = 0;
+    uint64_t jobs = 0;
+    uint64_t accepted = 0;
+    uint64_t rejected = 0;
+};
+
+// Pool local mínimo para testes e benchmarks de transporte: serve os mesmos
+// jobs sintéticos em Stratum V1 (json por linha) ou Stratum V2 (frames
+// binários, canal padrão, sem criptografia), valida cada share e conta os
+// bytes trafegados nos dois sentidos.
+class ReferencePool {
+public:
+    explicit ReferencePool(const ReferencePoolConfig& config);
+    ~ReferencePool();
+
+    // Abre a porta e atende em thread própria; não bloqueia.
+    void start();
+    void stop();
+    uint16_t port() const { return port_; }
+    // Envia um job novo (clean) a todos os mineradores conectados.
+    void publishJob();
+    ReferencePoolStats stats() const;
+
+private:
+    class Session;
+    class JsonSession;
+    class Sv2Session;
+
+    struct PoolJob {
+        uint32_t serial = 0;
+        MiningJob job;
+    };
+
+    void doAccept();
+    void scheduleJob();
+    void broadcast();
+    // Um dos últimos jobs publicados, ou nullptr; só o mais novo aceita shares.
+    const PoolJob* findJob(uint32_t serial) const;
+    bool checkShare(const MiningJob& job, const std::string& extranonce1, const std::string& extranonce2,
+        uint32_t ntime, uint32_t nonce) const;
+
+    ReferencePoolConfig config_;
+    std::vector<uint8_t> shareTarget_;
+    boost::asio::io_context io_;
+    boost::asio::ip::tcp::acceptor acceptor_;
+    boost::asio::steady_timer timer_;
+    std::thread thread_;
+    uint16_t port_ = 0;
+
+    // Só tocados na thread do io_context.
+    std::vector<std::weak_ptr<Session>> sessions_;
+    std::deque<PoolJob> jobs_;
+    uint32_t nextSerial_ = 1;
+    uint32_t nextExtranonce1_ = 1;
+
+    std::atomic<uint64_t> bytesIn_{0};
+    std::atomic<uint64_t> bytesOut_{0};
+    std::atomic<uint64_t> jobCount_{0};
+    std::atomic<uint64_t> accepted_{0};
+    std::atomic<uint64_t> rejected_{0};
+};
+
+} // namespace nerdminer
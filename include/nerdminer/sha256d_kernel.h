@@ -0,0 +1,141 @@
+/**
+* Project: nerdminer-rpi
+* File: sha256d_kernel.h
+* Description: compile-time specialized SHA-256d kernel (lanes x round unroll)
+*
+* Author: Regis Araujo Melo
+* Date: 2025-04-21
+* Version: 0.1.0
+*
+* MIT License
+* © 2025 Regis Araujo Melo
+*/
+
+#pragma once
+
+#include <cstring>
+#include <string>
+#include "nerdminer/hash_kernel.h"
+#include "nerdminer/sha256.h"
+
+namespace nerdminer {
+
+/**
+ * SHA-256d portátil a partir do midstate do template.
+ *
+ * Lanes: quantos nonces são processados lado a lado. Cada palavra do estado
+ * vira um vetor de Lanes elementos, o que dá cadeias de dependência
+ * independentes para a CPU intercalar e permite ao compilador vetorizar
+ * (NEON no Pi, SSE/AVX no x86).
+ * Unroll: quantas rodadas por iteração do laço de rodadas (divisor de 64).
+ */
+template <int Lanes, int Unroll>
+class Sha256dKernel : public HashKernel {
+    static_assert(Lanes >= 1, "at least one lane");
+    static_assert(Unroll >= 1 && 64 % Unroll == 0, "Unroll must divide 64");
+
+public:
+    Sha256dKernel()
+        : name_("sha256d-l" + std::to_string(Lanes) + "u" + std::to_string(Unroll)) {}
+
+    const char* name() const override { return name_.c_str(); }
+
+    uint64_t hashHeaders(const HeaderTemplate& tmpl, uint32_t nonceStart, uint32_t count,
+        const Target& target, std::vector<HashHit>& hitsOut) override {
+        uint32_t block2[16][Lanes];
+        uint32_t block3[16][Lanes];
+        for (int l = 0; l < Lanes; ++l) {
+            for (int i = 0; i < 3; ++i) {
+                block2[i][l] = readBE32(tmpl.bytes.data() + 64 + 4 * i);
+            }
+            block2[4][l] = 0x80000000;
+            for (int i = 5; i < 15; ++i) {
+                block2[i][l] = 0;
+            }
+            block2[15][l] = 80 * 8;
+            block3[8][l] = 0x80000000;
+            for (int i = 9; i < 15; ++i) {
+                block3[i][l] = 0;
+            }
+            block3[15][l] = 32 * 8;
+        }
+
+        uint32_t state[8][Lanes];
+        uint8_t nonceBytes[4];
+        HashHit hit;
+        uint32_t done = 0;
+        while (done < count) {
+            const int active = (count - done) < uint32_t(Lanes) ? int(count - done) : Lanes;
+            for (int l = 0; l < Lanes; ++l) {
+                putHeaderField(nonceBytes, nonceStart + done + uint32_t(l));
+                block2[3][l] = readBE32(nonceBytes);
+                for (int w = 0; w < 8; ++w) {
+                    state[w][l] = tmpl.midstate[w];
+                }
+            }
+            compress(state, block2);
+
+            for (int w = 0; w < 8; ++w) {
+                for (int l = 0; l < Lanes; ++l) {
+                    block3[w][l] = state[w][l];
+                    state[w][l] = kSha256Init[w];
+                }
+            }
+            compress(state, block3);
+
+            for (int l = 0; l < active; ++l) {
+                for (int w = 0; w < 8; ++w) {
+                    writeBE32(hit.hash.data() + 4 * w, state[w][l]);
+                }
+                if (isHashBelowTarget(hit.hash.data(), target.data())) {
+                    hit.nonce = nonceStart + done + uint32_t(l);
+                    hitsOut.push_back(hit);
+                }
+            }
+            done += uint32_t(active);
+        }
+        return count;
+    }
+
+private:
+    static inline void compress(uint32_t state[8][Lanes], const uint32_t block[16][Lanes]) {
+        uint32_t w[64][Lanes];
+        std::memcpy(w, block, sizeof(uint32_t) * 16 * Lanes);
+        for (int i = 16; i < 64; ++i) {
+            for (int l = 0; l < Lanes; ++l) {
+                uint32_t s0 = sha256Rotr(w[i - 15][l], 7) ^ sha256Rotr(w[i - 15][l], 18) ^ (w[i - 15][l] >> 3);
+                uint32_t s1 = sha256Rotr(w[i - 2][l], 17) ^ sha256Rotr(w[i - 2][l], 19) ^ (w[i - 2][l] >> 10);
+                w[i][l] = w[i - 16][l] + s0 + w[i - 7][l] + s1;
+            }
+        }
+
+        uint32_t a[Lanes], b[Lanes], c[Lanes], d[Lanes], e[Lanes], f[Lanes], g[Lanes], h[Lanes];
+        for (int l = 0; l < Lanes; ++l) {
+            a[l] = state[0][l]; b[l] = state[1][l]; c[l] = state[2][l]; d[l] = state[3][l];
+            e[l] = state[4][l]; f[l] = state[5][l]; g[l] = state[6][l]; h[l] = state[7][l];
+        }
+        for (int r = 0; r < 64; r += Unroll) {
+#pragma GCC unroll 64
+            for (int u = 0; u < Unroll; ++u) {
+                const int i = r + u;
+                for (int l = 0; l < Lanes; ++l) {
+                    uint32_t S1 = sha256Rotr(e[l], 6) ^ sha256Rotr(e[l], 11) ^ sha256Rotr(e[l], 25);
+                    uint32_t ch = (e[l] & f[l]) ^ (~e[l] & g[l]);
+                    uint32_t t1 = h[l] + S1 + ch + kSha256K[i] + w[i][l];
+                    uint32_t S0 = sha256Rotr(a[l], 2) ^ sha256Rotr(a[l], 13) ^ sha256Rotr(a[l], 22);
+                    uint32_t maj = (a[l] & b[l]) ^ (a[l] & c[l]) ^ (b[l] & c[l]);
+                    h[l] = g[l]; g[l] = f[l]; f[l] = e[l]; e[l] = d[l] + t1;
+                    d[l] = c[l]; c[l] = b[l]; b[l] = a[l]; a[l] = t1 + S0 + maj;
+                }
+            }
+        }
+        for (int l = 0; l < Lanes; ++l) {
+            state[0][l] += a[l]; state[1][l] += b[l]; state[2][l] += c[l]; state[3][l] += d[l];
+            state[4][l] += e[l]; state[5][l] += f[l]; state[6][l] += g[l]; state[7][l] += h[l];
+        }
+    }
+
+    std::string name_;
+};
+
+} // namespace nerdminer
@@ -0,0 +1,89 @@
+/**
+* Project: nerdminer-rpi
+* File: share_verifier.h
+* Description: header file for the share verifier
+*
+* Author: Regis Araujo Melo
+* Date: 2025-04-21
+* Version: 0.1.0
+*
+* MIT License
+* © 2025 Regis Araujo Melo
+*/
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "nerdminer/miner_job.h"
+
+namespace nerdminer {
+
+struct ShareCandidate {
+    std::string kernel;
+    std::size_t slot = 0; // slot do MiningEngine (fonte de trabalho)
+    MiningJob job;
+    std::string extranonce1;
+    std::string extranonce2;
+    uint32_t ntime = 0;
+    uint32_t nonce = 0;
+    std::vector<uint8_t> hash; // hash informado pelo kernel
+};
+
+struct KernelVerifyStats {
+    uint64_t verified = 0;
+    uint64_t mismatches = 0;
+    uint64_t dropped = 0;
+    uint64_t verifyNanos = 0;
+    bool disabled = false;
+};
+
+class ShareVerifier {
+public:
+    using SubmitFn = std::function<void(const ShareCandidate&)>;
+
+    explicit ShareVerifier(SubmitFn submit, uint32_t maxMismatches = 1, std::size_t maxQueue = 256);
+    ~ShareVerifier();
+
+    void enqueue(ShareCandidate candidate);
+    const std::atomic<bool>& disabledFlag(const std::string& kernel);
+    std::map<std::string, KernelVerifyStats> stats() const;
+    void printStats(std::ostream& os) const;
+    // Bloqueia até a fila esvaziar e o último candidato ser entregue.
+    void drain();
+    void stop();
+
+private:
+    struct KernelState {
+        std::atomic<bool> disabled{false};
+        KernelVerifyStats stats;
+    };
+
+    void run();
+    KernelState& stateFor(const std::string& kernel);
+
+    SubmitFn submit_;
+    uint32_t maxMismatches_;
+    std::size_t maxQueue_;
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;
+    std::condition_variable idleCv_;
+    std::deque<ShareCandidate> queue_;
+    bool busy_ = false; // candidato fora da fila, ainda em verificação/submit
+    std::map<std::string, std::unique_ptr<KernelState>> kernels_;
+    bool stopping_ = false;
+    std::thread worker_;
+};
+
+} // namespace nerdminer
@@ -17,6 +17,11 @@
 #include <nerdminer/miner_job.h>
 #include <boost/asio.hpp>
 #include <nlohmann/json.hpp>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <memory>
 
 namespace nerdminer {
 
@@ -25,22 +30,47 @@ using json = nlohmann::json;
 
 class StratumClient {
 public:
+    // Limites aceitos na resposta do mining.subscribe.
+    static constexpr std::size_t kMaxExtranonce1Size = 32;
+    static constexpr std::size_t kMaxExtranonce2Size = 16;
+
     StratumClient(const std::string& host, uint16_t port,
         const std::string& user, const std::string& password);
     ~StratumClient();
     void connect();
     void subscribe();
     void authorize();
-    void sendRequest(const json& req);
+    int sendRequest(const json& req);
     void listen();
     std::function<void(const json&)> onNotification;
     std::function<void(const json&)> onResponse;
+    // Chamado quando a resposta do mining.subscribe chega (de novo a cada reconexão).
+    std::function<void()> onSubscribed;
+    // Chamado na thread de IO quando a conexão cai, antes de reconectar.
+    std::function<void()> onDisconnected;
     void submitShare(const MiningJob& job, uint32_t nonce);
+    int submitShare(const std::string& jobId, const std::string& extranonce2,
+        const std::string& ntime, uint32_t nonce);
     void handleSubmitResponse(const json& response);
+
+    boost::asio::io_context& ioContext() { return ioContext_; }
+    // Id de sessão a pedir de volta no próximo mining.subscribe (retomada).
+    void setResumeSessionId(const std::string& sessionId) { resumeSessionId_ = sessionId; }
+    // Id da assinatura mining.notify devolvido pelo pool.
+    const std::string& sessionId() const { return sessionId_; }
+    const std::string& extranonce1() const { return extranonce1_; }
+    std::size_t extranonce2Size() const { return extranonce2Size_; }
+    bool subscribed() const { return subscribed_; }
+    // Instante (traceNow) em que começou o processamento da última linha lida.
+    uint64_t lastReadTimestamp() const { return lastReadNs_; }
 private:
     void doRead();
+    void doWrite();
     void handleRead(const boost::system::error_code& ec, std::size_t bytes_transferred);
     void handleWrite(const boost::system::error_code& ec, std::size_t bytes_transferred);
+    void handleSubscribeResult(const json& resp);
+    void connectionLost(const std::string& reason);
+    void scheduleReconnect();
     boost::asio::io_context ioContext_;
     tcp::socket socket_;
     std::string host_;
@@ -48,7 +78,26 @@ private:
     std::string user_;
     std::string password_;
     boost::asio::streambuf buffer_;
-    int requestId_;
+    std::atomic<int> requestId_;
+    int subscribeId_ = -1;
+    bool subscribed_ = false;
+    uint64_t lastReadNs_ = 0;
+    std::string resumeSessionId_;
+    std::string sessionId_;
+    std::string extranonce1_;
+    std::size_t extranonce2Size_ = 0;
+
+    // Mensagens pendentes; tudo o que acumula durante uma escrita sai
+    // junto na próxima (gather write), o que agrupa submits em rajada.
+    std::deque<std::string> writeQueue_;
+    std::vector<std::string> inFlight_;
+    bool writing_ = false;
+    // Só na thread de IO: mensagens enviadas sem conexão são descartadas.
+    bool connected_ = false;
+
+    // Conexão perdida: reconecta e assina de novo, com espera de 1 s a 60 s.
+    boost::asio::steady_timer reconnectTimer_;
+    std::chrono::seconds reconnectDelay_{1};
 };
 
 } // namespace nerdminer
\ No newline at end of file
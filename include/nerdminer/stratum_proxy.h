@@ -0,0 +1,94 @@
+/**
+* Project: nerdminer-rpi
+* File: stratum_proxy.h
+* Description: header file for the Stratum proxy
+*
+* Author: Regis Araujo Melo
+* Date: 2025-04-21
+* Version: 0.1.0
+*
+* MIT License
+* © 2025 Regis Araujo Melo
+*/
+
+#pragma once
+
+#include <nerdminer/stratum_client.h>
+#include <boost/asio.hpp>
+#include <nlohmann/json.hpp>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace nerdminer {
+
+struct StratumProxyConfig {
+    uint16_t listenPort = 3333;
+    // Bytes do extranonce2 do upstream reservados para o prefixo de cada rig.
+    std::size_t prefixBytes = 2;
+    std::size_t maxLineLength = 4096;
+    std::size_t maxQueuedBytes = 64 * 1024;
+    // Submits de um rig aguardando resposta do upstream, e quanto tempo aguardam.
+    std::size_t maxPendingSubmits = 64;
+    std::chrono::seconds submitTimeout{30};
+    // Rig que não manda nenhuma linha neste tempo é desconectado.
+    std::chrono::seconds idleTimeout{600};
+};
+
+class StratumProxy {
+public:
+    StratumProxy(const std::string& host, uint16_t port,
+        const std::string& user, const std::string& password,
+        const StratumProxyConfig& config);
+    // Roda o proxy na thread atual. Só retorna se o upstream não servir
+    // (extranonce2 pequeno demais para os prefixos): false.
+    bool start();
+private:
+    class Downstream;
+    friend class Downstream;
+
+    struct PendingSubmit {
+        std::weak_ptr<Downstream> session;
+        uint64_t sessionId = 0;
+        json downstreamId;
+        std::chrono::steady_clock::time_point deadline;
+    };
+
+    void startAccept();
+    void handleUpstreamNotification(const json& note);
+    void handleUpstreamResponse(const json& response);
+    void broadcast(const std::shared_ptr<const std::string>& msg);
+    bool acquirePrefix(uint32_t& prefix);
+    void releasePrefix(uint64_t sessionId, uint32_t prefix);
+    void submitResolved(uint64_t sessionId);
+    void removeSession(uint64_t id);
+    bool forwardSubmit(const std::shared_ptr<Downstream>& session, uint64_t sessionId, const json& downstreamId,
+        const std::string& jobId, const std::string& extranonce2,
+        const std::string& ntime, uint32_t nonce);
+    void scheduleExpiry();
+    void handleUpstreamSubscribed();
+    void handleUpstreamLost();
+
+    StratumClient client_;
+    StratumProxyConfig config_;
+    tcp::acceptor acceptor_;
+    std::unordered_map<uint64_t, std::shared_ptr<Downstream>> sessions_;
+    std::unordered_map<int, PendingSubmit> pendingSubmits_;
+    std::unordered_map<uint64_t, std::size_t> pendingPerSession_;
+    // Prefixos de rigs desconectados com submits ainda em voo: só voltam para
+    // freePrefixes_ quando o último deles for respondido ou expirar.
+    std::unordered_map<uint64_t, uint32_t> drainingPrefixes_;
+    boost::asio::steady_timer expiryTimer_;
+    std::vector<uint32_t> freePrefixes_;
+    uint32_t nextPrefix_ = 0;
+    uint64_t nextSessionId_ = 0;
+    std::shared_ptr<const std::string> lastDifficulty_;
+    std::shared_ptr<const std::string> lastNotify_;
+    bool accepting_ = false;
+    bool failed_ = false;
+};
+
+} // namespace nerdminer
@@ -0,0 +1,60 @@
+/**
+* Project: nerdminer-rpi
+* File: stratum_work_source.h
+* Description: header file for the Stratum pool work source
+*
+* Author: Regis Araujo Melo
+* Date: 2025-04-21
+* Version: 0.1.0
+*
+* MIT License
+* © 2025 Regis Araujo Melo
+*/
+
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include "nerdminer/stratum_client.h"
+#include "nerdminer/work_source.h"
+
+namespace nerdminer {
+
+// Pool Stratum V1: mining.notify / mining.set_difficulty viram jobs e
+// dificuldade; shares saem como mining.submit.
+class StratumWorkSource : public WorkSource {
+public:
+    StratumWorkSource(const std::string& host, uint16_t port, const std::string& user, const std::string& password);
+    ~StratumWorkSource() override;
+
+    std::string name() const override;
+    void start() override;
+    void stop() override;
+    void submitShare(const ShareCandidate& share) override;
+    void drain(std::chrono::milliseconds timeout) override;
+    json sessionState() const override;
+    void resumeSession(const json& state) override;
+
+private:
+    void handleNotification(const json& note);
+    void handleResponse(const json& response);
+    void handleSubmitResponse(const json& response);
+
+    std::string host_;
+    uint16_t port_;
+    StratumClient client_;
+    std::thread io_;
+    std::string resumeExtranonce1_;
+    std::mutex submitMutex_;
+    std::condition_variable submitCv_;
+    std::unordered_map<int, std::chrono::steady_clock::time_point> pendingSubmits_;
+    // extranonce1 da sessão atual (vazio desconectado); shares de outra sessão são descartados.
+    std::string liveExtranonce1_;
+    const uint64_t traceScope_;
+};
+
+} // namespace nerdminer
@@ -0,0 +1,108 @@
+/**
+* Project: nerdminer-rpi
+* File: sv2_client.h
+* Description: header file for the Stratum V2 (binary framing, standard channel) client
+*
+* Author: Regis Araujo Melo
+* Date: 2025-04-21
+* Version: 0.1.0
+*
+* MIT License
+* © 2025 Regis Araujo Melo
+*/
+
+#pragma once
+
+#include <nerdminer/sv2_codec.h>
+#include <boost/asio.hpp>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace nerdminer {
+
+// Cliente Stratum V2 sem criptografia (Noise fica de fora): faz o
+// SetupConnection e abre um canal padrão; as demais mensagens do canal
+// (jobs, prevhash, alvo, respostas de submit) vão para onMessage.
+// Mesmo modelo de threads do StratumClient: tudo roda em listen().
+// Se a conexão cair, reconecta sozinho com espera crescente (1 s a 60 s) e
+// abre um canal novo.
+class Sv2Client {
+public:
+    using tcp = boost::asio::ip::tcp;
+
+    Sv2Client(const std::string& host, uint16_t port, const std::string& user);
+    ~Sv2Client();
+    // Conecta e enfileira o SetupConnection; o canal abre sozinho na sequência.
+    void connect();
+    void listen();
+    // Fecha a conexão sem reconectar; só com listen() parado.
+    void disconnect();
+    // Pode ser chamado de qualquer thread.
+    void send(std::vector<uint8_t> frame);
+    // Devolve o número de sequência usado no submit.
+    uint32_t submitShare(uint32_t jobId, uint32_t nonce, uint32_t ntime, uint32_t version);
+
+    std::function<void(const sv2::FrameHeader&, sv2::Reader&)> onMessage;
+    // Chamado quando o OpenStandardMiningChannel.Success chega.
+    std::function<void()> onChannelOpened;
+    // Chamado na thread de IO quando a conexão cai, antes de reconectar.
+    std::function<void()> onDisconnected;
+
+    boost::asio::io_context& ioContext() { return ioContext_; }
+    bool channelOpen() const { return channelOpen_; }
+    uint32_t channelId() const { return channelId_; }
+    // Mensagens de canal podem vir endereçadas ao canal ou ao grupo dele.
+    bool isOurChannel(uint32_t channelId) const {
+        return channelOpen_ && (channelId == channelId_ || (groupChannelId_ != 0 && channelId == groupChannelId_));
+    }
+    const std::vector<uint8_t>& initialTarget() const { return target_; }
+    uint64_t lastReadTimestamp() const { return lastReadNs_; }
+    uint64_t bytesRead() const { return bytesRead_; }
+    uint64_t bytesWritten() const { return bytesWritten_; }
+
+private:
+    void doReadHeader();
+    void doReadPayload();
+    void dispatch();
+    void doWrite();
+    void openChannel();
+    void sendSetup();
+    void connectionLost(const std::string& reason);
+    void scheduleReconnect();
+
+    boost::asio::io_context ioContext_;
+    tcp::socket socket_;
+    std::string host_;
+    uint16_t port_;
+    std::string user_;
+
+    std::array<uint8_t, sv2::kFrameHeaderSize> headerBuf_{};
+    sv2::FrameHeader header_;
+    std::vector<uint8_t> payload_;
+    uint64_t lastReadNs_ = 0;
+
+    std::atomic<bool> channelOpen_{false};
+    std::atomic<uint32_t> channelId_{0};
+    std::atomic<uint32_t> groupChannelId_{0};
+    std::vector<uint8_t> target_;
+    std::atomic<uint32_t> sequence_{0};
+    std::atomic<uint64_t> bytesRead_{0};
+    std::atomic<uint64_t> bytesWritten_{0};
+
+    // Frames enfileirados saem juntos na próxima escrita, como no StratumClient.
+    std::deque<std::vector<uint8_t>> writeQueue_;
+    std::vector<std::vector<uint8_t>> inFlight_;
+    bool writing_ = false;
+    // Só na thread de IO: frames enviados sem conexão são descartados.
+    bool connected_ = false;
+
+    boost::asio::steady_timer reconnectTimer_;
+    std::chrono::seconds reconnectDelay_{1};
+};
+
+} // namespace nerdminer
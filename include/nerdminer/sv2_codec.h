@@ -0,0 +1,213 @@
+/**
+* Project: nerdminer-rpi
+* File: sv2_codec.h
+* Description: header file for Stratum V2 binary framing and mining messages (standard channel)
+*
+* Author: Regis Araujo Melo
+* Date: 2025-04-21
+* Version: 0.1.0
+*
+* MIT License
+* © 2025 Regis Araujo Melo
+*/
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace nerdminer {
+namespace sv2 {
+
+// Frame: extension_type (U16) | msg_type (U8) | msg_length (U24) | payload,
+// tudo little-endian. O bit mais alto de extension_type marca mensagens de canal.
+constexpr std::size_t kFrameHeaderSize = 6;
+constexpr uint16_t kChannelMsgBit = 0x8000;
+constexpr uint32_t kMaxPayloadSize = 1 << 16;
+constexpr uint16_t kProtocolVersion = 2;
+constexpr uint8_t kMiningProtocol = 0;
+
+using U256 = std::array<uint8_t, 32>; // little-endian, como no fio
+
+enum MsgType : uint8_t {
+    kSetupConnection = 0x00,
+    kSetupConnectionSuccess = 0x01,
+    kSetupConnectionError = 0x02,
+    kOpenStandardMiningChannel = 0x10,
+    kOpenStandardMiningChannelSuccess = 0x11,
+    kOpenMiningChannelError = 0x12,
+    kNewMiningJob = 0x15,
+    kSubmitSharesStandard = 0x1a,
+    kSubmitSharesSuccess = 0x1c,
+    kSubmitSharesError = 0x1d,
+    kSetNewPrevHash = 0x20,
+    kSetTarget = 0x21,
+};
+
+struct FrameHeader {
+    uint16_t extensionType = 0;
+    uint8_t msgType = 0;
+    uint32_t length = 0;
+};
+
+FrameHeader parseFrameHeader(const uint8_t* data);
+
+// Serialização dos tipos do protocolo. Reader lança std::invalid_argument
+// se a mensagem terminar antes do esperado.
+class Writer {
+public:
+    void u8(uint8_t v) { buf_.push_back(v); }
+    void u16(uint16_t v);
+    void u32(uint32_t v);
+    void u64(uint64_t v);
+    void f32(float v);
+    void u256(const U256& v) { buf_.insert(buf_.end(), v.begin(), v.end()); }
+    void str0_255(const std::string& s);
+    void b0_32(const std::vector<uint8_t>& b);
+    // Empacota o payload acumulado em um frame completo.
+    std::vector<uint8_t> frame(uint8_t msgType, bool channelMsg) const;
+
+private:
+    std::vector<uint8_t> buf_;
+};
+
+class Reader {
+public:
+    Reader(const uint8_t* data, std::size_t size) : data_(data), size_(size) {}
+    uint8_t u8();
+    uint16_t u16();
+    uint32_t u32();
+    uint64_t u64();
+    float f32();
+    U256 u256();
+    std::string str0_255();
+    std::vector<uint8_t> b0_32();
+    bool done() const { return pos_ == size_; }
+
+private:
+    const uint8_t* take(std::size_t n);
+    const uint8_t* data_;
+    std::size_t size_;
+    std::size_t pos_ = 0;
+};
+
+struct SetupConnection {
+    uint8_t protocol = kMiningProtocol;
+    uint16_t minVersion = kProtocolVersion;
+    uint16_t maxVersion = kProtocolVersion;
+    uint32_t flags = 0;
+    std::string endpointHost;
+    uint16_t endpointPort = 0;
+    std::string vendor;
+    std::string hardwareVersion;
+    std::string firmware;
+    std::string deviceId;
+    std::vector<uint8_t> encode() const;
+    static SetupConnection decode(Reader& r);
+};
+
+struct SetupConnectionSuccess {
+    uint16_t usedVersion = kProtocolVersion;
+    uint32_t flags = 0;
+    std::vector<uint8_t> encode() const;
+    static SetupConnectionSuccess decode(Reader& r);
+};
+
+struct SetupConnectionError {
+    uint32_t flags = 0;
+    std::string errorCode;
+    std::vector<uint8_t> encode() const;
+    static SetupConnectionError decode(Reader& r);
+};
+
+struct OpenStandardMiningChannel {
+    uint32_t requestId = 0;
+    std::string userIdentity;
+    float nominalHashRate = 0;
+    U256 maxTarget{};
+    std::vector<uint8_t> encode() const;
+    static OpenStandardMiningChannel decode(Reader& r);
+};
+
+struct OpenStandardMiningChannelSuccess {
+    uint32_t requestId = 0;
+    uint32_t channelId = 0;
+    U256 target{};
+    std::vector<uint8_t> extranoncePrefix;
+    uint32_t groupChannelId = 0;
+    std::vector<uint8_t> encode() const;
+    static OpenStandardMiningChannelSuccess decode(Reader& r);
+};
+
+struct OpenMiningChannelError {
+    uint32_t requestId = 0;
+    std::string errorCode;
+    std::vector<uint8_t> encode() const;
+    static OpenMiningChannelError decode(Reader& r);
+};
+
+struct NewMiningJob {
+    uint32_t channelId = 0;
+    uint32_t jobId = 0;
+    bool hasMinNtime = false; // sem min_ntime = job futuro, ativado por SetNewPrevHash
+    uint32_t minNtime = 0;
+    uint32_t version = 0;
+    std::array<uint8_t, 32> merkleRoot{};
+    std::vector<uint8_t> encode() const;
+    static NewMiningJob decode(Reader& r);
+};
+
+struct SetNewPrevHash {
+    uint32_t channelId = 0;
+    uint32_t jobId = 0;
+    U256 prevHash{};
+    uint32_t minNtime = 0;
+    uint32_t nbits = 0;
+    std::vector<uint8_t> encode() const;
+    static SetNewPrevHash decode(Reader& r);
+};
+
+struct SetTarget {
+    uint32_t channelId = 0;
+    U256 maximumTarget{};
+    std::vector<uint8_t> encode() const;
+    static SetTarget decode(Reader& r);
+};
+
+struct SubmitSharesStandard {
+    uint32_t channelId = 0;
+    uint32_t sequenceNumber = 0;
+    uint32_t jobId = 0;
+    uint32_t nonce = 0;
+    uint32_t ntime = 0;
+    uint32_t version = 0;
+    std::vector<uint8_t> encode() const;
+    static SubmitSharesStandard decode(Reader& r);
+};
+
+struct SubmitSharesSuccess {
+    uint32_t channelId = 0;
+    uint32_t lastSequenceNumber = 0;
+    uint32_t newSubmitsAcceptedCount = 0;
+    uint64_t newSharesSum = 0;
+    std::vector<uint8_t> encode() const;
+    static SubmitSharesSuccess decode(Reader& r);
+};
+
+struct SubmitSharesError {
+    uint32_t channelId = 0;
+    uint32_t sequenceNumber = 0;
+    std::string errorCode;
+    std::vector<uint8_t> encode() const;
+    static SubmitSharesError decode(Reader& r);
+};
+
+// Alvos: o protocolo usa U256 little-endian; o miner usa 32 bytes big-endian.
+U256 toU256(const std::vector<uint8_t>& bigEndian);
+std::vector<uint8_t> fromU256(const U256& value);
+
+} // namespace sv2
+} // namespace nerdminer
@@ -0,0 +1,70 @@
+/**
+* Project: nerdminer-rpi
+* File: sv2_work_source.h
+* Description: header file for the Stratum V2 (standard channel) pool work source
+*
+* Author: Regis Araujo Melo
+* Date: 2025-04-21
+* Version: 0.1.0
+*
+* MIT License
+* © 2025 Regis Araujo Melo
+*/
+
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include "nerdminer/sv2_client.h"
+#include "nerdminer/work_source.h"
+
+namespace nerdminer {
+
+// Pool Stratum V2 em canal padrão: o pool manda raiz Merkle e alvo prontos
+// (NewMiningJob + SetNewPrevHash + SetTarget), então o job chega sem
+// coinbase nem hex para decodificar; shares saem como SubmitSharesStandard.
+class Sv2WorkSource : public WorkSource {
+public:
+    Sv2WorkSource(const std::string& host, uint16_t port, const std::string& user);
+    ~Sv2WorkSource() override;
+
+    std::string name() const override;
+    void start() override;
+    void stop() override;
+    void submitShare(const ShareCandidate& share) override;
+    void drain(std::chrono::milliseconds timeout) override;
+
+    uint64_t bytesRead() const { return client_.bytesRead(); }
+    uint64_t bytesWritten() const { return client_.bytesWritten(); }
+
+private:
+    void handleMessage(const sv2::FrameHeader& header, sv2::Reader& reader);
+    void activate(const sv2::NewMiningJob& job, uint32_t ntime, bool clean);
+
+    std::string host_;
+    uint16_t port_;
+    Sv2Client client_;
+    std::thread io_;
+
+    // Estado do canal; só tocado na thread de IO.
+    std::map<uint32_t, sv2::NewMiningJob> futureJobs_;
+    bool hasPrevHash_ = false;
+    sv2::SetNewPrevHash prevHash_;
+    std::vector<uint8_t> target_;
+    MiningJob current_;
+
+    std::mutex submitMutex_;
+    std::condition_variable submitCv_;
+    std::map<uint32_t, std::chrono::steady_clock::time_point> pendingSubmits_;
+    // Jobs válidos do prevhash atual nesta conexão (id -> raiz Merkle), para
+    // descartar shares de jobs obsoletos ou da conexão anterior.
+    std::map<uint32_t, std::string> channelJobs_;
+    const uint64_t traceScope_;
+};
+
+} // namespace nerdminer
@@ -0,0 +1,65 @@
+/**
+* Project: nerdminer-rpi
+* File: trace.h
+* Description: header file for job-lifecycle tracing (Chrome trace / Perfetto JSON)
+*
+* Author: Regis Araujo Melo
+* Date: 2025-04-21
+* Version: 0.1.0
+*
+* MIT License
+* © 2025 Regis Araujo Melo
+*/
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+namespace nerdminer {
+
+extern std::atomic<bool> gTraceEnabled;
+
+inline bool traceEnabled() {
+    return gTraceEnabled.load(std::memory_order_relaxed);
+}
+
+void traceEnable(std::size_t maxEventsPerThread = 1 << 16);
+void traceSetThreadName(const std::string& name);
+uint64_t traceNow();
+
+// Eventos do formato Chrome trace: "X" (span), "i" (instantâneo),
+// "b"/"e" (span assíncrono que pode começar e terminar em threads diferentes).
+// A categoria de cada evento é o prefixo do nome até o primeiro '.'
+// ("job", "share", "stratum"...). Begin/end casam por categoria + id; quem
+// numera ids por conta própria (cada fonte de trabalho) passa um scope
+// obtido de traceNewScope() para não colidir com os ids de outra instância.
+void traceComplete(const char* name, uint64_t startNs, uint64_t endNs, uint64_t id = 0);
+void traceInstant(const char* name, uint64_t id = 0);
+void traceAsyncBegin(const char* name, uint64_t id, uint64_t tsNs = 0, uint64_t scope = 0);
+void traceAsyncEnd(const char* name, uint64_t id, uint64_t scope = 0);
+uint64_t traceNewScope();
+
+bool writeTrace(const std::string& path);
+
+// Span com escopo: custa um load atômico quando o trace está desligado.
+class TraceSpan {
+public:
+    explicit TraceSpan(const char* name, uint64_t id = 0)
+        : name_(name), id_(id), start_(traceEnabled() ? traceNow() : 0) {}
+    ~TraceSpan() {
+        if (start_ != 0) {
+            traceComplete(name_, start_, traceNow(), id_);
+        }
+    }
+    TraceSpan(const TraceSpan&) = delete;
+    TraceSpan& operator=(const TraceSpan&) = delete;
+
+private:
+    const char* name_;
+    uint64_t id_;
+    uint64_t start_;
+};
+
+} // namespace nerdminer
@@ -0,0 +1,64 @@
+/**
+* Project: nerdminer-rpi
+* File: work_source.h
+* Description: header file for the work-source interface driven by the miner session
+*
+* Author: Regis Araujo Melo
+* Date: 2025-04-21
+* Version: 0.1.0
+*
+* MIT License
+* © 2025 Regis Araujo Melo
+*/
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+#include "nerdminer/miner_job.h"
+#include "nerdminer/share_verifier.h"
+
+namespace nerdminer {
+
+// De onde vem o trabalho: pool Stratum, nó local, gerador offline...
+// A fonte entrega jobs e mudanças de dificuldade pelos callbacks e recebe
+// de volta os shares já verificados. Os callbacks podem ser chamados de
+// qualquer thread da fonte.
+class WorkSource {
+public:
+    using JobFn = std::function<void(const MiningJob& job, const std::string& extranonce1,
+        std::size_t extranonce2Size, uint64_t receivedNs)>;
+    using DifficultyFn = std::function<void(double difficulty)>;
+    // Alvo de share novo (32 bytes big-endian) que vale já para o job atual.
+    using TargetFn = std::function<void(const std::vector<uint8_t>& shareTarget)>;
+    // O trabalho entregue deixou de valer (conexão perdida) até o próximo onJob.
+    using WorkLostFn = std::function<void()>;
+
+    virtual ~WorkSource() = default;
+
+    virtual std::string name() const = 0;
+    // Conecta e começa a produzir jobs em thread própria; não bloqueia.
+    virtual void start() = 0;
+    virtual void stop() = 0;
+    // Chamado na thread do verificador para cada share aprovado.
+    virtual void submitShare(const ShareCandidate& share) = 0;
+    // Espera, até o limite, as respostas dos shares já enviados. Fontes que
+    // submetem de forma síncrona não têm o que esperar.
+    virtual void drain(std::chrono::milliseconds timeout) { (void)timeout; }
+
+    // Estado para retomar a sessão depois de reiniciar o processo (json nulo =
+    // nada a guardar). sessionState() só é chamado com a fonte parada e
+    // resumeSession() antes de start().
+    virtual json sessionState() const { return json(); }
+    virtual void resumeSession(const json& state) { (void)state; }
+
+    JobFn onJob;
+    DifficultyFn onDifficulty;
+    TargetFn onTarget;
+    WorkLostFn onWorkLost;
+};
+
+} // namespace nerdminer
@@ -0,0 +1,209 @@
+/**
+* Project: nerdminer-rpi
+* File: autotune.cpp
+* Description: picks the fastest kernel variant and batch size per CPU model
+*
+* Author: Regis Araujo Melo
+* Date: 2025-04-21
+* Version: 0.1.0
+*
+* MIT License
+* © 2025 Regis Araujo Melo
+*/
+
+#include "nerdminer/autotune.h"
+#include "nerdminer/benchmark.h"
+#include "nerdminer/hash_kernel.h"
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <sys/stat.h>
+#include <nlohmann/json.hpp>
+
+namespace nerdminer {
+
+using json = nlohmann::json;
+
+/**
+ * Identifica o modelo da CPU pelo /proc/cpuinfo. No x86 vem de "model name";
+ * no Raspberry Pi o campo útil é "Model" (ex.: "Raspberry Pi 4 Model B").
+ * @return O modelo, ou "unknown".
+ */
+std::string cpuModel() {
+    std::ifstream cpuinfo("/proc/cpuinfo");
+    std::string line;
+    std::string modelName;
+    std::string boardModel;
+    std::string cpuPart;
+    while (std::getline(cpuinfo, line)) {
+        auto colon = line.find(':');
+        if (colon == std::string::npos) {
+            continue;
+        }
+        std::string key = line.substr(0, line.find_last_not_of(" \t", colon - 1) + 1);
+        std::string value = colon + 2 <= line.size() ? line.substr(colon + 2) : "";
+        if (key == "model name" && modelName.empty()) {
+            modelName = value;
+        } else if (key == "Model" && boardModel.empty()) {
+            boardModel = value;
+        } else if (key == "CPU part" && cpuPart.empty()) {
+            cpuPart = "CPU part " + value;
+        }
+    }
+    if (!boardModel.empty()) {
+        return boardModel;
+    }
+    if (!modelName.empty()) {
+        return modelName;
+    }
+    return cpuPart.empty() ? "unknown" : cpuPart;
+}
+
+std::string buildId() {
+#ifdef __VERSION__
+    std::string id = __VERSION__;
+#else
+    std::string id = "unknown";
+#endif
+    for (const auto& name : kernelNames()) {
+        id += " " + name;
+    }
+    return id;
+}
+
+std::string defaultTuneCachePath() {
+    if (const char* xdg = std::getenv("XDG_CACHE_HOME")) {
+        return std::string(xdg) + "/nerdminer-rpi/autotune.json";
+    }
+    if (const char* home = std::getenv("HOME")) {
+        return std::string(home) + "/.cache/nerdminer-rpi/autotune.json";
+    }
+    return "autotune.json";
+}
+
+/**
+ * Lê o vencedor salvo para esta CPU.
+ * @return False se não houver cache, se estiver corrompido, se vier de outra
+ *         build ou se o kernel salvo não existir mais nesta build.
+ */
+bool loadTuneResult(const std::string& path, const std::string& cpu, TuneResult& result) {
+    std::ifstream in(path);
+    if (!in) {
+        return false;
+    }
+    json cache = json::parse(in, nullptr, false);
+    if (cache.is_discarded() || !cache.is_object() || !cache.contains(cpu)) {
+        return false;
+    }
+    const json& entry = cache[cpu];
+    if (!entry.is_object() || !entry.contains("kernel") || !entry["kernel"].is_string()
+        || !entry.contains("batchSize") || !entry["batchSize"].is_number_unsigned()
+        || entry.value("build", "") != buildId()) {
+        return false;
+    }
+    result.kernel = entry["kernel"].get<std::string>();
+    result.batchSize = entry["batchSize"].get<uint32_t>();
+    result.hashrate = entry.value("hashrate", 0.0);
+    return result.batchSize > 0 && makeKernel(result.kernel) != nullptr;
+}
+
+bool saveTuneResult(const std::string& path, const std::string& cpu, const TuneResult& result) {
+    json cache = json::object();
+    {
+        std::ifstream in(path);
+        if (in) {
+            json existing = json::parse(in, nullptr, false);
+            if (!existing.is_discarded() && existing.is_object()) {
+                cache = existing;
+            }
+        }
+    }
+    cache[cpu] = {
+        {"kernel", result.kernel},
+        {"batchSize", result.batchSize},
+        {"hashrate", result.hashrate},
+        {"build", buildId()}
+    };
+
+    // Cria os diretórios intermediários (~/.cache/nerdminer-rpi)
+    for (std::size_t pos = path.find('/', 1); pos != std::string::npos; pos = path.find('/', pos + 1)) {
+        ::mkdir(path.substr(0, pos).c_str(), 0755);
+    }
+    std::ofstream out(path);
+    if (!out) {
+        return false;
+    }
+    out << cache.dump(2) << "\n";
+    return static_cast<bool>(out);
+}
+
+/**
+ * Mede cada variante com um lote fixo e depois varia o lote só para a
+ * vencedora. Kernels que divergem da referência são descartados.
+ * @param secondsPerRun Duração de cada medição.
+ * @return A melhor combinação kernel + tamanho de lote.
+ */
+TuneResult autotune(double secondsPerRun) {
+    std::cout << "Autotuning hashing kernels for " << cpuModel() << "..." << std::endl;
+    TuneResult best;
+    for (const auto& name : kernelNames()) {
+        if (name == "reference") {
+            continue;
+        }
+        auto kernel = makeKernel(name);
+        KernelBenchResult r = benchmarkKernel(*kernel, secondsPerRun, 4096);
+        // Formata numa stream local para não deixar std::fixed no std::cout
+        std::ostringstream line;
+        line << "  " << std::left << std::setw(16) << name << std::right
+             << std::fixed << std::setprecision(0) << r.hashrate << " H/s"
+             << (r.agreesWithReference ? "" : " (rejected: mismatch)");
+        std::cout << line.str() << std::endl;
+        if (r.agreesWithReference && r.hashrate > best.hashrate) {
+            best.kernel = name;
+            best.batchSize = 4096;
+            best.hashrate = r.hashrate;
+        }
+    }
+    if (best.kernel.empty()) {
+        best.kernel = "openssl";
+        best.batchSize = 4096;
+        return best;
+    }
+
+    auto kernel = makeKernel(best.kernel);
+    for (uint32_t batchSize : {1024u, 16384u, 65536u}) {
+        KernelBenchResult r = benchmarkKernel(*kernel, secondsPerRun, batchSize);
+        if (r.hashrate > best.hashrate) {
+            best.batchSize = batchSize;
+            best.hashrate = r.hashrate;
+        }
+    }
+    std::ostringstream line;
+    line << "Autotune winner: " << best.kernel << " (batch " << best.batchSize << ", "
+         << std::fixed << std::setprecision(0) << best.hashrate << " H/s per thread)";
+    std::cout << line.str() << std::endl;
+    return best;
+}
+
+/**
+ * Usa o resultado salvo para esta CPU; só roda o autotuner se não houver
+ * cache válido ou se forceRetune for true.
+ */
+TuneResult resolveTuning(const std::string& cachePath, bool forceRetune) {
+    const std::string cpu = cpuModel();
+    TuneResult result;
+    if (!forceRetune && loadTuneResult(cachePath, cpu, result)) {
+        std::cout << "Using tuned kernel " << result.kernel << " (batch " << result.batchSize
+                  << ") from " << cachePath << std::endl;
+        return result;
+    }
+    result = autotune(0.25);
+    if (!saveTuneResult(cachePath, cpu, result)) {
+        std::cerr << "Warning: could not write autotune cache " << cachePath << std::endl;
+    }
+    return result;
+}
+
+} // namespace nerdminer
@@ -0,0 +1,119 @@
+/**
+* Project: nerdminer-rpi
+* File: benchmark.cpp
+* Description: offline benchmark of the hashing kernels
+*
+* Author: Regis Araujo Melo
+* Date: 2025-04-21
+* Version: 0.1.0
+*
+* MIT License
+* © 2025 Regis Araujo Melo
+*/
+
+#include "nerdminer/benchmark.h"
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <sstream>
+
+namespace nerdminer {
+
+/**
+ * Template fixo para que os resultados sejam comparáveis entre execuções.
+ */
+HeaderTemplate makeBenchmarkTemplate() {
+    BlockHeader header;
+    header.version = 0x20000000;
+    header.prevHash = "00000000000000000002a7c4c1e48d76c5a37902165a270156b7a8d72728a054";
+    header.merkleRoot = "4a5e1e4baab89f3a32518a88c31bc87f618f76673e2cc77ab2127b7afdeda33b";
+    header.timestamp = 0x5f5e1000;
+    header.bits = 0x1d00ffff;
+    header.nonce = 0;
+    return HeaderTemplate::fromHeader(header);
+}
+
+/**
+ * Com alvo máximo todo nonce vira hit, então dá para comparar cada hash do
+ * kernel com o do caminho de referência.
+ * @return True se os hashes forem idênticos para os count primeiros nonces.
+ */
+bool checkKernelAgainstReference(HashKernel& kernel, const HeaderTemplate& tmpl, uint32_t count) {
+    Target any;
+    any.fill(0xFF);
+    auto reference = makeKernel("reference");
+    std::vector<HashHit> expected;
+    std::vector<HashHit> actual;
+    reference->hashHeaders(tmpl, 0, count, any, expected);
+    kernel.hashHeaders(tmpl, 0, count, any, actual);
+    if (expected.size() != actual.size()) {
+        return false;
+    }
+    for (std::size_t i = 0; i < expected.size(); ++i) {
+        if (expected[i].nonce != actual[i].nonce || expected[i].hash != actual[i].hash) {
+            return false;
+        }
+    }
+    return true;
+}
+
+KernelBenchResult benchmarkKernel(HashKernel& kernel, double seconds, uint32_t batchSize, bool perf) {
+    KernelBenchResult result;
+    result.kernel = kernel.name();
+    HeaderTemplate tmpl = makeBenchmarkTemplate();
+    result.agreesWithReference = checkKernelAgainstReference(kernel, tmpl, 64);
+
+    Target none{}; // alvo zero: nenhum hit, mede só o laço de hash
+    std::vector<HashHit> hits;
+    uint32_t nonce = 0;
+    std::unique_ptr<PerfCounters> counters;
+    if (perf) {
+        counters = std::make_unique<PerfCounters>();
+        counters->begin();
+    }
+    auto start = std::chrono::steady_clock::now();
+    auto deadline = start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+        std::chrono::duration<double>(seconds));
+    while (std::chrono::steady_clock::now() < deadline) {
+        result.hashes += kernel.hashHeaders(tmpl, nonce, batchSize, none, hits);
+        nonce += batchSize;
+        hits.clear();
+    }
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    if (counters) {
+        counters->end();
+        result.perf = counters->take();
+    }
+    result.hashrate = result.hashes / result.seconds;
+    return result;
+}
+
+/**
+ * Modo --benchmark: roda cada kernel numa thread, sem rede.
+ * @param perf Mostra também os contadores de hardware (--perf).
+ * @return 0 se todos os kernels concordarem com a referência.
+ */
+int runBenchmark(double secondsPerKernel, bool perf) {
+    int status = 0;
+    std::cout << "Benchmarking hashing kernels (" << secondsPerKernel << "s each, single thread)\n";
+    for (const auto& name : kernelNames()) {
+        auto kernel = makeKernel(name);
+        uint32_t batchSize = name == "reference" ? 1024 : 16384;
+        KernelBenchResult r = benchmarkKernel(*kernel, secondsPerKernel, batchSize, perf);
+        std::ostringstream line;
+        line << std::left << std::setw(12) << r.kernel
+             << std::right << std::setw(14) << std::fixed << std::setprecision(0) << r.hashrate << " H/s"
+             << (r.agreesWithReference ? "" : "  \033[1;31mMISMATCH vs reference\033[0m");
+        std::cout << line.str() << std::endl;
+        if (perf) {
+            printPerfLine(std::cout, r.kernel, r.perf, r.hashes);
+        }
+        if (!r.agreesWithReference) {
+            status = 1;
+        }
+    }
+    return status;
+}
+
+} // namespace nerdminer
@@ -0,0 +1,156 @@
+/**
+* Project: nerdminer-rpi
+* File: hex.cpp
+* Description: table-driven hex encode/decode
+*
+* Author: Regis Araujo Melo
+* Date: 2025-04-21
+* Version: 0.1.0
+*
+* MIT License
+* © 2025 Regis Araujo Melo
+*/
+
+#include "nerdminer/hex.h"
+#include <cstring>
+#include <stdexcept>
+
+namespace nerdminer {
+
+namespace {
+
+    // 0x00-0x0F para dígitos válidos, 0x80 para qualquer outro caractere.
+    struct DecodeTable {
+        uint8_t values[256];
+        constexpr DecodeTable() : values() {
+            for (int i = 0; i < 256; ++i) {
+                values[i] = 0x80;
+            }
+            for (int i = 0; i < 10; ++i) {
+                values['0' + i] = static_cast<uint8_t>(i);
+            }
+            for (int i = 0; i < 6; ++i) {
+                values['a' + i] = static_cast<uint8_t>(10 + i);
+                values['A' + i] = static_cast<uint8_t>(10 + i);
+            }
+        }
+    };
+
+    // Os dois caracteres de cada byte, em minúsculas.
+    struct EncodeTable {
+        char pairs[512];
+        constexpr EncodeTable() : pairs() {
+            const char digits[] = "0123456789abcdef";
+            for (int i = 0; i < 256; ++i) {
+                pairs[2 * i] = digits[i >> 4];
+                pairs[2 * i + 1] = digits[i & 0x0F];
+            }
+        }
+    };
+
+    constexpr DecodeTable kDecode;
+    constexpr EncodeTable kEncode;
+
+} // namespace
+
+/**
+ * Converte bytes para hexadecimal.
+ * @param data Bytes de entrada.
+ * @param size Quantidade de bytes.
+ * @param out Destino com espaço para 2 * size caracteres (sem terminador).
+ */
+void encodeHex(const uint8_t* data, std::size_t size, char* out) {
+    for (std::size_t i = 0; i < size; ++i) {
+        std::memcpy(out + 2 * i, &kEncode.pairs[2 * data[i]], 2);
+    }
+}
+
+std::string encodeHex(const uint8_t* data, std::size_t size) {
+    std::string out(2 * size, '\0');
+    encodeHex(data, size, &out[0]);
+    return out;
+}
+
+/**
+ * Converte hexadecimal para bytes. A validação é acumulada sem desvios e
+ * checada só no fim, já que entrada inválida é exceção.
+ * @param hex Texto hexadecimal; deve ter exatamente 2 * outSize caracteres.
+ * @param out Destino.
+ * @param outSize Tamanho do destino.
+ * @return False se o tamanho não bater ou houver caractere inválido.
+ */
+bool decodeHex(std::string_view hex, uint8_t* out, std::size_t outSize) {
+    if (hex.size() != 2 * outSize) {
+        return false;
+    }
+    const auto* in = reinterpret_cast<const unsigned char*>(hex.data());
+    uint8_t bad = 0;
+    for (std::size_t i = 0; i < outSize; ++i) {
+        uint8_t hi = kDecode.values[in[2 * i]];
+        uint8_t lo = kDecode.values[in[2 * i + 1]];
+        bad |= hi | lo;
+        out[i] = static_cast<uint8_t>((hi << 4) | (lo & 0x0F));
+    }
+    return (bad & 0x80) == 0;
+}
+
+/**
+ * Versão com alocação, para os chamadores que precisam de um vetor.
+ * @throws std::invalid_argument se a entrada não for hexadecimal válido.
+ */
+std::vector<uint8_t> decodeHex(std::string_view hex) {
+    if (hex.size() % 2 != 0) {
+        throw std::invalid_argument("hex string has odd length");
+    }
+    std::vector<uint8_t> bytes(hex.size() / 2);
+    if (!decodeHex(hex, bytes.data(), bytes.size())) {
+        throw std::invalid_argument("invalid hex string");
+    }
+    return bytes;
+}
+
+bool isHex(std::string_view hex, std::size_t expectedBytes) {
+    if (hex.size() % 2 != 0) {
+        return false;
+    }
+    if (expectedBytes != std::string_view::npos && hex.size() != 2 * expectedBytes) {
+        return false;
+    }
+    uint8_t bad = 0;
+    for (unsigned char c : hex) {
+        bad |= kDecode.values[c];
+    }
+    return (bad & 0x80) == 0;
+}
+
+/**
+ * Escreve um uint32 como 8 caracteres hexadecimais (big-endian, como o Stratum).
+ */
+void encodeHexU32(uint32_t value, char* out) {
+    const uint8_t bytes[4] = {
+        static_cast<uint8_t>(value >> 24), static_cast<uint8_t>(value >> 16),
+        static_cast<uint8_t>(value >> 8), static_cast<uint8_t>(value)
+    };
+    encodeHex(bytes, 4, out);
+}
+
+std::string hexU32(uint32_t value) {
+    std::string out(8, '\0');
+    encodeHexU32(value, &out[0]);
+    return out;
+}
+
+/**
+ * Lê exatamente 8 caracteres hexadecimais como uint32 big-endian.
+ * @return False se a entrada não tiver 8 dígitos hexadecimais.
+ */
+bool parseHexU32(std::string_view hex, uint32_t& value) {
+    uint8_t bytes[4];
+    if (!decodeHex(hex, bytes, 4)) {
+        return false;
+    }
+    value = (uint32_t(bytes[0]) << 24) | (uint32_t(bytes[1]) << 16) | (uint32_t(bytes[2]) << 8) | bytes[3];
+    return true;
+}
+
+} // namespace nerdminer
@@ -0,0 +1,193 @@
+/**
+* Project: nerdminer-rpi
+* File: hash_kernel.cpp
+* Description: batched SHA-256d kernels (reference, OpenSSL, portable variants)
+*
+* Author: Regis Araujo Melo
+* Date: 2025-04-21
+* Version: 0.1.0
+*
+* MIT License
+* © 2025 Regis Araujo Melo
+*/
+
+#include "nerdminer/hash_kernel.h"
+#include "nerdminer/sha256.h"
+#include "nerdminer/sha256d_kernel.h"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <openssl/evp.h>
+
+namespace nerdminer {
+
+/**
+ * Serializa o cabeçalho e pré-calcula o estado após os primeiros 64 bytes,
+ * que não dependem do nonce.
+ * @param header Cabeçalho do bloco (o nonce é ignorado).
+ * @return O template pronto para os kernels.
+ */
+HeaderTemplate HeaderTemplate::fromHeader(const BlockHeader& header) {
+    HeaderTemplate tmpl;
+    std::vector<uint8_t> bytes = buildBlockHeader(header);
+    if (bytes.size() != tmpl.bytes.size()) {
+        throw std::invalid_argument("block header must serialize to 80 bytes");
+    }
+    std::copy(bytes.begin(), bytes.end(), tmpl.bytes.begin());
+    std::copy(std::begin(kSha256Init), std::end(kSha256Init), tmpl.midstate.begin());
+    sha256Transform(tmpl.midstate.data(), tmpl.bytes.data());
+    return tmpl;
+}
+
+Target makeTarget(uint32_t bits) {
+    return makeTarget(targetFromBits(bits));
+}
+
+Target makeTarget(const std::vector<uint8_t>& expanded) {
+    if (expanded.size() != 32) {
+        throw std::invalid_argument("target must be 32 bytes");
+    }
+    Target target;
+    std::copy(expanded.begin(), expanded.end(), target.begin());
+    return target;
+}
+
+namespace {
+
+// Caminho de referência: buildBlockHeader + doubleSHA256 a cada nonce.
+// Lento, mas é a definição de "correto" usada pelo verificador.
+class ReferenceKernel : public HashKernel {
+public:
+    const char* name() const override { return "reference"; }
+
+    uint64_t hashHeaders(const HeaderTemplate& tmpl, uint32_t nonceStart, uint32_t count,
+        const Target& target, std::vector<HashHit>& hitsOut) override {
+        std::vector<uint8_t> header(tmpl.bytes.begin(), tmpl.bytes.end());
+        for (uint32_t i = 0; i < count; ++i) {
+            uint32_t nonce = nonceStart + i;
+            putHeaderField(header.data() + HeaderTemplate::kNonceOffset, nonce);
+            std::vector<uint8_t> hash = doubleSHA256(header);
+            if (isHashBelowTarget(hash.data(), target.data())) {
+                HashHit hit;
+                hit.nonce = nonce;
+                std::copy(hash.begin(), hash.end(), hit.hash.begin());
+                hitsOut.push_back(hit);
+            }
+        }
+        return count;
+    }
+};
+
+// OpenSSL com contextos reutilizados: o contexto do primeiro bloco é montado
+// uma vez por chamada e copiado a cada nonce, sem new/free no laço.
+class OpenSslKernel : public HashKernel {
+public:
+    OpenSslKernel()
+        : md_(EVP_sha256()),
+        base_(EVP_MD_CTX_new()),
+        work_(EVP_MD_CTX_new()) {
+        if (!base_ || !work_) {
+            throw std::runtime_error("EVP_MD_CTX_new failed");
+        }
+    }
+
+    ~OpenSslKernel() override {
+        EVP_MD_CTX_free(base_);
+        EVP_MD_CTX_free(work_);
+    }
+
+    OpenSslKernel(const OpenSslKernel&) = delete;
+    OpenSslKernel& operator=(const OpenSslKernel&) = delete;
+
+    const char* name() const override { return "openssl"; }
+
+    uint64_t hashHeaders(const HeaderTemplate& tmpl, uint32_t nonceStart, uint32_t count,
+        const Target& target, std::vector<HashHit>& hitsOut) override {
+        EVP_DigestInit_ex(base_, md_, nullptr);
+        EVP_DigestUpdate(base_, tmpl.bytes.data(), 64);
+
+        uint8_t tail[16];
+        std::memcpy(tail, tmpl.bytes.data() + 64, 16);
+        uint8_t hash1[32];
+        HashHit hit;
+        unsigned int len = 0;
+        for (uint32_t i = 0; i < count; ++i) {
+            uint32_t nonce = nonceStart + i;
+            putHeaderField(tail + 12, nonce);
+
+            EVP_MD_CTX_copy_ex(work_, base_);
+            EVP_DigestUpdate(work_, tail, sizeof(tail));
+            EVP_DigestFinal_ex(work_, hash1, &len);
+
+            EVP_DigestInit_ex(work_, md_, nullptr);
+            EVP_DigestUpdate(work_, hash1, sizeof(hash1));
+            EVP_DigestFinal_ex(work_, hit.hash.data(), &len);
+
+            if (isHashBelowTarget(hit.hash.data(), target.data())) {
+                hit.nonce = nonce;
+                hitsOut.push_back(hit);
+            }
+        }
+        return count;
+    }
+
+private:
+    const EVP_MD* md_;
+    EVP_MD_CTX* base_;
+    EVP_MD_CTX* work_;
+};
+
+template <int Lanes, int Unroll>
+std::unique_ptr<HashKernel> makeVariant() {
+    return std::make_unique<Sha256dKernel<Lanes, Unroll>>();
+}
+
+struct KernelEntry {
+    const char* name;
+    std::unique_ptr<HashKernel> (*make)();
+};
+
+// Variantes compiladas do kernel portátil; o autotuner escolhe entre elas.
+// "generic" é apelido da variante escalar sem desenrolar.
+const KernelEntry kVariants[] = {
+    {"sha256d-l1u1", &makeVariant<1, 1>},
+    {"sha256d-l1u8", &makeVariant<1, 8>},
+    {"sha256d-l2u8", &makeVariant<2, 8>},
+    {"sha256d-l4u4", &makeVariant<4, 4>},
+    {"sha256d-l4u8", &makeVariant<4, 8>},
+    {"sha256d-l8u8", &makeVariant<8, 8>},
+    {"sha256d-l4u64", &makeVariant<4, 64>},
+    {"sha256d-l16u8", &makeVariant<16, 8>},
+};
+
+} // namespace
+
+std::vector<std::string> kernelNames() {
+    std::vector<std::string> names;
+    for (const auto& entry : kVariants) {
+        names.push_back(entry.name);
+    }
+    names.push_back("openssl");
+    names.push_back("reference");
+    return names;
+}
+
+std::unique_ptr<HashKernel> makeKernel(const std::string& name) {
+    if (name == "generic") {
+        return makeVariant<1, 1>();
+    }
+    for (const auto& entry : kVariants) {
+        if (name == entry.name) {
+            return entry.make();
+        }
+    }
+    if (name == "openssl") {
+        return std::make_unique<OpenSslKernel>();
+    }
+    if (name == "reference") {
+        return std::make_unique<ReferenceKernel>();
+    }
+    return nullptr;
+}
+
+} // namespace nerdminer
@@ -13,36 +13,217 @@
 
 #include <iostream>
 #include <string>
+#include <vector>
+#include <memory>
 #include "nerdminer/version.h"
 #include "nerdminer/stratum_client.h"
 #include "nerdminer/miner_session.h"
+#include "nerdminer/stratum_proxy.h"
+#include "nerdminer/stratum_work_source.h"
+#include "nerdminer/sv2_work_source.h"
+#include "nerdminer/reference_pool.h"
+#include "nerdminer/gbt_work_source.h"
+#include "nerdminer/offline_work_source.h"
+#include "nerdminer/mock_node.h"
+#include "nerdminer/benchmark.h"
+#include "nerdminer/hash_kernel.h"
+#include "nerdminer/autotune.h"
+#include "nerdminer/trace.h"
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+#include <thread>
+#include <pthread.h>
 
 class NerdMinerApp {
 public:
     bool run(int argc, char** argv) {
-        if (argc > 1) {
-            std::string arg = argv[1];
+        cliArgs.assign(argv + 1, argv + argc);
+        // O arquivo de --config vale como base; a linha de comando vem por cima.
+        for (std::size_t i = 0; i + 1 < cliArgs.size(); ++i) {
+            if (cliArgs[i] == "--config") {
+                configPath = cliArgs[i + 1];
+            }
+        }
+        std::vector<std::string> args;
+        if (!configPath.empty() && !readConfig(configPath, args)) {
+            return false;
+        }
+        args.insert(args.end(), cliArgs.begin(), cliArgs.end());
+        if (!parseArgs(args)) {
+            return false;
+        }
+        if (helpRequested) {
+            printHelp();
+            return true;
+        }
+
+        printBanner();
+        if (benchmarkMode) {
+            return nerdminer::runBenchmark(3.0, perfCounters) == 0;
+        } else if (mockNodeMode) {
+            nerdminer::MockNode(mockNodeConfig).start();
+        } else if (referencePoolMode) {
+            nerdminer::ReferencePool pool(referencePoolConfig);
+            pool.start();
+            for (;;) {
+                std::this_thread::sleep_for(std::chrono::hours(1));
+            }
+        } else if (proxyMode) {
+            return startProxy();
+        } else {
+            return startSession();
+        }
+
+        return true;
+    }
+
+private:
+    // Fonte de trabalho pedida na linha de comando (--pool, --sv2, --solo, --offline).
+    struct SourceSpec {
+        enum Kind { Pool, Sv2, Solo, Offline } kind = Pool;
+        std::string host;
+        uint16_t port = 0;
+        double weight = 1.0;
+    };
+
+    /**
+     * Interpreta as opções (da linha de comando ou do arquivo de --config).
+     * @param args Opções, sem o nome do programa.
+     * @return False se alguma opção for inválida.
+     */
+    bool parseArgs(const std::vector<std::string>& args) {
+        const std::size_t argc = args.size();
+        for (std::size_t i = 0; i < argc; ++i) {
+            const std::string& arg = args[i];
             if (arg == "--help" || arg == "-h") {
-                printHelp();
-                return true;
+                helpRequested = true;
+            } else if (arg == "--config" && i + 1 < argc) {
+                ++i; // já lido em run()
+            } else if (arg == "--threads" && i + 1 < argc) {
+                if (!numberOption(arg, args[++i], 1, 4096, threads)) {
+                    return false;
+                }
+            } else if (arg == "--state" && i + 1 < argc) {
+                statePath = args[++i];
+            } else if (arg == "--benchmark") {
+                benchmarkMode = true;
+            } else if (arg == "--autotune") {
+                forceAutotune = true;
+            } else if (arg == "--kernel" && i + 1 < argc) {
+                kernel = args[++i];
+                if (kernel != "auto" && !nerdminer::makeKernel(kernel)) {
+                    std::cerr << "Error: unknown kernel '" << kernel << "'\n";
+                    return false;
+                }
+            } else if (arg == "--trace" && i + 1 < argc) {
+                tracePath = args[++i];
+            } else if (arg == "--trace-seconds" && i + 1 < argc) {
+                if (!numberOption(arg, args[++i], 1ul, 86400ul, traceSeconds)) {
+                    return false;
+                }
+            } else if (arg == "--perf") {
+                perfCounters = true;
+            } else if (arg == "--ntime-roll" && i + 1 < argc) {
+                if (!numberOption(arg, args[++i], 0u, 7200u, ntimeRoll)) {
+                    return false;
+                }
+            } else if (arg == "--proxy" && i + 1 < argc) {
+                proxyMode = true;
+                if (!numberOption<uint16_t>(arg, args[++i], 1, 65535, proxyConfig.listenPort)) {
+                    return false;
+                }
+            } else if (arg == "--pool" && i + 1 < argc) {
+                SourceSpec spec;
+                spec.kind = SourceSpec::Pool;
+                if (!parseEndpoint(args[++i], spec)) {
+                    return false;
+                }
+                sources.push_back(spec);
+            } else if (arg == "--sv2" && i + 1 < argc) {
+                SourceSpec spec;
+                spec.kind = SourceSpec::Sv2;
+                if (!parseEndpoint(args[++i], spec)) {
+                    return false;
+                }
+                sources.push_back(spec);
+            } else if (arg == "--user" && i + 1 < argc) {
+                user = args[++i];
+            } else if (arg == "--password" && i + 1 < argc) {
+                password = args[++i];
+            } else if (arg == "--solo" && i + 1 < argc) {
+                SourceSpec spec;
+                spec.kind = SourceSpec::Solo;
+                spec.port = soloConfig.port;
+                if (!parseEndpoint(args[++i], spec)) {
+                    return false;
+                }
+                sources.push_back(spec);
+            } else if (arg == "--offline") {
+                SourceSpec spec;
+                spec.kind = SourceSpec::Offline;
+                sources.push_back(spec);
+            } else if (arg == "--rpc-user" && i + 1 < argc) {
+                soloConfig.rpcUser = args[++i];
+            } else if (arg == "--rpc-password" && i + 1 < argc) {
+                soloConfig.rpcPassword = args[++i];
+            } else if (arg == "--address" && i + 1 < argc) {
+                soloConfig.payoutAddress = args[++i];
+            } else if (arg == "--mock-node" && i + 1 < argc) {
+                mockNodeMode = true;
+                if (!numberOption<uint16_t>(arg, args[++i], 1, 65535, mockNodeConfig.port)) {
+                    return false;
+                }
+            } else if (arg == "--reference-pool" && i + 1 < argc) {
+                referencePoolMode = true;
+                std::string spec = args[++i];
+                if (spec.rfind("sv2:", 0) == 0) {
+                    referencePoolConfig.protocol = nerdminer::PoolProtocol::Sv2;
+                    spec = spec.substr(4);
+                } else if (spec.rfind("json:", 0) == 0) {
+                    spec = spec.substr(5);
+                }
+                if (!numberOption<uint16_t>(arg, spec, 1, 65535, referencePoolConfig.port)) {
+                    return false;
+                }
             } else {
                 std::cerr << "Error: unknown argument '" << arg << "'\n\n";
                 printHelp();
                 return false;
             }
         }
-
-        printBanner();
-        startSession();
-        
         return true;
     }
 
-private:
     const std::string host = "public-pool.io";
     const uint16_t port = 21496;
-    const std::string user = "bc1qcdlauj9j9jnxcdlxqkrrus40p7cp9ph6ermkfz.raspberrypi";
-    const std::string password = "x";
+    std::string user = "bc1qcdlauj9j9jnxcdlxqkrrus40p7cp9ph6ermkfz.raspberrypi";
+    std::string password = "x";
+    std::vector<SourceSpec> sources;
+    std::vector<std::string> cliArgs;
+    std::string configPath;
+    std::string statePath = nerdminer::defaultSessionStatePath();
+    int threads = 0; // 0 = uma por núcleo
+    bool helpRequested = false;
+    bool proxyMode = false;
+    bool mockNodeMode = false;
+    bool referencePoolMode = false;
+    bool benchmarkMode = false;
+    bool forceAutotune = false;
+    uint32_t ntimeRoll = 300;
+    bool perfCounters = false;
+    std::string tracePath;
+    unsigned long traceSeconds = 60;
+    std::string kernel = "auto";
+    nerdminer::StratumProxyConfig proxyConfig;
+    nerdminer::SoloConfig soloConfig;
+    nerdminer::MockNodeConfig mockNodeConfig;
+    nerdminer::ReferencePoolConfig referencePoolConfig;
 
     void printBanner() const {
         std::cout << "\033[1;32m====================================\033[0m\n";
@@ -55,13 +236,318 @@ private:
         std::cout << "Usage: " << nerdminer::PROJECT_NAME << " [options]\n\n"
                     << "Options:\n"
                     << "  -h, --help        Show this help message and exit\n"
+                    << "  --config FILE     Read options from FILE (one per line); SIGHUP reloads it\n"
+                    << "  --threads N       Mining threads (default: one per core)\n"
+                    << "  --state FILE      Pool session state for resuming after a restart\n"
+                    << "                    (default: ~/.local/state/nerdminer-rpi/session.json)\n"
+                    << "  --kernel NAME     Hashing kernel (default: auto, see --benchmark for names)\n"
+                    << "  --autotune        Re-run the kernel autotuner and update its cache\n"
+                    << "  --benchmark       Benchmark the hashing kernels offline and exit\n"
+                    << "  --trace FILE      Record job-lifecycle spans and write a Perfetto/Chrome trace\n"
+                    << "  --trace-seconds N Seconds of mining to capture before writing the trace (default: 60)\n"
+                    << "  --perf            Report cycles/hash and IPC from hardware counters\n"
+                    << "  --ntime-roll SEC  Max seconds to roll ntime past the job's (default: 300, 0 disables)\n"
+                    << "  --proxy PORT      Run as a Stratum proxy for local rigs on PORT\n"
+                    << "  --pool HOST:PORT[@W]  Mine on a Stratum pool; repeat to split hashrate by weight W\n"
+                    << "  --sv2 HOST:PORT[@W]   Mine on a Stratum V2 pool (standard channel, unencrypted)\n"
+                    << "  --user USER       Pool worker name\n"
+                    << "  --password PW     Pool worker password\n"
+                    << "  --solo HOST:PORT[@W]  Solo mine against a node's getblocktemplate RPC\n"
+                    << "  --offline         Mine synthetic jobs locally (no network)\n"
+                    << "  --rpc-user USER   Node RPC user (solo mode)\n"
+                    << "  --rpc-password PW Node RPC password (solo mode)\n"
+                    << "  --address ADDR    Payout address for solo blocks (default: pool wallet)\n"
+                    << "  --mock-node PORT  Run a fake node on PORT for testing --solo\n"
+                    << "  --reference-pool [sv2:]PORT  Run a local test pool (JSON, or SV2 with sv2:)\n"
                     << "\n";
     }
 
-    void startSession() {
+    void startTrace() {
+        nerdminer::traceEnable();
+        nerdminer::traceSetThreadName("main");
+        std::thread([path = tracePath, seconds = traceSeconds]() {
+            std::this_thread::sleep_for(std::chrono::seconds(seconds));
+            if (nerdminer::writeTrace(path)) {
+                std::cout << "Trace written to " << path << " (open in https://ui.perfetto.dev)" << std::endl;
+            } else {
+                std::cerr << "Error: could not write trace file " << path << std::endl;
+            }
+        }).detach();
+    }
+
+    template <typename Session>
+    void configureMining(Session& session) {
+        session.setNtimeRoll(ntimeRoll);
+        session.setPerfCounters(perfCounters);
+        if (threads > 0) {
+            session.setThreads(threads);
+        }
+        std::string kernelName;
+        uint32_t batchSize = 0;
+        resolveKernel(forceAutotune, kernelName, batchSize);
+        session.setKernel(kernelName);
+        if (batchSize > 0) {
+            session.setBatchSize(batchSize);
+        }
+    }
+
+    /**
+     * Kernel e lote a usar: o pedido em --kernel ou, em "auto", o do autotune.
+     * @param retune Refaz o autotune em vez de usar o cache.
+     * @param kernelName Recebe o nome do kernel.
+     * @param batchSize Recebe o lote (0 = padrão do engine).
+     */
+    void resolveKernel(bool retune, std::string& kernelName, uint32_t& batchSize) const {
+        if (kernel == "auto" || retune) {
+            nerdminer::TuneResult tuned = nerdminer::resolveTuning(nerdminer::defaultTuneCachePath(), retune);
+            kernelName = tuned.kernel;
+            batchSize = tuned.batchSize;
+        } else {
+            kernelName = kernel;
+            batchSize = 0;
+        }
+    }
+
+    /**
+     * Lê um arquivo de configuração: uma opção por linha, com o mesmo nome da
+     * opção de linha de comando sem os "--" ("pool host:3333@2", "threads 2").
+     * Linhas vazias e começadas por '#' são ignoradas.
+     * @param path Caminho do arquivo.
+     * @param args Recebe as opções no formato da linha de comando.
+     * @return False se o arquivo não puder ser lido.
+     */
+    static bool readConfig(const std::string& path, std::vector<std::string>& args) {
+        std::ifstream in(path);
+        if (!in) {
+            std::cerr << "Error: cannot read config file " << path << std::endl;
+            return false;
+        }
+        std::string line;
+        while (std::getline(in, line)) {
+            const std::size_t begin = line.find_first_not_of(" \t");
+            if (begin == std::string::npos || line[begin] == '#') {
+                continue;
+            }
+            const std::size_t end = line.find_last_not_of(" \t\r");
+            line = line.substr(begin, end - begin + 1);
+            const std::size_t space = line.find_first_of(" \t");
+            args.push_back("--" + line.substr(0, space));
+            if (space != std::string::npos) {
+                args.push_back(line.substr(line.find_first_not_of(" \t", space)));
+            }
+        }
+        return true;
+    }
+
+    /**
+     * Lê um número sem exceções (std::stoi e afins lançam, e na recarga por
+     * SIGHUP isso derrubaria a thread de sinais). O texto inteiro precisa ser
+     * o número e caber em [min, max].
+     * @return False se o texto não for um número válido no intervalo.
+     */
+    template <typename T>
+    static bool parseNumber(const std::string& text, T min, T max, T& value) {
+        T parsed{};
+        const char* end = text.data() + text.size();
+        const auto result = std::from_chars(text.data(), end, parsed);
+        if (text.empty() || result.ec != std::errc() || result.ptr != end || !(parsed >= min && parsed <= max)) {
+            return false;
+        }
+        value = parsed;
+        return true;
+    }
+
+    /**
+     * parseNumber para o valor de uma opção, com a mensagem de erro.
+     * @param option Nome da opção, para a mensagem.
+     */
+    template <typename T>
+    static bool numberOption(const std::string& option, const std::string& text, T min, T max, T& value) {
+        if (!parseNumber(text, min, max, value)) {
+            std::cerr << "Error: invalid value '" << text << "' for " << option
+                      << " (expected " << min << ".." << max << ")\n";
+            return false;
+        }
+        return true;
+    }
+
+    /**
+     * Lê "HOST:PORT[@PESO]"; a porta pode faltar se spec.port já tiver um padrão.
+     */
+    bool parseEndpoint(const std::string& text, SourceSpec& spec) const {
+        std::string endpoint = text;
+        bool ok = true;
+        std::size_t at = endpoint.rfind('@');
+        if (at != std::string::npos) {
+            ok = parseNumber(endpoint.substr(at + 1), 1e-6, 1e6, spec.weight);
+            endpoint = endpoint.substr(0, at);
+        }
+        std::size_t colon = endpoint.rfind(':');
+        if (colon != std::string::npos) {
+            ok = parseNumber<uint16_t>(endpoint.substr(colon + 1), 1, 65535, spec.port) && ok;
+            endpoint = endpoint.substr(0, colon);
+        }
+        spec.host = endpoint;
+        if (!ok || spec.host.empty() || spec.port == 0) {
+            std::cerr << "Error: invalid endpoint '" << text << "' (expected HOST:PORT[@WEIGHT])\n";
+            return false;
+        }
+        return true;
+    }
+
+    std::vector<nerdminer::MinerSession::SourceConfig> buildSources() const {
+        std::vector<SourceSpec> specs = sources;
+        if (specs.empty()) {
+            specs.push_back(SourceSpec{SourceSpec::Pool, host, port, 1.0});
+        }
+        std::vector<nerdminer::MinerSession::SourceConfig> built;
+        for (const auto& spec : specs) {
+            std::unique_ptr<nerdminer::WorkSource> source;
+            if (spec.kind == SourceSpec::Pool) {
+                source = std::make_unique<nerdminer::StratumWorkSource>(spec.host, spec.port, user, password);
+            } else if (spec.kind == SourceSpec::Sv2) {
+                source = std::make_unique<nerdminer::Sv2WorkSource>(spec.host, spec.port, user);
+            } else if (spec.kind == SourceSpec::Solo) {
+                nerdminer::SoloConfig config = soloConfig;
+                config.host = spec.host;
+                config.port = spec.port;
+                if (config.payoutAddress.empty()) {
+                    config.payoutAddress = user.substr(0, user.find('.'));
+                }
+                source = std::make_unique<nerdminer::GbtWorkSource>(config);
+            } else {
+                source = std::make_unique<nerdminer::OfflineWorkSource>();
+            }
+            built.push_back({std::move(source), spec.weight});
+        }
+        return built;
+    }
+
+    /**
+     * SIGHUP: relê o arquivo de --config (mais a linha de comando) e aplica
+     * threads, kernel e lista de fontes na sessão em andamento.
+     */
+    void reload(nerdminer::MinerSession& session) const {
+        if (configPath.empty()) {
+            std::cerr << "SIGHUP ignored: no --config file to reload" << std::endl;
+            return;
+        }
+        std::cout << "Reloading " << configPath << "..." << std::endl;
+        std::vector<std::string> args;
+        if (!readConfig(configPath, args)) {
+            return;
+        }
+        args.insert(args.end(), cliArgs.begin(), cliArgs.end());
+        NerdMinerApp fresh;
+        if (!fresh.parseArgs(args)) {
+            std::cerr << "Config reload failed, keeping the current settings" << std::endl;
+            return;
+        }
+        nerdminer::MinerSession::Reconfiguration config;
+        config.threads = fresh.threads;
+        fresh.resolveKernel(false, config.kernel, config.batchSize);
+        config.sources = fresh.buildSources();
+        session.reconfigure(std::move(config));
+    }
+
+    bool startSession() {
         std::cout << "Starting miner session...\n";
-        nerdminer::MinerSession session(host, port, user, password);
-        session.start();
+        // Sinais bloqueados em todas as threads (herdado pelas criadas depois)
+        // e tratados por sigwait numa thread própria, fora de contexto de sinal.
+        // SIGUSR1 é interno: acorda essa thread para ela sair antes de a sessão
+        // ser destruída.
+        sigset_t signals;
+        sigemptyset(&signals);
+        sigaddset(&signals, SIGINT);
+        sigaddset(&signals, SIGTERM);
+        sigaddset(&signals, SIGHUP);
+        sigaddset(&signals, SIGUSR1);
+        pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+
+        if (!tracePath.empty()) {
+            startTrace();
+        }
+        nerdminer::MinerSession session;
+        for (auto& source : buildSources()) {
+            session.addSource(std::move(source.source), source.weight);
+        }
+        session.setStateFile(statePath);
+        configureMining(session);
+
+        // Um reload em andamento termina antes de start() devolver a sessão;
+        // depois de finished nenhum outro começa.
+        std::mutex reloadMutex;
+        bool finished = false;
+        std::thread signalThread([this, &session, &reloadMutex, &finished, signals]() {
+            nerdminer::traceSetThreadName("signals");
+            bool stopping = false;
+            for (;;) {
+                int sig = 0;
+                if (sigwait(&signals, &sig) != 0) {
+                    continue;
+                }
+                if (sig == SIGUSR1) {
+                    // Um SIGUSR1 de fora não tira os outros sinais de serviço.
+                    std::lock_guard<std::mutex> lock(reloadMutex);
+                    if (finished) {
+                        return;
+                    }
+                    continue;
+                }
+                if (sig == SIGHUP) {
+                    std::lock_guard<std::mutex> lock(reloadMutex);
+                    if (!stopping && !finished) {
+                        try {
+                            reload(session);
+                        } catch (const std::exception& e) {
+                            std::cerr << "Config reload failed: " << e.what() << std::endl;
+                        }
+                    }
+                } else if (!stopping) {
+                    stopping = true;
+                    std::cout << "Received " << strsignal(sig) << ", stopping (again to force)" << std::endl;
+                    session.stop();
+                } else {
+                    std::cerr << "Forced exit" << std::endl;
+                    std::_Exit(1);
+                }
+            }
+        });
+
+        bool ok = true;
+        try {
+            session.start();
+        } catch (const std::exception& e) {
+            std::cerr << "Error: " << e.what() << std::endl;
+            ok = false;
+        }
+        {
+            std::lock_guard<std::mutex> lock(reloadMutex);
+            finished = true;
+        }
+        pthread_kill(signalThread.native_handle(), SIGUSR1);
+        signalThread.join();
+        return ok;
+    }
+
+    /**
+     * Modo proxy: o upstream é o único --pool informado, ou o pool embutido.
+     * @return False se as fontes pedidas não servirem de upstream.
+     */
+    bool startProxy() {
+        std::string upstreamHost = host;
+        uint16_t upstreamPort = port;
+        if (!sources.empty()) {
+            if (sources.size() > 1 || sources[0].kind != SourceSpec::Pool) {
+                std::cerr << "Error: --proxy takes at most one --pool as its upstream\n";
+                return false;
+            }
+            upstreamHost = sources[0].host;
+            upstreamPort = sources[0].port;
+        }
+        std::cout << "Starting Stratum proxy...\n";
+        nerdminer::StratumProxy proxy(upstreamHost, upstreamPort, user, password, proxyConfig);
+        return proxy.start();
     }
 };
 
@@ -25,17 +25,22 @@
 */
 
 #include "nerdminer/miner_job.h"
+#include "nerdminer/hex.h"
+#include "nerdminer/trace.h"
+#include <array>
 #include <iostream>
+#include <stdexcept>
 #include <nlohmann/json.hpp> // Certifique-se de incluir o cabeçalho correto
 
 namespace nerdminer {
 
 MiningJob MiningJob::fromNotification(const json& note) {
+    TraceSpan span("job.parse");
     MiningJob job;
 
     // Verifica se o campo 'method' existe e é 'mining.notify'
     if (note.contains("method") && note["method"] == "mining.notify") {
-        auto params = note["params"];
+        const json params = note.value("params", json());
 
         // Verifica se 'params' é um array e tem o número esperado de elementos
         if (params.is_array() && params.size() >= 9) {
@@ -49,13 +54,28 @@ MiningJob MiningJob::fromNotification(const json& note) {
                     job.merkleBranches.push_back(branch.get<std::string>());
                 }
                 job.version = params[5].get<std::string>();
-                job.versionInt = std::stoul(job.version, nullptr, 16);
                 job.nBits = params[6].get<std::string>();
-                job.bits = std::stoul(job.nBits, nullptr, 16);
                 job.nTime = params[7].get<std::string>();
-                job.ntime = std::stoul(job.nTime, nullptr, 16);
                 job.extraNonce = params[7].get<std::string>();
 
+                // Validação estrita dos campos hexadecimais vindos do pool
+                if (!isHex(job.prevHash, 32)) {
+                    throw std::invalid_argument("malformed prevhash");
+                }
+                if (!isHex(job.coinbase1) || !isHex(job.coinbase2)) {
+                    throw std::invalid_argument("malformed coinbase");
+                }
+                for (const auto& branch : job.merkleBranches) {
+                    if (!isHex(branch, 32)) {
+                        throw std::invalid_argument("malformed merkle branch");
+                    }
+                }
+                if (!parseHexU32(job.version, job.versionInt)
+                    || !parseHexU32(job.nBits, job.bits)
+                    || !parseHexU32(job.nTime, job.ntime)) {
+                    throw std::invalid_argument("malformed version/nbits/ntime");
+                }
+
                 // Verifica se o último campo é um booleano
                 if (params[8].is_boolean()) {
                     job.cleanJobs = params[8].get<bool>();
@@ -86,4 +106,47 @@ MiningJob MiningJob::fromNotification(const json& note) {
     return job;
 }
 
+/**
+ * Monta o cabeçalho do bloco para este job (caminho de referência).
+ * @param extranonce1 Extranonce1 recebido no mining.subscribe.
+ * @param extranonce2 Extranonce2 escolhido pelo minerador.
+ * @param nonce O nonce.
+ * @return O cabeçalho com a raiz Merkle já calculada.
+ */
+BlockHeader MiningJob::buildHeader(const std::string& extranonce1, const std::string& extranonce2, uint32_t nonce) const {
+    // O Stratum envia o prevhash com os bytes de cada palavra de 32 bits
+    // invertidos; o cabeçalho usa a ordem interna.
+    std::array<uint8_t, 32> prev;
+    if (!decodeHex(prevHash, prev)) {
+        throw std::invalid_argument("malformed prevhash");
+    }
+    for (std::size_t i = 0; i < prev.size(); i += 4) {
+        std::swap(prev[i], prev[i + 3]);
+        std::swap(prev[i + 1], prev[i + 2]);
+    }
+
+    BlockHeader header;
+    header.version = versionInt;
+    header.prevHash = encodeHex(prev.data(), prev.size());
+    header.merkleRoot = headerOnly()
+        ? merkleRoot
+        : calculateMerkleRoot(buildCoinbaseTransaction(coinbase1, extranonce1 + extranonce2, coinbase2), merkleBranches);
+    header.timestamp = ntime;
+    header.bits = bits;
+    header.nonce = nonce;
+    return header;
+}
+
+/**
+ * Alvo que um hash precisa atingir para virar share.
+ * @return Alvo big-endian de 32 bytes: o explícito do pool, se houver, depois
+ * o da dificuldade do pool e por fim o do próprio bloco (nBits).
+ */
+std::vector<uint8_t> MiningJob::target() const {
+    if (shareTarget.size() == 32) {
+        return shareTarget;
+    }
+    return difficulty > 0 ? targetFromDifficulty(difficulty) : targetFromBits(bits);
+}
+
 } // namespace nerdminer
\ No newline at end of file
@@ -12,175 +12,364 @@
 */
 
 #include "nerdminer/miner_session.h"
-#include "nerdminer/miner_job.h"
-#include <nerdminer/nerdminer_block.h>
+#include "nerdminer/stratum_work_source.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
 #include <iostream>
-#include <thread>
-#include <chrono>
-#include <openssl/sha.h>
+#include <sys/stat.h>
 
 namespace nerdminer {
 
+namespace {
+
+    // Quanto esperar pelas respostas dos pools ao encerrar ou remover uma fonte.
+    constexpr std::chrono::seconds kDrainTimeout{5};
+
+} // namespace
+
+std::string defaultSessionStatePath() {
+    if (const char* xdg = std::getenv("XDG_STATE_HOME")) {
+        return std::string(xdg) + "/nerdminer-rpi/session.json";
+    }
+    if (const char* home = std::getenv("HOME")) {
+        return std::string(home) + "/.local/state/nerdminer-rpi/session.json";
+    }
+    return "session.json";
+}
+
+MinerSession::MinerSession()
+    : engine_([this](const ShareCandidate& share) { submitShare(share); }) {
+    std::cout << "Detected " << engine_.threads() << " CPU cores. Starting " << engine_.threads() << " mining threads." << std::endl;
+}
+
 MinerSession::MinerSession(const std::string& host, uint16_t port, const std::string& user, const std::string& password)
-    : client_(host, port, user, password), miningActive(false) {
-    numThreads_ = std::thread::hardware_concurrency();
-    if (numThreads_ == 0) {
-        numThreads_ = 1; // fallback, se falhar
+    : MinerSession() {
+    addSource(std::make_unique<StratumWorkSource>(host, port, user, password));
+}
+
+MinerSession::~MinerSession() {
+    // As fontes chamam o engine das suas threads: param antes dele.
+    for (auto& state : sources_) {
+        state->source->stop();
     }
-    std::cout << "Detected " << numThreads_ << " CPU cores. Starting " << numThreads_ << " mining threads." << std::endl;
+    engine_.stop();
+}
 
-    client_.onResponse = [this](const nerdminer::json& resp) {
-        std::cout << "Response: " << resp.dump() << std::endl;
-        handleResponse(resp);
-    };
+void MinerSession::addSource(std::unique_ptr<WorkSource> source, double weight) {
+    std::lock_guard<std::mutex> lock(sourcesMutex_);
+    sources_.push_back(makeState(std::move(source), weight));
+}
 
-    client_.onNotification = [this](const nerdminer::json& note) {
-        handleNotification(note);
+/**
+ * Cria o estado de uma fonte e liga os callbacks dela ao engine. O último
+ * trabalho fica guardado para ser republicado se os slots mudarem.
+ */
+std::unique_ptr<MinerSession::SourceState> MinerSession::makeState(std::unique_ptr<WorkSource> source, double weight) {
+    auto state = std::make_unique<SourceState>();
+    SourceState* raw = state.get();
+    state->source = std::move(source);
+    state->weight = weight;
+    state->source->onDifficulty = [raw](double difficulty) {
+        raw->difficulty = difficulty;
+    };
+    state->source->onJob = [this, raw](const MiningJob& job, const std::string& extranonce1,
+        std::size_t extranonce2Size, uint64_t receivedNs) {
+        MiningJob stamped = job;
+        stamped.difficulty = raw->difficulty;
+        std::lock_guard<std::mutex> lock(sourcesMutex_);
+        raw->job = stamped;
+        raw->extranonce1 = extranonce1;
+        raw->extranonce2Size = extranonce2Size;
+        raw->hasWork = true;
+        if (raw->active) {
+            engine_.setWork(raw->slot, stamped, extranonce1, extranonce2Size, receivedNs);
+        }
+    };
+    state->source->onTarget = [this, raw](const std::vector<uint8_t>& shareTarget) {
+        std::lock_guard<std::mutex> lock(sourcesMutex_);
+        raw->job.shareTarget = shareTarget;
+        if (raw->active && raw->hasWork) {
+            engine_.setTarget(raw->slot, shareTarget);
+        }
+    };
+    state->source->onWorkLost = [this, raw] {
+        std::lock_guard<std::mutex> lock(sourcesMutex_);
+        raw->hasWork = false;
+        if (raw->active) {
+            engine_.clearWork(raw->slot);
+        }
     };
+    return state;
 }
 
-void MinerSession::handleResponse(const nerdminer::json& response) {
-    if (response.contains("id") && response["id"].is_number()) {
-        int respId = response["id"].get<int>();
-
-        // Verificando se o ID de resposta está na lista de pendentes
-        if (pendingSubmits_.count(respId)) {
-            std::cout << "[*] Found pending submit for response ID: " << respId << std::endl;
-            handleSubmitResponse(response);
-            pendingSubmits_.erase(respId);
-        } else {
-            std::cout << "[*] No pending submit for response ID: " << respId << std::endl;
+/**
+ * Um slot por fonte, na ordem de sources_. Chamado com sourcesMutex_ e o
+ * engine parado.
+ */
+void MinerSession::applySlots() {
+    std::vector<MiningEngine::SlotConfig> slots;
+    for (std::size_t i = 0; i < sources_.size(); ++i) {
+        SourceState& state = *sources_[i];
+        slots.push_back({state.source->name(), state.weight});
+        state.slot = i;
+        state.active = true;
+    }
+    engine_.setSlots(slots);
+    for (auto& state : sources_) {
+        if (state->hasWork) {
+            engine_.setWork(state->slot, state->job, state->extranonce1, state->extranonce2Size);
         }
     }
 }
 
-void MinerSession::handleSubmitResponse(const nerdminer::json& response) {
-    if (response.contains("result") && response["result"].is_boolean()) {
-        if (response["result"].get<bool>()) {
-            std::cout << "\033[1;32m[*] Share accepted!\033[0m" << std::endl;
-        } else {
-            std::cout << "\033[1;31m[!] Share rejected!\033[0m" << std::endl;
+void MinerSession::setThreads(int threads) {
+    engine_.setThreads(threads);
+}
+
+void MinerSession::setKernel(const std::string& kernel) {
+    engine_.setKernel(kernel);
+}
+
+void MinerSession::setBatchSize(uint32_t batchSize) {
+    engine_.setBatchSize(batchSize);
+}
+
+void MinerSession::setNtimeRoll(uint32_t seconds) {
+    engine_.setNtimeRoll(seconds);
+}
+
+void MinerSession::setPerfCounters(bool enabled) {
+    engine_.setPerfCounters(enabled);
+}
+
+void MinerSession::setStateFile(const std::string& path) {
+    statePath_ = path;
+}
+
+std::size_t MinerSession::startSources(const std::vector<SourceState*>& states) {
+    std::size_t started = 0;
+    for (SourceState* state : states) {
+        try {
+            state->source->start();
+            started++;
+        } catch (const std::exception& e) {
+            std::cerr << "Failed to start work source " << state->source->name() << ": " << e.what() << std::endl;
         }
-    } else if (response.contains("error") && !response["error"].is_null()) {
-        std::cout << "\033[1;31m[!] Share rejected with error: " << response["error"].dump() << "\033[0m" << std::endl;
-    } else {
-        std::cout << "[?] Unknown response to share submission." << std::endl;
     }
+    return started;
 }
 
 void MinerSession::start() {
-    std::cout << "Connecting to pool server...\n";
-    client_.connect();
-    client_.subscribe();
-    client_.authorize();
-    stopMiningThreads();
-    startMiningThreads();
-    client_.listen();
-}
-
-void MinerSession::handleNotification(const nerdminer::json& note) {
-    if (note.contains("method")) {
-        const std::string method = note["method"].get<std::string>();
-        if (method == "mining.notify") {
-            MiningJob newJob = MiningJob::fromNotification(note);
-            if (newJob.valid) {
-                std::lock_guard<std::mutex> lock(currentJobMutex_);
-                currentJob_ = newJob;
-                std::cout << "Current job: " << currentJob_.jobId << std::endl;
-            } else {
-                std::cerr << "Received invalid mining job." << std::endl;
+    std::vector<SourceState*> states;
+    {
+        std::lock_guard<std::mutex> lock(sourcesMutex_);
+        if (sources_.empty()) {
+            throw std::logic_error("MinerSession has no work source");
+        }
+        const json saved = loadState();
+        uint32_t epoch = 0;
+        for (auto& state : sources_) {
+            const std::string name = state->source->name();
+            if (saved.contains(name)) {
+                const json& sourceState = saved[name];
+                state->source->resumeSession(sourceState);
+                // A sessão retomada mantém o extranonce1: as lanes de extranonce2
+                // continuam de onde a execução anterior parou.
+                if (sourceState.is_object() && sourceState.contains("restart_epoch") &&
+                    sourceState["restart_epoch"].is_number_unsigned()) {
+                    epoch = std::max(epoch, sourceState["restart_epoch"].get<uint32_t>());
+                }
             }
-        } else {
-            std::cout << "Ignored notification: " << method << std::endl;
+            states.push_back(state.get());
         }
+        engine_.setRestartEpoch(epoch);
+        applySlots();
+    }
+    engine_.start();
+
+    if (startSources(states) == 0) {
+        engine_.stop();
+        throw std::runtime_error("no work source could be started");
+    }
+    running_ = true;
+
+    {
+        std::unique_lock<std::mutex> lock(stopMutex_);
+        stopCv_.wait(lock, [this] { return stopRequested_; });
     }
+    shutdown();
 }
 
-void MinerSession::startMiningThreads() {
-    miningActive = true;
-    std::cout << "Starting mining threads..." << std::endl;
-    miners_.clear();
-    threadHashCounts_.resize(numThreads_, 0);
-    lastHashrateTime_ = std::chrono::steady_clock::now();
-    for (int i = 0; i < numThreads_; ++i) {
-        std::cout << "Starting thread " << i << std::endl;
-        miners_.emplace_back(&MinerSession::miningLoop, this, i);
+void MinerSession::stop() {
+    {
+        std::lock_guard<std::mutex> lock(stopMutex_);
+        stopRequested_ = true;
     }
+    stopCv_.notify_all();
 }
 
-void MinerSession::stopMiningThreads() {
-    miningActive = false;
-    std::cout << "Stopping mining threads..." << std::endl;
+/**
+ * Encerramento ordenado: para os hashes, entrega o que o verificador ainda
+ * tem na fila, espera as respostas dos pools e só então desconecta e grava
+ * o estado das sessões.
+ */
+void MinerSession::shutdown() {
+    running_ = false;
+    std::cout << "Shutting down: flushing pending shares..." << std::endl;
+    engine_.stop();
+    engine_.drainShares();
+    for (auto& state : sources_) {
+        state->source->drain(kDrainTimeout);
+    }
+    for (auto& state : sources_) {
+        state->source->stop();
+    }
+    saveState();
+    std::cout << "Miner session stopped." << std::endl;
+}
 
-    for (auto& miner : miners_) {
-        if (miner.joinable()) {
-            miner.join();
-        }
+/**
+ * Troca threads, kernel e fontes sem reiniciar o processo. O hash pausa
+ * enquanto os slots são refeitos, mas as fontes mantidas seguem conectadas
+ * e o último job delas volta para o engine na hora.
+ * @param config Nova configuração.
+ */
+void MinerSession::reconfigure(Reconfiguration config) {
+    if (!running_) {
+        std::cerr << "Reconfigure ignored: session is not running" << std::endl;
+        return;
+    }
+    if (config.sources.empty()) {
+        std::cerr << "Reconfigure ignored: no work source configured" << std::endl;
+        return;
     }
 
-    miners_.clear();
-}
+    // Shares já encontrados saem antes, ainda com os índices de slot antigos.
+    engine_.stop();
+    engine_.drainShares();
 
-void MinerSession::miningLoop(int threadId) {
-    std::cout << "Thread " << threadId << " started mining loop." << std::endl;
-    while (miningActive) {
-        if (!currentJob_.valid) {
-            std::this_thread::sleep_for(std::chrono::milliseconds(100));
-            continue;
+    std::vector<std::unique_ptr<SourceState>> removed;
+    std::vector<SourceState*> added;
+    {
+        std::lock_guard<std::mutex> lock(sourcesMutex_);
+        std::vector<std::unique_ptr<SourceState>> next;
+        for (auto& entry : config.sources) {
+            const std::string name = entry.source->name();
+            auto it = std::find_if(sources_.begin(), sources_.end(), [&name](const std::unique_ptr<SourceState>& state) {
+                return state && state->source->name() == name;
+            });
+            if (it != sources_.end()) {
+                (*it)->weight = entry.weight;
+                next.push_back(std::move(*it));
+            } else {
+                next.push_back(makeState(std::move(entry.source), entry.weight));
+                added.push_back(next.back().get());
+            }
         }
+        for (auto& state : sources_) {
+            if (state) {
+                state->active = false;
+                removed.push_back(std::move(state));
+            }
+        }
+        sources_ = std::move(next);
 
-        nerdminer::BlockHeader header;
-        header.version = std::stoul(currentJob_.version, nullptr, 16);
-        header.prevHash = currentJob_.prevHash;
-        header.merkleRoot = nerdminer::calculateMerkleRoot(currentJob_.coinbase1 + extranonce1_ + currentJob_.coinbase2, currentJob_.merkleBranches);
-        header.timestamp = std::stoul(currentJob_.nTime, nullptr, 16);
-        header.bits = std::stoul(currentJob_.nBits, nullptr, 16);
-        header.nonce = 0;
-
-        auto target = nerdminer::targetFromBits(header.bits);
+        if (config.threads > 0) {
+            engine_.setThreads(config.threads);
+        }
+        if (!config.kernel.empty()) {
+            engine_.setKernel(config.kernel);
+        }
+        if (config.batchSize > 0) {
+            engine_.setBatchSize(config.batchSize);
+        }
+        applySlots();
+    }
 
-        for (uint32_t nonce = 0; nonce < 0xFFFFFFFF; ++nonce) {
-            header.nonce = nonce;
-            auto headerBytes = nerdminer::buildBlockHeader(header);
-            auto hash = nerdminer::doubleSHA256(headerBytes);
+    for (auto& state : removed) {
+        std::cout << "Removing work source " << state->source->name() << std::endl;
+        state->source->drain(kDrainTimeout);
+        state->source->stop();
+    }
+    removed.clear();
 
-            threadHashCounts_[threadId]++;
+    engine_.start();
+    startSources(added);
+    std::cout << "Reconfigured: " << engine_.threads() << " thread(s), " << sources_.size() << " work source(s)" << std::endl;
+}
 
-            if (nerdminer::isHashBelowTarget(hash, target)) {
-                {
-                    std::lock_guard<std::mutex> lock(outputMutex_);
-                    std::cout << "\033[1;34mThread " << threadId << " found valid nonce: " << nonce << "\n"
-                            << "Hash: " << nerdminer::bytesToHex(hash) << "\033[0m" << std::endl;
-                }
-                client_.submitShare(currentJob_, nonce);
-                break;
-            }
+json MinerSession::loadState() const {
+    if (statePath_.empty()) {
+        return json::object();
+    }
+    std::ifstream in(statePath_);
+    if (!in) {
+        return json::object();
+    }
+    json state = json::parse(in, nullptr, false);
+    if (state.is_discarded() || !state.is_object()) {
+        std::cerr << "Ignoring malformed state file " << statePath_ << std::endl;
+        return json::object();
+    }
+    return state;
+}
 
-            if (!miningActive) {
-                break;
-            }
+/**
+ * Grava o estado de cada fonte (chave = name()), preservando o de fontes
+ * que não estão nesta execução. Escreve num temporário e renomeia, para um
+ * desligamento no meio não deixar o arquivo truncado.
+ */
+void MinerSession::saveState() const {
+    if (statePath_.empty()) {
+        return;
+    }
+    json state = loadState();
+    for (const auto& entry : sources_) {
+        json sourceState = entry->source->sessionState();
+        if (!sourceState.is_null()) {
+            // Gravado depois do stop(): é a primeira época ainda não usada.
+            sourceState["restart_epoch"] = engine_.restartEpoch();
+            state[entry->source->name()] = sourceState;
+        }
+    }
 
-            auto now = std::chrono::steady_clock::now();
-            auto elapsed = std::chrono::duration_cast<std::chrono::seconds>(now - lastHashrateTime_).count();
-            if (elapsed >= 5) {
-                uint64_t totalHashes = 0;
-                for (const auto& count : threadHashCounts_) {
-                    totalHashes += count;
-                }
-                double hashrate = static_cast<double>(totalHashes) / elapsed;
-                
-                {
-                    std::lock_guard<std::mutex> lock(outputMutex_);
-                    std::cout << "\033[1;32mHashrate: " << hashrate << " H/s\033[0m" << std::endl;
-                }
+    for (std::size_t pos = statePath_.find('/', 1); pos != std::string::npos; pos = statePath_.find('/', pos + 1)) {
+        ::mkdir(statePath_.substr(0, pos).c_str(), 0755);
+    }
+    const std::string tmp = statePath_ + ".tmp";
+    {
+        std::ofstream out(tmp);
+        if (!out || !(out << state.dump(2) << "\n")) {
+            std::cerr << "Could not write state file " << tmp << std::endl;
+            return;
+        }
+    }
+    if (std::rename(tmp.c_str(), statePath_.c_str()) != 0) {
+        std::cerr << "Could not replace state file " << statePath_ << std::endl;
+    }
+}
 
-                for (auto& count : threadHashCounts_) {
-                    count = 0;
-                }
-                lastHashrateTime_ = now;
-            }
+/**
+ * Encaminha um share verificado para a fonte que forneceu o job.
+ * Roda na thread do verificador.
+ * @param share O share verificado.
+ */
+void MinerSession::submitShare(const ShareCandidate& share) {
+    WorkSource* source = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(sourcesMutex_);
+        if (share.slot < sources_.size()) {
+            source = sources_[share.slot]->source.get();
         }
     }
+    if (source == nullptr) {
+        std::cerr << "Dropping share for unknown work source " << share.slot << std::endl;
+        return;
+    }
+    // Fora do lock: o submitblock do modo solo pode demorar.
+    source->submitShare(share);
 }
 
 } // namespace nerdminer
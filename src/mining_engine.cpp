@@ -0,0 +1,469 @@
+/**
+* Project: nerdminer-rpi
+* File: mining_engine.cpp
+* Description: hashing threads, kernel selection and statistics shared by pool and solo sessions
+*
+* Author: Regis Araujo Melo
+* Date: 2025-04-21
+* Version: 0.1.0
+*
+* MIT License
+* © 2025 Regis Araujo Melo
+*/
+
+#include "nerdminer/mining_engine.h"
+#include <nerdminer/hex.h>
+#include <nerdminer/hash_kernel.h>
+#include <nerdminer/trace.h>
+#include <algorithm>
+#include <iostream>
+#include <ctime>
+#include <stdexcept>
+
+namespace nerdminer {
+
+struct MiningEngine::Cursor {
+    uint64_t generation = 0;
+    uint64_t targetVersion = 0;
+    bool exhausted = false;
+    bool firstBatch = true;
+    Work work;
+    std::string extranonce2;
+    HeaderTemplate tmpl;
+    Target target{};
+    uint64_t nonce = 0;
+    uint64_t nonceBegin = 0;
+    uint64_t nonceEnd = 0x100000000ull;
+    uint32_t ntime = 0;
+};
+
+MiningEngine::MiningEngine(ShareFn onShare)
+    : verifier_(std::move(onShare)) {
+    numThreads_ = std::thread::hardware_concurrency();
+    if (numThreads_ == 0) {
+        numThreads_ = 1; // fallback, se falhar
+    }
+    setSlots({SlotConfig{"default", 1.0}});
+}
+
+MiningEngine::~MiningEngine() {
+    stop();
+    verifier_.stop();
+}
+
+void MiningEngine::setThreads(int threads) {
+    numThreads_ = std::max(1, threads);
+}
+
+void MiningEngine::setKernel(const std::string& kernel) {
+    kernelName_ = kernel;
+}
+
+void MiningEngine::setBatchSize(uint32_t batchSize) {
+    batchSize_ = batchSize;
+}
+
+void MiningEngine::setNtimeRoll(uint32_t seconds) {
+    ntimeRoll_ = seconds;
+}
+
+void MiningEngine::setPerfCounters(bool enabled) {
+    perfEnabled_ = enabled;
+}
+
+void MiningEngine::setSlots(const std::vector<SlotConfig>& slots) {
+    if (!miners_.empty()) {
+        throw std::logic_error("setSlots() called while mining");
+    }
+    if (slots.empty()) {
+        throw std::invalid_argument("at least one work slot is required");
+    }
+    slots_.clear();
+    for (const auto& config : slots) {
+        auto slot = std::make_unique<Slot>();
+        slot->config = config;
+        if (!(slot->config.weight > 0)) {
+            slot->config.weight = 1.0;
+        }
+        slots_.push_back(std::move(slot));
+    }
+}
+
+/**
+ * Publica um novo trabalho para as threads. Elas abandonam o lote atual
+ * assim que percebem a troca de geração.
+ * @param slot Índice do slot (fonte) do trabalho.
+ * @param job O job, com prevhash no formato Stratum.
+ * @param extranonce1 Extranonce1 atribuído pela fonte do trabalho.
+ * @param extranonce2Size Tamanho em bytes do extranonce2 que cada thread gera.
+ * @param receivedNs Instante (traceNow) em que o trabalho chegou; 0 = agora.
+ */
+void MiningEngine::setWork(std::size_t slotIndex, const MiningJob& job, const std::string& extranonce1,
+    std::size_t extranonce2Size, uint64_t receivedNs) {
+    Slot& slot = *slots_.at(slotIndex);
+    std::lock_guard<std::mutex> lock(workMutex_);
+    const uint64_t nextGeneration = ++jobGeneration_;
+    traceAsyncBegin("job.notify_to_first_hash", nextGeneration, receivedNs);
+    if (slot.generation == 0) {
+        // Slot que acabou de ganhar trabalho parte do mesmo ponto dos outros,
+        // senão monopolizaria as threads até "alcançá-los".
+        double progress = -1;
+        for (const auto& other : slots_) {
+            if (other.get() != &slot && other->generation != 0) {
+                double p = other->hashes / other->config.weight;
+                progress = progress < 0 ? p : std::min(progress, p);
+            }
+        }
+        if (progress > 0) {
+            slot.hashes = static_cast<uint64_t>(progress * slot.config.weight);
+            slot.reportedHashes = slot.hashes;
+        }
+    }
+    slot.work.job = job;
+    slot.work.extranonce1 = extranonce1;
+    slot.work.extranonce2Size = extranonce2Size;
+    slot.generation = nextGeneration;
+    traceInstant("job.publish", nextGeneration);
+}
+
+/**
+ * Alvo novo para o trabalho atual do slot (SetTarget do SV2). A geração não
+ * muda: as threads só trocam o alvo e seguem do nonce em que estavam, sem
+ * refazer (e ressubmeter) o que já buscaram.
+ * @param slot Índice do slot (fonte).
+ * @param shareTarget Alvo de 32 bytes, big-endian.
+ */
+void MiningEngine::setTarget(std::size_t slotIndex, const std::vector<uint8_t>& shareTarget) {
+    Slot& slot = *slots_.at(slotIndex);
+    std::lock_guard<std::mutex> lock(workMutex_);
+    slot.work.job.shareTarget = shareTarget;
+    slot.targetVersion++;
+}
+
+void MiningEngine::clearWork(std::size_t slotIndex) {
+    Slot& slot = *slots_.at(slotIndex);
+    std::lock_guard<std::mutex> lock(workMutex_);
+    if (slot.generation == 0) {
+        return;
+    }
+    slot.work = Work{};
+    slot.generation = ++jobGeneration_;
+}
+
+void MiningEngine::start() {
+    stop();
+    miningActive = true;
+    std::cout << "Starting " << numThreads_ << " mining threads..." << std::endl;
+    threadHashCounts_ = std::make_unique<HashCounter[]>(numThreads_);
+    lastHashrateTime_ = std::chrono::steady_clock::now();
+    for (int i = 0; i < numThreads_; ++i) {
+        std::cout << "Starting thread " << i << std::endl;
+        miners_.emplace_back(&MiningEngine::miningLoop, this, i);
+    }
+}
+
+void MiningEngine::stop() {
+    if (miners_.empty()) {
+        return;
+    }
+    miningActive = false;
+    std::cout << "Stopping mining threads..." << std::endl;
+
+    for (auto& miner : miners_) {
+        if (miner.joinable()) {
+            miner.join();
+        }
+    }
+
+    miners_.clear();
+    restarts_++;
+}
+
+/**
+ * Extranonce2 da lane (época << 16 | thread), com os bytes menos
+ * significativos da lane; o resto vai para o ntime (laneNtimeOffset).
+ */
+std::string MiningEngine::laneExtranonce2(std::size_t extranonce2Size, uint32_t epoch, int threadId) {
+    const uint64_t lane = (uint64_t(epoch) << 16) | static_cast<uint64_t>(threadId);
+    std::vector<uint8_t> en2(extranonce2Size, 0);
+    for (std::size_t i = 0; i < en2.size() && i < sizeof(lane); ++i) {
+        en2[en2.size() - 1 - i] = static_cast<uint8_t>(lane >> (8 * i));
+    }
+    return encodeHex(en2.data(), en2.size());
+}
+
+/**
+ * Deslocamento de ntime inicial da época. As épocas que ainda cabem no
+ * extranonce2 (3 bytes ou mais) compartilham o deslocamento; com 1 ou 2
+ * bytes, ou sem extranonce, cada época tem o seu, módulo kNtimeEpochs.
+ */
+uint32_t MiningEngine::laneNtimeOffset(std::size_t extranonce2Size, uint32_t epoch, uint32_t ntimeRoll) {
+    const std::size_t bits = 8 * std::min<std::size_t>(extranonce2Size, 8);
+    uint32_t index = epoch;
+    if (bits >= 16) {
+        index = bits - 16 >= 32 ? 0 : epoch >> (bits - 16);
+    }
+    return index % ntimeStep(ntimeRoll);
+}
+
+/**
+ * Passo da rolagem: um ntime para cada época, limitado ao tamanho da janela.
+ */
+uint32_t MiningEngine::ntimeStep(uint32_t ntimeRoll) {
+    return static_cast<uint32_t>(std::min<uint64_t>(kNtimeEpochs, uint64_t(ntimeRoll) + 1));
+}
+
+/**
+ * Avança o ntime em ntimeStep() segundos, se ainda estiver dentro da janela
+ * aceita: até ntimeRoll segundos após o ntime do job e nunca mais de 2 horas
+ * à frente do relógio local (limite de consenso para o timestamp do bloco).
+ * @param ntime O ntime em uso; atualizado se houver avanço.
+ * @return False se a janela se esgotou.
+ */
+bool MiningEngine::rollNtime(uint32_t jobNtime, uint32_t ntimeRoll, uint64_t now, uint32_t& ntime) {
+    const uint64_t next = uint64_t(ntime) + ntimeStep(ntimeRoll);
+    if (next > uint64_t(jobNtime) + ntimeRoll || next > now + 7200) {
+        return false;
+    }
+    ntime = static_cast<uint32_t>(next);
+    return true;
+}
+
+/**
+ * Chamado por todas as threads depois de cada lote; só uma por vez passa do
+ * try_lock, e quem está imprimindo um hit não é esperado.
+ */
+void MiningEngine::reportHashrate() {
+    std::unique_lock<std::mutex> lock(outputMutex_, std::try_to_lock);
+    if (!lock.owns_lock()) {
+        return;
+    }
+    auto now = std::chrono::steady_clock::now();
+    auto elapsed = std::chrono::duration_cast<std::chrono::seconds>(now - lastHashrateTime_).count();
+    if (elapsed < 5) {
+        return;
+    }
+    uint64_t totalHashes = 0;
+    for (int i = 0; i < numThreads_; ++i) {
+        totalHashes += threadHashCounts_[i].value.exchange(0, std::memory_order_relaxed);
+    }
+    lastHashrateTime_ = now;
+    double hashrate = static_cast<double>(totalHashes) / elapsed;
+
+    {
+        std::cout << "\033[1;32mHashrate: " << hashrate << " H/s\033[0m" << std::endl;
+        if (slots_.size() > 1) {
+            // setWork também mexe em hashes/reportedHashes ao ativar um slot.
+            std::vector<uint64_t> deltas;
+            {
+                std::lock_guard<std::mutex> workLock(workMutex_);
+                for (auto& slot : slots_) {
+                    const uint64_t hashes = slot->hashes;
+                    deltas.push_back(hashes - slot->reportedHashes);
+                    slot->reportedHashes = hashes;
+                }
+            }
+            for (std::size_t i = 0; i < slots_.size(); ++i) {
+                const Slot* slot = slots_[i].get();
+                const uint64_t delta = deltas[i];
+                std::cout << "  [" << slot->config.name << "] " << static_cast<double>(delta) / elapsed << " H/s ("
+                          << (totalHashes ? 100.0 * delta / totalHashes : 0.0) << "%, weight "
+                          << slot->config.weight << ")" << std::endl;
+            }
+        }
+        verifier_.printStats(std::cout);
+        if (perfEnabled_) {
+            std::lock_guard<std::mutex> perfLock(perfMutex_);
+            for (const auto& entry : perfTotals_) {
+                printPerfLine(std::cout, entry.first, entry.second.sample, entry.second.hashes);
+            }
+            perfTotals_.clear();
+        }
+    }
+}
+
+void MiningEngine::miningLoop(int threadId) {
+    std::cout << "Thread " << threadId << " started mining loop." << std::endl;
+    traceSetThreadName("miner-" + std::to_string(threadId));
+    std::unique_ptr<HashKernel> kernel = makeKernel(kernelName_);
+    const std::atomic<bool>* kernelDisabled = &verifier_.disabledFlag(kernel->name());
+    std::vector<HashHit> hits;
+    std::vector<Cursor> cursors(slots_.size());
+    std::unique_ptr<PerfCounters> perf;
+    if (perfEnabled_) {
+        perf = std::make_unique<PerfCounters>();
+        if (!perf->available()) {
+            if (threadId == 0) {
+                std::lock_guard<std::mutex> lock(outputMutex_);
+                std::cerr << "Perf counters unavailable (check /proc/sys/kernel/perf_event_paranoid)" << std::endl;
+            }
+            perf.reset();
+        }
+    }
+    while (miningActive) {
+        // Kernel reprovado pelo verificador: cai para o OpenSSL e, se for ele, para a referência.
+        if (*kernelDisabled) {
+            std::string fallback = std::string(kernel->name()) == "openssl" ? "reference" : "openssl";
+            if (std::string(kernel->name()) == "reference" || verifier_.disabledFlag(fallback)) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(100));
+                continue;
+            }
+            kernel = makeKernel(fallback);
+            kernelDisabled = &verifier_.disabledFlag(kernel->name());
+            std::lock_guard<std::mutex> lock(outputMutex_);
+            std::cout << "Thread " << threadId << " switched to kernel " << kernel->name() << std::endl;
+        }
+
+        const int slotIndex = pickSlot(cursors);
+        if (slotIndex < 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            continue;
+        }
+        Slot& slot = *slots_[slotIndex];
+        Cursor& cursor = cursors[slotIndex];
+
+        if (cursor.generation != slot.generation) {
+            {
+                std::lock_guard<std::mutex> lock(workMutex_);
+                cursor.work = slot.work;
+                cursor.generation = slot.generation;
+                cursor.targetVersion = slot.targetVersion;
+            }
+            const uint64_t generation = cursor.generation;
+            const MiningJob& job = cursor.work.job;
+            cursor.exhausted = !job.valid || (!job.headerOnly() && cursor.work.extranonce2Size == 0);
+            if (cursor.exhausted) {
+                continue;
+            }
+
+            cursor.ntime = job.ntime + laneNtimeOffset(cursor.work.extranonce2Size, restarts_, ntimeRoll_);
+            if (job.headerOnly()) {
+                // Sem extranonce para variar: as threads dividem a faixa de nonces
+                // e a época de restart fica só no ntime.
+                const uint64_t span = 0x100000000ull / numThreads_;
+                cursor.nonceBegin = span * threadId;
+                cursor.nonceEnd = threadId == numThreads_ - 1 ? 0x100000000ull : cursor.nonceBegin + span;
+                cursor.extranonce2.clear();
+            } else {
+                // Cada thread usa uma lane própria para não repetir o trabalho
+                // das outras nem o de antes de um restart. Num extranonce2 de
+                // 1 byte só cabem 256 threads; as demais ficam sem este slot.
+                if (cursor.work.extranonce2Size == 1 && threadId > 0xff) {
+                    cursor.exhausted = true;
+                    continue;
+                }
+                cursor.extranonce2 = laneExtranonce2(cursor.work.extranonce2Size, restarts_, threadId);
+                cursor.nonceBegin = 0;
+                cursor.nonceEnd = 0x100000000ull;
+            }
+
+            traceInstant("job.pickup", generation);
+            {
+                TraceSpan span("job.prepare", generation);
+                cursor.tmpl = HeaderTemplate::fromHeader(job.buildHeader(cursor.work.extranonce1, cursor.extranonce2, 0));
+                if (cursor.ntime != job.ntime) {
+                    cursor.tmpl.setTime(cursor.ntime);
+                }
+            }
+            cursor.target = makeTarget(job.target());
+            cursor.firstBatch = true;
+            cursor.nonce = cursor.nonceBegin;
+        } else if (cursor.targetVersion != slot.targetVersion) {
+            // Alvo novo para o mesmo trabalho: a busca continua de onde estava.
+            std::lock_guard<std::mutex> lock(workMutex_);
+            if (cursor.generation == slot.generation) {
+                cursor.work.job.shareTarget = slot.work.job.shareTarget;
+                cursor.target = makeTarget(cursor.work.job.target());
+            }
+            cursor.targetVersion = slot.targetVersion;
+        }
+
+        // Espaço de busca: nonce (32 bits) x ntime dentro da janela do pool.
+        const uint64_t generation = cursor.generation;
+        uint32_t count = static_cast<uint32_t>(std::min<uint64_t>(batchSize_, cursor.nonceEnd - cursor.nonce));
+        hits.clear();
+        const uint64_t batchStart = cursor.firstBatch && traceEnabled() ? traceNow() : 0;
+        if (perf) {
+            perf->begin();
+        }
+        const uint64_t hashed = kernel->hashHeaders(cursor.tmpl, static_cast<uint32_t>(cursor.nonce), count, cursor.target, hits);
+        threadHashCounts_[threadId].value.fetch_add(hashed, std::memory_order_relaxed);
+        slot.hashes += hashed;
+        const uint32_t batchNtime = cursor.ntime;
+        cursor.nonce += count;
+        if (cursor.firstBatch) {
+            cursor.firstBatch = false;
+            if (batchStart != 0) {
+                traceComplete("job.first_batch", batchStart, traceNow(), generation);
+            }
+            // A primeira thread a terminar um lote fecha a latência notify -> hash.
+            if (slot.firstHashGeneration.exchange(generation) != generation) {
+                traceAsyncEnd("job.notify_to_first_hash", generation);
+            }
+        }
+        if (perf) {
+            perf->end();
+            std::lock_guard<std::mutex> lock(perfMutex_);
+            PerfTotals& totals = perfTotals_[kernel->name()];
+            totals.sample += perf->take();
+            totals.hashes += hashed;
+        }
+
+        for (const auto& hit : hits) {
+            traceInstant("share.hit", hit.nonce);
+            {
+                std::lock_guard<std::mutex> lock(outputMutex_);
+                std::cout << "\033[1;34mThread " << threadId << " found valid nonce: " << hit.nonce << "\n"
+                        << "Hash: " << encodeHex(hit.hash.data(), hit.hash.size()) << "\033[0m" << std::endl;
+            }
+            ShareCandidate candidate;
+            candidate.kernel = kernel->name();
+            candidate.slot = static_cast<std::size_t>(slotIndex);
+            candidate.job = cursor.work.job;
+            candidate.extranonce1 = cursor.work.extranonce1;
+            candidate.extranonce2 = cursor.extranonce2;
+            candidate.ntime = batchNtime;
+            candidate.nonce = hit.nonce;
+            candidate.hash.assign(hit.hash.begin(), hit.hash.end());
+            verifier_.enqueue(std::move(candidate));
+        }
+
+        if (cursor.nonce >= cursor.nonceEnd) {
+            // Nonces esgotados: avança o ntime; sem janela, o slot fica parado
+            // para esta thread até o próximo job em vez de repetir trabalho.
+            cursor.nonce = cursor.nonceBegin;
+            if (rollNtime(cursor.work.job.ntime, ntimeRoll_, static_cast<uint64_t>(std::time(nullptr)), cursor.ntime)) {
+                cursor.tmpl.setTime(cursor.ntime);
+            } else {
+                cursor.exhausted = true;
+            }
+        }
+        reportHashrate();
+    }
+}
+
+/**
+ * Escolhe o slot para o próximo lote: entre os que têm trabalho para esta
+ * thread, o que está mais atrasado em hashes / peso.
+ * @param cursors Progresso da thread em cada slot.
+ * @return Índice do slot, ou -1 se não houver trabalho.
+ */
+int MiningEngine::pickSlot(const std::vector<Cursor>& cursors) const {
+    int best = -1;
+    double bestProgress = 0;
+    for (std::size_t i = 0; i < slots_.size(); ++i) {
+        const Slot& slot = *slots_[i];
+        const uint64_t generation = slot.generation;
+        if (generation == 0 || (cursors[i].generation == generation && cursors[i].exhausted)) {
+            continue;
+        }
+        const double progress = slot.hashes / slot.config.weight;
+        if (best < 0 || progress < bestProgress) {
+            best = static_cast<int>(i);
+            bestProgress = progress;
+        }
+    }
+    return best;
+}
+
+} // namespace nerdminer
@@ -12,43 +12,46 @@
 */
 
 #include "nerdminer/nerdminer_block.h"
+#include "nerdminer/hex.h"
 #include <vector>
 #include <string>
 #include <cstdint>
 #include <cstring>
-#include <sstream>
-#include <iomanip>
 #include <openssl/sha.h>
 #include <atomic>
 #include <thread>
 #include <iostream>
 #include <openssl/evp.h>
+#include <stdexcept>
+#include <cmath>
 
 namespace nerdminer {
 
     std::vector<uint8_t> hexStringToBytes(const std::string& hex) {
-        std::vector<uint8_t> bytes;
-        for (size_t i = 0; i < hex.length(); i += 2) {
-            std::string byteString = hex.substr(i, 2);
-            uint8_t byte = (uint8_t)strtol(byteString.c_str(), nullptr, 16);
-            bytes.push_back(byte);
-        }
-        return bytes;
+        return decodeHex(hex);
+    }
+
+    /**
+     * Escreve um campo de 32 bits do cabeçalho (versão, tempo, bits, nonce)
+     * em little-endian, como no protocolo. Os kernels usam esta função para
+     * gravar o nonce, então a ordem de bytes é sempre a mesma do caminho de
+     * referência.
+     */
+    void putHeaderField(uint8_t* dst, uint32_t value) {
+        dst[0] = value & 0xFF;
+        dst[1] = (value >> 8) & 0xFF;
+        dst[2] = (value >> 16) & 0xFF;
+        dst[3] = (value >> 24) & 0xFF;
     }
 
     void appendInt32(std::vector<uint8_t>& result, uint32_t value) {
-        result.push_back((value >> 24) & 0xFF);
-        result.push_back((value >> 16) & 0xFF);
-        result.push_back((value >> 8) & 0xFF);
-        result.push_back(value & 0xFF);
+        uint8_t field[4];
+        putHeaderField(field, value);
+        result.insert(result.end(), field, field + 4);
     }
 
     std::string bytesToHex(const std::vector<uint8_t>& bytes) {
-        std::stringstream ss;
-        for (size_t i = 0; i < bytes.size(); ++i) {
-            ss << std::setw(2) << std::setfill('0') << std::hex << (int)bytes[i];
-        }
-        return ss.str();
+        return encodeHex(bytes.data(), bytes.size());
     }
 
 /**
@@ -98,11 +101,16 @@ std::string buildCoinbaseTransaction(const std::string& coinb1, const std::strin
 std::string calculateMerkleRoot(const std::string& coinbaseTransaction, const std::vector<std::string>& merkleBranches) {
     std::vector<uint8_t> merkle = doubleSHA256(hexStringToBytes(coinbaseTransaction));
 
+    // merkle = hash atual (32 bytes) + ramo (32 bytes), reaproveitando o buffer
+    merkle.resize(64);
     for (const auto& branch : merkleBranches) {
-        std::vector<uint8_t> branchBytes = hexStringToBytes(branch);
-        merkle.insert(merkle.end(), branchBytes.begin(), branchBytes.end());
-        merkle = doubleSHA256(merkle);
+        if (!decodeHex(branch, merkle.data() + 32, 32)) {
+            throw std::invalid_argument("invalid merkle branch: " + branch);
+        }
+        std::vector<uint8_t> next = doubleSHA256(merkle);
+        std::memcpy(merkle.data(), next.data(), 32);
     }
+    merkle.resize(32);
 
     return bytesToHex(merkle);
 }
@@ -114,9 +122,11 @@ std::string calculateMerkleRoot(const std::string& coinbaseTransaction, const st
  */
 std::vector<uint8_t> buildBlockHeader(const BlockHeader& header) {
     std::vector<uint8_t> result;
+    std::vector<uint8_t> prevHash = hexStringToBytes(header.prevHash);
+    std::vector<uint8_t> merkleRoot = hexStringToBytes(header.merkleRoot);
     appendInt32(result, header.version);
-    result.insert(result.end(), hexStringToBytes(header.prevHash).begin(), hexStringToBytes(header.prevHash).end());
-    result.insert(result.end(), hexStringToBytes(header.merkleRoot).begin(), hexStringToBytes(header.merkleRoot).end());
+    result.insert(result.end(), prevHash.begin(), prevHash.end());
+    result.insert(result.end(), merkleRoot.begin(), merkleRoot.end());
     appendInt32(result, header.timestamp);
     appendInt32(result, header.bits);
     appendInt32(result, header.nonce);
@@ -167,9 +177,9 @@ bool checkHashMeetsTarget(const std::vector<uint8_t>& hash, const std::vector<ui
 }
 
 /**
- * Converte os bits para o formato de alvo.
+ * Converte os bits (formato compacto) para o alvo.
  * @param bits Os bits que representam o alvo.
- * @return O alvo como um vetor de 32 bytes.
+ * @return O alvo como um número big-endian de 32 bytes.
  */
 std::vector<uint8_t> targetFromBits(uint32_t bits) {
     uint32_t exponent = bits >> 24;
@@ -177,20 +187,45 @@ std::vector<uint8_t> targetFromBits(uint32_t bits) {
 
     std::vector<uint8_t> target(32, 0);
 
-    int shift = exponent - 3;
-
-    if (shift >= 0 && shift <= 29) {
-        target[shift] = (mantissa >> 16) & 0xFF;
-        target[shift + 1] = (mantissa >> 8) & 0xFF;
-        target[shift + 2] = mantissa & 0xFF;
-    } else {
-        // Expoente inválido, devolve alvo impossível (nunca será atingido)
-        std::fill(target.begin(), target.end(), 0xFF);
+    if (exponent > 32 || (mantissa & 0x800000)) {
+        // Expoente inválido ou alvo negativo: devolve alvo impossível (nunca será atingido)
+        return target;
+    }
+    // O byte menos significativo da mantissa fica na posição 31 - (exponent - 3).
+    for (int i = 0; i < 3; ++i) {
+        int pos = 32 - int(exponent) + i;
+        if (pos >= 0 && pos < 32) {
+            target[pos] = (mantissa >> (8 * (2 - i))) & 0xFF;
+        }
     }
 
     return target;
 }
 
+/**
+ * Alvo de share para a dificuldade do pool: 0x00000000FFFF0000...0 / difficulty.
+ * @param difficulty Dificuldade recebida em mining.set_difficulty.
+ * @return O alvo como um número big-endian de 32 bytes.
+ */
+std::vector<uint8_t> targetFromDifficulty(double difficulty) {
+    std::vector<uint8_t> target(32, 0xFF);
+    if (!(difficulty > 0)) {
+        return target;
+    }
+    // x = alvo / 2^256, extraído byte a byte do mais significativo.
+    long double x = std::ldexp(65535.0L / difficulty, 208 - 256);
+    if (x >= 1.0L) {
+        return target;
+    }
+    for (auto& byte : target) {
+        x *= 256.0L;
+        long double digit = std::floor(x);
+        byte = static_cast<uint8_t>(digit);
+        x -= digit;
+    }
+    return target;
+}
+
 /**
  * Verifica se o hash gerado é menor ou igual ao alvo.
  * @param hash O hash gerado.
@@ -198,10 +233,16 @@ std::vector<uint8_t> targetFromBits(uint32_t bits) {
  * @return True se o hash for menor ou igual ao alvo, caso contrário, false.
  */
 bool isHashBelowTarget(const std::vector<uint8_t>& hash, const std::vector<uint8_t>& target) {
+    return isHashBelowTarget(hash.data(), target.data());
+}
+
+// O hash sai do SHA-256 em little-endian (byte 31 é o mais significativo);
+// o alvo é big-endian.
+bool isHashBelowTarget(const uint8_t* hash, const uint8_t* target) {
     for (size_t i = 0; i < 32; ++i) {
-        if (hash[i] < target[i]) {
+        if (hash[31 - i] < target[i]) {
             return true;
-        } else if (hash[i] > target[i]) {
+        } else if (hash[31 - i] > target[i]) {
             return false;
         }
     }
@@ -0,0 +1,121 @@
+/**
+* Project: nerdminer-rpi
+* File: offline_work_source.cpp
+* Description: synthetic work source that runs the full mining pipeline without a network
+*
+* Author: Regis Araujo Melo
+* Date: 2025-04-21
+* Version: 0.1.0
+*
+* MIT License
+* © 2025 Regis Araujo Melo
+*/
+
+#include "nerdminer/offline_work_source.h"
+#include "nerdminer/hex.h"
+#include "nerdminer/nerdminer_block.h"
+#include "nerdminer/trace.h"
+#include <chrono>
+#include <ctime>
+#include <iostream>
+
+namespace nerdminer {
+
+/**
+ * Job determinístico por número de série, com coinbase e ramos Merkle de
+ * tamanho realista para que o custo de preparação seja o de um pool.
+ */
+MiningJob syntheticJob(uint64_t serial) {
+    const std::string seed = "offline:" + std::to_string(serial);
+    const std::vector<uint8_t> prev = doubleSHA256(std::vector<uint8_t>(seed.begin(), seed.end()));
+
+    MiningJob job;
+    job.jobId = hexU32(static_cast<uint32_t>(serial));
+    job.prevHash = bytesToHex(prev);
+    job.coinbase1 = "02000000" "01" + std::string(64, '0') + "ffffffff" "19"
+                    "03" + hexU32(static_cast<uint32_t>(serial)).substr(2) + "08";
+    job.coinbase2 = "0b2f6e6572646d696e65722f" "ffffffff" "01"
+                    "00f2052a01000000" "16" "0014" + std::string(40, '0') + "00000000";
+    std::vector<uint8_t> branch = prev;
+    for (int i = 0; i < 11; ++i) {
+        branch = doubleSHA256(branch);
+        job.merkleBranches.push_back(bytesToHex(branch));
+    }
+    job.versionInt = 0x20000000;
+    job.bits = 0x1d00ffff;
+    job.ntime = static_cast<uint32_t>(std::time(nullptr));
+    job.version = hexU32(job.versionInt);
+    job.nBits = hexU32(job.bits);
+    job.nTime = hexU32(job.ntime);
+    job.cleanJobs = true;
+    job.valid = true;
+    return job;
+}
+
+OfflineWorkSource::OfflineWorkSource(const OfflineConfig& config)
+    : config_(config) {}
+
+OfflineWorkSource::~OfflineWorkSource() {
+    stop();
+}
+
+void OfflineWorkSource::start() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = false;
+    }
+    worker_ = std::thread(&OfflineWorkSource::run, this);
+}
+
+void OfflineWorkSource::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    cv_.notify_all();
+    if (worker_.joinable()) {
+        worker_.join();
+    }
+}
+
+void OfflineWorkSource::run() {
+    traceSetThreadName("offline-source");
+    if (onDifficulty) {
+        onDifficulty(config_.difficulty);
+    }
+    for (uint64_t serial = 1;; ++serial) {
+        MiningJob job = syntheticJob(serial);
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            currentJobId_ = job.jobId;
+        }
+        if (onJob) {
+            onJob(job, "4e4d0000", 4, 0);
+        }
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (cv_.wait_for(lock, std::chrono::seconds(config_.jobSeconds), [this] { return stopping_; })) {
+            return;
+        }
+    }
+}
+
+/**
+ * "Aceita" o share: o verificador já conferiu hash e alvo, então aqui só
+ * resta a checagem de job velho que um pool faria.
+ */
+void OfflineWorkSource::submitShare(const ShareCandidate& share) {
+    bool current;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        current = share.job.jobId == currentJobId_;
+    }
+    if (current) {
+        accepted_++;
+        std::cout << "\033[1;32m[*] Offline share accepted (" << accepted_ << " total)\033[0m" << std::endl;
+    } else {
+        stale_++;
+        std::cout << "\033[1;31m[!] Offline share stale (job " << share.job.jobId << ")\033[0m" << std::endl;
+    }
+}
+
+} // namespace nerdminer
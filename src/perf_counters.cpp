@@ -0,0 +1,190 @@
+/**
+* Project: nerdminer-rpi
+* File: perf_counters.cpp
+* Description: per-thread hardware counters around the hashing loop
+*
+* Author: Regis Araujo Melo
+* Date: 2025-04-21
+* Version: 0.1.0
+*
+* MIT License
+* © 2025 Regis Araujo Melo
+*/
+
+#include "nerdminer/perf_counters.h"
+#include <cstring>
+#include <iomanip>
+#include <sstream>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace nerdminer {
+
+namespace {
+
+    /**
+     * Abre um contador; com groupFd = -1 ele é o líder (criado desabilitado),
+     * senão entra no grupo do líder e segue o estado dele.
+     */
+    int openCounter(uint64_t config, int groupFd) {
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = config;
+        attr.disabled = groupFd < 0 ? 1 : 0;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, groupFd, 0));
+    }
+
+    const uint64_t kConfigs[PerfEventCount] = {
+        PERF_COUNT_HW_CPU_CYCLES,
+        PERF_COUNT_HW_INSTRUCTIONS,
+        PERF_COUNT_HW_CACHE_MISSES,
+        PERF_COUNT_HW_BRANCH_MISSES
+    };
+
+} // namespace
+
+PerfSample& PerfSample::operator+=(const PerfSample& other) {
+    for (int i = 0; i < PerfEventCount; ++i) {
+        values[i] += other.values[i];
+        valid[i] = valid[i] || other.valid[i];
+    }
+    return *this;
+}
+
+/**
+ * O primeiro evento que abrir vira o líder do grupo. Um evento que não
+ * existir na CPU (comum em VMs) fica de fora sem derrubar os outros.
+ */
+PerfCounters::PerfCounters() {
+    for (int i = 0; i < PerfEventCount; ++i) {
+        fds_[i] = openCounter(kConfigs[i], leader_);
+        if (fds_[i] < 0) {
+            continue;
+        }
+        if (leader_ < 0) {
+            leader_ = fds_[i];
+        }
+        slot_[i] = members_++;
+    }
+    if (leader_ >= 0) {
+        ioctl(leader_, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+        ioctl(leader_, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    }
+}
+
+PerfCounters::~PerfCounters() {
+    // Membros antes do líder.
+    for (int i = PerfEventCount - 1; i >= 0; --i) {
+        if (fds_[i] >= 0) {
+            close(fds_[i]);
+        }
+    }
+}
+
+bool PerfCounters::available() const {
+    return leader_ >= 0;
+}
+
+/**
+ * Lê o grupo de uma vez: { nr, time_enabled, time_running, values[nr] }.
+ */
+bool PerfCounters::readAll(PerfReading& out) const {
+    uint64_t buf[3 + PerfEventCount];
+    const ssize_t expected = static_cast<ssize_t>((3 + members_) * sizeof(uint64_t));
+    if (read(leader_, buf, sizeof(buf)) != expected || buf[0] != static_cast<uint64_t>(members_)) {
+        return false;
+    }
+    out.enabled = buf[1];
+    out.running = buf[2];
+    for (int i = 0; i < PerfEventCount; ++i) {
+        out.present[i] = fds_[i] >= 0;
+        out.values[i] = out.present[i] ? buf[3 + slot_[i]] : 0;
+    }
+    return true;
+}
+
+void PerfCounters::begin() {
+    if (available()) {
+        readAll(start_);
+    }
+}
+
+/**
+ * Se o grupo dividiu a PMU com outros eventos, só contou parte do tempo:
+ * o valor é extrapolado por enabled/running.
+ */
+PerfSample perfDelta(const PerfReading& start, const PerfReading& now) {
+    PerfSample out;
+    const uint64_t enabled = now.enabled - start.enabled;
+    const uint64_t running = now.running - start.running;
+    if (running == 0) {
+        return out;
+    }
+    const double scale = static_cast<double>(enabled) / running;
+    for (int i = 0; i < PerfEventCount; ++i) {
+        if (now.present[i]) {
+            out.values[i] = static_cast<uint64_t>((now.values[i] - start.values[i]) * scale);
+            out.valid[i] = true;
+        }
+    }
+    return out;
+}
+
+/**
+ * Soma o intervalo desde begin() (ver perfDelta).
+ */
+void PerfCounters::end() {
+    PerfReading now;
+    if (!available() || !readAll(now)) {
+        return;
+    }
+    total_ += perfDelta(start_, now);
+}
+
+/**
+ * Devolve o acumulado desde a última chamada e zera o total.
+ */
+PerfSample PerfCounters::take() {
+    PerfSample out = total_;
+    total_ = PerfSample();
+    return out;
+}
+
+/**
+ * Formata ciclos/hash, IPC e falhas de cache/desvio por mil hashes.
+ */
+void printPerfLine(std::ostream& os, const std::string& label, const PerfSample& sample, uint64_t hashes) {
+    if (hashes == 0 || !(sample.valid[PerfCycles] || sample.valid[PerfInstructions])) {
+        os << "Perf [" << label << "]: counters unavailable\n";
+        return;
+    }
+    // Monta a linha numa stream local para não mexer nos formatos de os
+    std::ostringstream line;
+    const double h = static_cast<double>(hashes);
+    line << "Perf [" << label << "]:" << std::fixed << std::setprecision(1);
+    if (sample.valid[PerfCycles]) {
+        line << " cycles/hash=" << sample.values[PerfCycles] / h;
+    }
+    if (sample.valid[PerfCycles] && sample.valid[PerfInstructions] && sample.values[PerfCycles] > 0) {
+        line << " IPC=" << std::setprecision(2)
+             << static_cast<double>(sample.values[PerfInstructions]) / sample.values[PerfCycles]
+             << std::setprecision(1);
+    }
+    if (sample.valid[PerfCacheMisses]) {
+        line << " cache-miss/khash=" << sample.values[PerfCacheMisses] * 1000.0 / h;
+    }
+    if (sample.valid[PerfBranchMisses]) {
+        line << " branch-miss/khash=" << sample.values[PerfBranchMisses] * 1000.0 / h;
+    }
+    line << "\n";
+    os << line.str();
+}
+
+} // namespace nerdminer
@@ -0,0 +1,168 @@
+/**
+* Project: nerdminer-rpi
+* File: share_verifier.cpp
+* Description: rechecks candidate shares with the reference hasher before submission
+*
+* Author: Regis Araujo Melo
+* Date: 2025-04-21
+* Version: 0.1.0
+*
+* MIT License
+* © 2025 Regis Araujo Melo
+*/
+
+#include "nerdminer/share_verifier.h"
+#include "nerdminer/nerdminer_block.h"
+#include "nerdminer/trace.h"
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+namespace nerdminer {
+
+ShareVerifier::ShareVerifier(SubmitFn submit, uint32_t maxMismatches, std::size_t maxQueue)
+    : submit_(std::move(submit)),
+    maxMismatches_(maxMismatches),
+    maxQueue_(maxQueue),
+    worker_(&ShareVerifier::run, this) {}
+
+ShareVerifier::~ShareVerifier() {
+    stop();
+}
+
+void ShareVerifier::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    cv_.notify_all();
+    if (worker_.joinable()) {
+        worker_.join();
+    }
+}
+
+void ShareVerifier::drain() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    idleCv_.wait(lock, [this] { return queue_.empty() && !busy_; });
+}
+
+/**
+ * Entrega um candidato para verificação. Não bloqueia a thread de mineração:
+ * se a fila estiver cheia o candidato é descartado e contado.
+ * @param candidate O candidato encontrado pelo kernel.
+ */
+void ShareVerifier::enqueue(ShareCandidate candidate) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (stopping_ || queue_.size() >= maxQueue_) {
+            stateFor(candidate.kernel).stats.dropped++;
+            return;
+        }
+        queue_.push_back(std::move(candidate));
+    }
+    cv_.notify_one();
+}
+
+/**
+ * Flag consultada pelas threads de mineração entre lotes; vira true quando o
+ * kernel acumula maxMismatches divergências com o caminho de referência.
+ * @param kernel Nome do kernel.
+ * @return Referência estável para a flag do kernel.
+ */
+const std::atomic<bool>& ShareVerifier::disabledFlag(const std::string& kernel) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stateFor(kernel).disabled;
+}
+
+std::map<std::string, KernelVerifyStats> ShareVerifier::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::map<std::string, KernelVerifyStats> out;
+    for (const auto& entry : kernels_) {
+        out[entry.first] = entry.second->stats;
+        out[entry.first].disabled = entry.second->disabled.load();
+    }
+    return out;
+}
+
+void ShareVerifier::printStats(std::ostream& os) const {
+    for (const auto& entry : stats()) {
+        const auto& s = entry.second;
+        double avgMicros = s.verified ? static_cast<double>(s.verifyNanos) / s.verified / 1000.0 : 0.0;
+        // Stream local: os formatos não vazam para o stream do chamador
+        std::ostringstream line;
+        line << "Verify [" << entry.first << "]: checked=" << s.verified
+             << " mismatches=" << s.mismatches
+             << " dropped=" << s.dropped
+             << " avg=" << std::fixed << std::setprecision(1) << avgMicros << "us"
+             << (s.disabled ? " DISABLED" : "") << "\n";
+        os << line.str();
+    }
+}
+
+ShareVerifier::KernelState& ShareVerifier::stateFor(const std::string& kernel) {
+    auto& state = kernels_[kernel];
+    if (!state) {
+        state = std::make_unique<KernelState>();
+    }
+    return *state;
+}
+
+void ShareVerifier::run() {
+    traceSetThreadName("share-verifier");
+    for (;;) {
+        ShareCandidate candidate;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            cv_.wait(lock, [this] { return stopping_ || !queue_.empty(); });
+            if (queue_.empty()) {
+                return;
+            }
+            candidate = std::move(queue_.front());
+            queue_.pop_front();
+            busy_ = true;
+        }
+
+        TraceSpan span("share.verify", candidate.nonce);
+        auto start = std::chrono::steady_clock::now();
+        BlockHeader header = candidate.job.buildHeader(candidate.extranonce1, candidate.extranonce2, candidate.nonce);
+        header.timestamp = candidate.ntime;
+        auto hash = doubleSHA256(buildBlockHeader(header));
+        bool ok = hash == candidate.hash && isHashBelowTarget(hash, candidate.job.target());
+        auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+
+        bool justDisabled = false;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto& state = stateFor(candidate.kernel);
+            state.stats.verified++;
+            state.stats.verifyNanos += elapsed.count();
+            if (!ok) {
+                state.stats.mismatches++;
+                if (state.stats.mismatches >= maxMismatches_ && !state.disabled) {
+                    state.disabled = true;
+                    justDisabled = true;
+                }
+            }
+        }
+
+        if (ok) {
+            submit_(candidate);
+        } else {
+            std::cerr << "\033[1;31m[!] Kernel '" << candidate.kernel << "' produced an invalid share (nonce "
+                      << candidate.nonce << ", hash " << bytesToHex(candidate.hash)
+                      << ", reference " << bytesToHex(hash) << ")\033[0m" << std::endl;
+            if (justDisabled) {
+                std::cerr << "\033[1;31m[!] Kernel '" << candidate.kernel << "' disabled after "
+                          << maxMismatches_ << " mismatch(es)\033[0m" << std::endl;
+            }
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            busy_ = false;
+        }
+        idleCv_.notify_all();
+    }
+}
+
+} // namespace nerdminer
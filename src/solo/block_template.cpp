@@ -0,0 +1,248 @@
+/**
+* Project: nerdminer-rpi
+* File: block_template.cpp
+* Description: getblocktemplate parsing and block/coinbase serialization for solo mining
+*
+* Author: Regis Araujo Melo
+* Date: 2025-04-21
+* Version: 0.1.0
+*
+* MIT License
+* © 2025 Regis Araujo Melo
+*/
+
+#include "nerdminer/block_template.h"
+#include "nerdminer/nerdminer_block.h"
+#include "nerdminer/hex.h"
+#include <algorithm>
+#include <stdexcept>
+
+namespace nerdminer {
+
+namespace {
+
+    std::string hexLE(uint64_t value, std::size_t bytes) {
+        std::vector<uint8_t> out(bytes);
+        for (std::size_t i = 0; i < bytes; ++i) {
+            out[i] = static_cast<uint8_t>(value >> (8 * i));
+        }
+        return encodeHex(out.data(), out.size());
+    }
+
+    std::string pushData(const std::string& hex) {
+        const std::size_t size = hex.size() / 2;
+        if (size >= 0x4c) {
+            throw std::invalid_argument("push too large for coinbase script");
+        }
+        return hexLE(size, 1) + hex;
+    }
+
+    std::string dsha(const std::string& left, const std::string& right) {
+        std::vector<uint8_t> data = decodeHex(left + right);
+        return bytesToHex(doubleSHA256(data));
+    }
+
+} // namespace
+
+/**
+ * Lê o resultado do getblocktemplate.
+ * @param result Campo "result" da resposta json-rpc.
+ * @return O template; lança std::invalid_argument se faltar algum campo.
+ */
+BlockTemplate BlockTemplate::fromJson(const json& result) {
+    BlockTemplate tmpl;
+    try {
+        tmpl.version = result.at("version").get<uint32_t>();
+        tmpl.height = result.at("height").get<uint32_t>();
+        tmpl.curtime = result.at("curtime").get<uint32_t>();
+        tmpl.coinbaseValue = result.at("coinbasevalue").get<uint64_t>();
+        tmpl.previousBlockHash = result.at("previousblockhash").get<std::string>();
+        if (!parseHexU32(result.at("bits").get<std::string>(), tmpl.bits)) {
+            throw std::invalid_argument("malformed bits");
+        }
+        if (!isHex(tmpl.previousBlockHash, 32)) {
+            throw std::invalid_argument("malformed previousblockhash");
+        }
+        if (result.contains("default_witness_commitment")) {
+            tmpl.witnessCommitment = result["default_witness_commitment"].get<std::string>();
+            if (!isHex(tmpl.witnessCommitment)) {
+                throw std::invalid_argument("malformed default_witness_commitment");
+            }
+        }
+        if (result.contains("longpollid")) {
+            tmpl.longpollId = result["longpollid"].get<std::string>();
+        }
+        for (const auto& tx : result.at("transactions")) {
+            std::string txid = tx.at("txid").get<std::string>();
+            std::string data = tx.at("data").get<std::string>();
+            if (!isHex(txid, 32) || !isHex(data)) {
+                throw std::invalid_argument("malformed transaction");
+            }
+            tmpl.txids.push_back(std::move(txid));
+            tmpl.txData.push_back(std::move(data));
+        }
+    } catch (const json::exception& e) {
+        throw std::invalid_argument(std::string("malformed block template: ") + e.what());
+    }
+    return tmpl;
+}
+
+/**
+ * Inverte a ordem dos bytes de uma string hex (hash exibido <-> ordem interna).
+ */
+std::string reverseHexBytes(const std::string& hex) {
+    std::vector<uint8_t> bytes = decodeHex(hex);
+    std::reverse(bytes.begin(), bytes.end());
+    return encodeHex(bytes.data(), bytes.size());
+}
+
+/**
+ * CompactSize do protocolo (contagem de transações, tamanho de script).
+ */
+std::string encodeVarInt(uint64_t value) {
+    if (value < 0xfd) {
+        return hexLE(value, 1);
+    } else if (value <= 0xffff) {
+        return "fd" + hexLE(value, 2);
+    } else if (value <= 0xffffffffull) {
+        return "fe" + hexLE(value, 4);
+    }
+    return "ff" + hexLE(value, 8);
+}
+
+/**
+ * Empilha um número no script como o Bitcoin Core (CScript() << n), que é o
+ * formato exigido pelo BIP 34 para a altura no início do scriptSig.
+ */
+std::string pushScriptNum(int64_t value) {
+    if (value == 0) {
+        return "00"; // OP_0
+    }
+    if (value >= 1 && value <= 16) {
+        return hexLE(0x50 + value, 1); // OP_1 .. OP_16
+    }
+    const bool negative = value < 0;
+    uint64_t abs = negative ? uint64_t(-value) : uint64_t(value);
+    std::vector<uint8_t> bytes;
+    while (abs) {
+        bytes.push_back(static_cast<uint8_t>(abs & 0xFF));
+        abs >>= 8;
+    }
+    if (bytes.back() & 0x80) {
+        bytes.push_back(negative ? 0x80 : 0x00);
+    } else if (negative) {
+        bytes.back() |= 0x80;
+    }
+    return pushData(encodeHex(bytes.data(), bytes.size()));
+}
+
+/**
+ * Monta a coinbase do bloco solo, sem witness (é a serialização do txid),
+ * partida em volta do extranonce como no mining.notify.
+ * scriptSig: altura (BIP 34) + extranonce + tag.
+ * @param tmpl O template.
+ * @param payoutScript scriptPubKey que recebe a recompensa.
+ * @param extranonceSize Bytes de extranonce (extranonce1 + extranonce2).
+ * @param tag Texto gravado no scriptSig; truncado se necessário.
+ * @return coinbase1 e coinbase2.
+ */
+CoinbaseParts buildSoloCoinbase(const BlockTemplate& tmpl, const std::string& payoutScript,
+    std::size_t extranonceSize, const std::string& tag) {
+    if (!isHex(payoutScript) || payoutScript.empty()) {
+        throw std::invalid_argument("malformed payout script");
+    }
+    const std::string heightPush = pushScriptNum(tmpl.height);
+    const std::string extranoncePush = hexLE(extranonceSize, 1);
+    // O scriptSig da coinbase é limitado a 100 bytes.
+    const std::size_t fixed = heightPush.size() / 2 + 1 + extranonceSize + 1;
+    if (fixed > 100) {
+        throw std::invalid_argument("extranonce too large for coinbase script");
+    }
+    const std::string tagBytes = tag.substr(0, std::min<std::size_t>({tag.size(), 100 - fixed, 0x4b}));
+    const std::string tagPush = pushData(encodeHex(reinterpret_cast<const uint8_t*>(tagBytes.data()), tagBytes.size()));
+    const std::size_t scriptSize = fixed + tagBytes.size();
+
+    CoinbaseParts parts;
+    parts.coinbase1 = "02000000"                          // versão
+        "01"                                              // uma entrada
+        + std::string(64, '0') + "ffffffff"               // prevout nulo
+        + encodeVarInt(scriptSize)
+        + heightPush + extranoncePush;
+
+    std::string outputs = hexLE(tmpl.coinbaseValue, 8) + encodeVarInt(payoutScript.size() / 2) + payoutScript;
+    std::size_t outputCount = 1;
+    if (!tmpl.witnessCommitment.empty()) {
+        outputs += hexLE(0, 8) + encodeVarInt(tmpl.witnessCommitment.size() / 2) + tmpl.witnessCommitment;
+        outputCount++;
+    }
+    parts.coinbase2 = tagPush + "ffffffff"                // sequence
+        + encodeVarInt(outputCount) + outputs
+        + "00000000";                                     // locktime
+    return parts;
+}
+
+/**
+ * Serialização com witness da coinbase (BIP 141): marker/flag e o valor
+ * reservado de 32 bytes zerados, exigidos quando o bloco tem commitment.
+ * @param coinbase Coinbase sem witness (coinbase1 + extranonce + coinbase2).
+ */
+std::string addCoinbaseWitness(const std::string& coinbase) {
+    if (coinbase.size() < 16) {
+        throw std::invalid_argument("coinbase too short");
+    }
+    return coinbase.substr(0, 8) + "0001"
+        + coinbase.substr(8, coinbase.size() - 16)
+        + "0120" + std::string(64, '0')
+        + coinbase.substr(coinbase.size() - 8);
+}
+
+/**
+ * Ramos Merkle da coinbase para a lista de transações do bloco, no formato
+ * do mining.notify.
+ * @param txids Txids das demais transações, em ordem interna.
+ * @return Ramos em ordem interna, do nível mais baixo para o mais alto.
+ */
+std::vector<std::string> merkleBranchesFor(const std::vector<std::string>& txids) {
+    std::vector<std::string> branches;
+    // level[0] é a posição da coinbase, desconhecida até o extranonce ser escolhido.
+    std::vector<std::string> level;
+    level.reserve(txids.size() + 1);
+    level.emplace_back();
+    level.insert(level.end(), txids.begin(), txids.end());
+    while (level.size() > 1) {
+        branches.push_back(level[1]);
+        if (level.size() % 2) {
+            level.push_back(level.back());
+        }
+        std::vector<std::string> next;
+        next.emplace_back();
+        for (std::size_t i = 2; i < level.size(); i += 2) {
+            next.push_back(dsha(level[i], level[i + 1]));
+        }
+        level = std::move(next);
+    }
+    return branches;
+}
+
+/**
+ * Raiz Merkle de uma lista completa de txids (ordem interna).
+ */
+std::string merkleRootOf(const std::vector<std::string>& txids) {
+    if (txids.empty()) {
+        throw std::invalid_argument("empty transaction list");
+    }
+    std::vector<std::string> level = txids;
+    while (level.size() > 1) {
+        if (level.size() % 2) {
+            level.push_back(level.back());
+        }
+        std::vector<std::string> next;
+        for (std::size_t i = 0; i < level.size(); i += 2) {
+            next.push_back(dsha(level[i], level[i + 1]));
+        }
+        level = std::move(next);
+    }
+    return level[0];
+}
+
+} // namespace nerdminer
@@ -0,0 +1,145 @@
+/**
+* Project: nerdminer-rpi
+* File: gbt_client.cpp
+* Description: bitcoind JSON-RPC client over HTTP (basic auth) for solo mining
+*
+* Author: Regis Araujo Melo
+* Date: 2025-04-21
+* Version: 0.1.0
+*
+* MIT License
+* © 2025 Regis Araujo Melo
+*/
+
+#include "nerdminer/gbt_client.h"
+#include <boost/asio.hpp>
+#include <boost/beast/core.hpp>
+#include <boost/beast/http.hpp>
+#include <stdexcept>
+
+namespace nerdminer {
+
+namespace {
+
+    std::string base64(const std::string& in) {
+        static constexpr char kAlphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+        std::string out;
+        out.reserve((in.size() + 2) / 3 * 4);
+        std::size_t i = 0;
+        for (; i + 2 < in.size(); i += 3) {
+            uint32_t v = (uint8_t(in[i]) << 16) | (uint8_t(in[i + 1]) << 8) | uint8_t(in[i + 2]);
+            out += kAlphabet[(v >> 18) & 63];
+            out += kAlphabet[(v >> 12) & 63];
+            out += kAlphabet[(v >> 6) & 63];
+            out += kAlphabet[v & 63];
+        }
+        if (i + 1 == in.size()) {
+            uint32_t v = uint8_t(in[i]) << 16;
+            out += kAlphabet[(v >> 18) & 63];
+            out += kAlphabet[(v >> 12) & 63];
+            out += "==";
+        } else if (i + 2 == in.size()) {
+            uint32_t v = (uint8_t(in[i]) << 16) | (uint8_t(in[i + 1]) << 8);
+            out += kAlphabet[(v >> 18) & 63];
+            out += kAlphabet[(v >> 12) & 63];
+            out += kAlphabet[(v >> 6) & 63];
+            out += '=';
+        }
+        return out;
+    }
+
+} // namespace
+
+GbtClient::GbtClient(const std::string& host, uint16_t port, const std::string& user, const std::string& password)
+    : host_(host), port_(port) {
+    if (!user.empty() || !password.empty()) {
+        authorization_ = "Basic " + base64(user + ":" + password);
+    }
+}
+
+/**
+ * Executa uma chamada json-rpc 1.0 e devolve o campo "result".
+ * @param method Nome do método (ex.: "getblocktemplate").
+ * @param params Array de parâmetros.
+ * @param timeout Limite para a chamada inteira; zero para long poll.
+ * @return O resultado da chamada.
+ */
+json GbtClient::call(const std::string& method, const json& params, std::chrono::seconds timeout) const {
+    namespace beast = boost::beast;
+    namespace http = beast::http;
+    using tcp = boost::asio::ip::tcp;
+
+    const int id = requestId_++;
+    json request = {{"jsonrpc", "1.0"}, {"id", id}, {"method", method}, {"params", params}};
+
+    http::response<http::string_body> response;
+    try {
+        boost::asio::io_context io;
+        tcp::resolver resolver(io);
+        beast::tcp_stream stream(io);
+        if (timeout.count() > 0) {
+            stream.expires_after(timeout);
+        }
+
+        http::request<http::string_body> req{http::verb::post, "/", 11};
+        req.set(http::field::host, host_);
+        req.set(http::field::content_type, "application/json");
+        if (!authorization_.empty()) {
+            req.set(http::field::authorization, authorization_);
+        }
+        req.body() = request.dump();
+        req.prepare_payload();
+
+        // Operações assíncronas só para poder interromper um long poll em cancel().
+        beast::error_code result;
+        beast::flat_buffer buffer;
+        stream.async_connect(resolver.resolve(host_, std::to_string(port_)),
+            [&](beast::error_code ec, const tcp::endpoint&) {
+                if (ec) {
+                    result = ec;
+                    return;
+                }
+                http::async_write(stream, req, [&](beast::error_code ec, std::size_t) {
+                    if (ec) {
+                        result = ec;
+                        return;
+                    }
+                    http::async_read(stream, buffer, response, [&](beast::error_code ec, std::size_t) {
+                        result = ec;
+                    });
+                });
+            });
+        while (!io.stopped()) {
+            io.run_for(std::chrono::milliseconds(200));
+            if (cancelled_) {
+                stream.cancel();
+            }
+        }
+        if (cancelled_) {
+            throw std::runtime_error(method + ": cancelled");
+        }
+        if (result) {
+            throw boost::system::system_error(result);
+        }
+
+        beast::error_code ec;
+        stream.socket().shutdown(tcp::socket::shutdown_both, ec);
+    } catch (const boost::system::system_error& e) {
+        throw std::runtime_error(method + ": " + e.what());
+    }
+
+    if (response.result() == http::status::unauthorized) {
+        throw std::runtime_error(method + ": RPC authentication failed");
+    }
+    // O bitcoind responde erros de RPC com HTTP 500 e o corpo json-rpc normal.
+    json reply = json::parse(response.body(), nullptr, false);
+    if (reply.is_discarded() || !reply.is_object()) {
+        throw std::runtime_error(method + ": HTTP " + std::to_string(response.result_int()) + " without a json-rpc body");
+    }
+    if (reply.contains("error") && !reply["error"].is_null()) {
+        throw std::runtime_error(method + ": " + reply["error"].dump());
+    }
+    return reply.contains("result") ? reply["result"] : json();
+}
+
+} // namespace nerdminer
@@ -0,0 +1,223 @@
+/**
+* Project: nerdminer-rpi
+* File: gbt_work_source.cpp
+* Description: solo-mining work source: getblocktemplate in, submitblock out
+*
+* Author: Regis Araujo Melo
+* Date: 2025-04-21
+* Version: 0.1.0
+*
+* MIT License
+* © 2025 Regis Araujo Melo
+*/
+
+#include "nerdminer/gbt_work_source.h"
+#include "nerdminer/hex.h"
+#include "nerdminer/nerdminer_block.h"
+#include "nerdminer/trace.h"
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <thread>
+
+namespace nerdminer {
+
+GbtWorkSource::GbtWorkSource(const SoloConfig& config)
+    : config_(config),
+    rpc_(config.host, config.port, config.rpcUser, config.rpcPassword) {
+    // Extranonce1 aleatório: duas instâncias pagando ao mesmo endereço não
+    // repetem o trabalho uma da outra.
+    std::random_device rd;
+    uint8_t en1[kExtranonce1Size];
+    for (auto& byte : en1) {
+        byte = static_cast<uint8_t>(rd());
+    }
+    extranonce1_ = encodeHex(en1, sizeof(en1));
+}
+
+GbtWorkSource::~GbtWorkSource() {
+    stop();
+}
+
+std::string GbtWorkSource::name() const {
+    return "solo:" + config_.host + ":" + std::to_string(config_.port);
+}
+
+void GbtWorkSource::start() {
+    // Uma fonte parada pode ser iniciada de novo (SIGHUP reconfigura sem recriar).
+    stopping_ = false;
+    rpc_.resume();
+    std::cout << "Connecting to node " << config_.host << ":" << config_.port << "...\n";
+    json address = rpc_.call("validateaddress", json::array({config_.payoutAddress}));
+    if (!address.value("isvalid", false) || !address.contains("scriptPubKey")) {
+        throw std::runtime_error("node rejected payout address " + config_.payoutAddress);
+    }
+    payoutScript_ = address["scriptPubKey"].get<std::string>();
+    std::cout << "Paying block rewards to " << config_.payoutAddress << std::endl;
+    poller_ = std::thread(&GbtWorkSource::pollLoop, this);
+}
+
+void GbtWorkSource::stop() {
+    stopping_ = true;
+    rpc_.cancel();
+    if (poller_.joinable()) {
+        poller_.join();
+    }
+}
+
+void GbtWorkSource::pollLoop() {
+    traceSetThreadName("gbt-poll");
+    std::string longpollId;
+    std::string lastPrevHash;
+    auto lastPublish = std::chrono::steady_clock::now();
+    while (!stopping_) {
+        json request = {{"rules", json::array({"segwit"})}};
+        const bool longpoll = !longpollId.empty() && !refresh_;
+        if (longpoll) {
+            request["longpollid"] = longpollId;
+        }
+        BlockTemplate tmpl;
+        try {
+            json result = rpc_.call("getblocktemplate", json::array({request}),
+                longpoll ? std::chrono::seconds(0) : std::chrono::seconds(30));
+            tmpl = BlockTemplate::fromJson(result);
+        } catch (const std::exception& e) {
+            if (stopping_) {
+                break;
+            }
+            std::cerr << "getblocktemplate failed: " << e.what() << std::endl;
+            longpollId.clear();
+            for (unsigned i = 0; i < config_.pollSeconds * 10 && !stopping_; ++i) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            }
+            continue;
+        }
+        refresh_ = false;
+
+        // Com long poll toda resposta é novidade; sem ele, só republica em
+        // bloco novo ou quando o template envelhece.
+        const auto now = std::chrono::steady_clock::now();
+        if (longpoll || tmpl.previousBlockHash != lastPrevHash
+            || now - lastPublish >= std::chrono::seconds(config_.refreshSeconds)) {
+            try {
+                publish(tmpl);
+            } catch (const std::invalid_argument& e) {
+                std::cerr << "Unusable block template: " << e.what() << std::endl;
+            }
+            lastPrevHash = tmpl.previousBlockHash;
+            lastPublish = now;
+        }
+
+        longpollId = tmpl.longpollId;
+        if (longpollId.empty()) {
+            for (unsigned i = 0; i < config_.pollSeconds * 10 && !refresh_ && !stopping_; ++i) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            }
+        }
+    }
+}
+
+/**
+ * Converte o template em um MiningJob no formato Stratum (prevhash com as
+ * palavras invertidas, campos em hex) e entrega pelo onJob.
+ * @param tmpl O template recebido do nó.
+ */
+void GbtWorkSource::publish(const BlockTemplate& tmpl) {
+    TraceSpan span("solo.publish", tmpl.height);
+    auto job = std::make_shared<SoloJob>();
+    job->tmpl = tmpl;
+    job->coinbase = buildSoloCoinbase(tmpl, payoutScript_, kExtranonce1Size + kExtranonce2Size, config_.coinbaseTag);
+    job->jobId = hexU32(static_cast<uint32_t>(nextJobId_++));
+
+    MiningJob mining;
+    mining.jobId = job->jobId;
+    std::string prev = reverseHexBytes(tmpl.previousBlockHash);
+    for (std::size_t i = 0; i < prev.size(); i += 8) {
+        for (std::size_t b = 0; b < 2; ++b) {
+            std::swap(prev[i + 2 * b], prev[i + 6 - 2 * b]);
+            std::swap(prev[i + 2 * b + 1], prev[i + 7 - 2 * b]);
+        }
+    }
+    mining.prevHash = prev;
+    mining.coinbase1 = job->coinbase.coinbase1;
+    mining.coinbase2 = job->coinbase.coinbase2;
+    std::vector<std::string> txids;
+    txids.reserve(tmpl.txids.size());
+    for (const auto& txid : tmpl.txids) {
+        txids.push_back(reverseHexBytes(txid));
+    }
+    mining.merkleBranches = merkleBranchesFor(txids);
+    mining.versionInt = tmpl.version;
+    mining.bits = tmpl.bits;
+    mining.ntime = tmpl.curtime;
+    mining.version = hexU32(tmpl.version);
+    mining.nBits = hexU32(tmpl.bits);
+    mining.nTime = hexU32(tmpl.curtime);
+    mining.cleanJobs = true;
+    mining.valid = true;
+
+    {
+        std::lock_guard<std::mutex> lock(jobsMutex_);
+        jobs_.push_back(job);
+        while (jobs_.size() > kKeptJobs) {
+            jobs_.pop_front();
+        }
+    }
+    if (onJob) {
+        onJob(mining, extranonce1_, kExtranonce2Size, 0);
+    }
+    std::cout << "New block template: height " << tmpl.height << ", " << tmpl.txids.size()
+              << " transactions, job " << job->jobId << std::endl;
+}
+
+std::shared_ptr<const GbtWorkSource::SoloJob> GbtWorkSource::findJob(const std::string& jobId) {
+    std::lock_guard<std::mutex> lock(jobsMutex_);
+    for (const auto& job : jobs_) {
+        if (job->jobId == jobId) {
+            return job;
+        }
+    }
+    return nullptr;
+}
+
+/**
+ * Monta o bloco completo para o hash que atingiu o alvo e envia ao nó.
+ * Roda na thread do verificador.
+ * @param candidate O share verificado (aqui, um bloco).
+ */
+void GbtWorkSource::submitShare(const ShareCandidate& candidate) {
+    auto job = findJob(candidate.job.jobId);
+    if (!job) {
+        std::cerr << "Dropping block for expired job " << candidate.job.jobId << std::endl;
+        return;
+    }
+    TraceSpan span("solo.submitblock", candidate.nonce);
+
+    BlockHeader header = candidate.job.buildHeader(candidate.extranonce1, candidate.extranonce2, candidate.nonce);
+    header.timestamp = candidate.ntime;
+    std::string coinbase = job->coinbase.coinbase1 + candidate.extranonce1 + candidate.extranonce2 + job->coinbase.coinbase2;
+    if (!job->tmpl.witnessCommitment.empty()) {
+        coinbase = addCoinbaseWitness(coinbase);
+    }
+    std::string block = bytesToHex(buildBlockHeader(header)) + encodeVarInt(job->tmpl.txData.size() + 1) + coinbase;
+    for (const auto& tx : job->tmpl.txData) {
+        block += tx;
+    }
+
+    std::cout << "\033[1;32m[*] Block candidate at height " << job->tmpl.height << " (nonce "
+              << candidate.nonce << "), submitting...\033[0m" << std::endl;
+    try {
+        json result = rpc_.call("submitblock", json::array({block}));
+        if (result.is_null()) {
+            std::cout << "\033[1;32m[*] Block accepted!\033[0m" << std::endl;
+        } else {
+            std::cout << "\033[1;31m[!] Block rejected: " << result.dump() << "\033[0m" << std::endl;
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "\033[1;31m[!] submitblock failed: " << e.what() << "\033[0m" << std::endl;
+    }
+    refresh_ = true;
+}
+
+} // namespace nerdminer
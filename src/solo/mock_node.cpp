@@ -0,0 +1,326 @@
+/**
+* Project: nerdminer-rpi
+* File: mock_node.cpp
+* Description: minimal bitcoind stand-in (getblocktemplate/submitblock) for solo mining tests
+*
+* Author: Regis Araujo Melo
+* Date: 2025-04-21
+* Version: 0.1.0
+*
+* MIT License
+* © 2025 Regis Araujo Melo
+*/
+
+#include "nerdminer/mock_node.h"
+#include "nerdminer/block_template.h"
+#include "nerdminer/nerdminer_block.h"
+#include "nerdminer/hex.h"
+#include <boost/beast/core.hpp>
+#include <boost/beast/http.hpp>
+#include <chrono>
+#include <ctime>
+#include <iostream>
+#include <stdexcept>
+#include <thread>
+
+namespace nerdminer {
+
+namespace {
+
+    struct RpcError : std::runtime_error {
+        RpcError(int code, const std::string& message) : std::runtime_error(message), code(code) {}
+        int code;
+    };
+
+    struct Reader {
+        const std::vector<uint8_t>& data;
+        std::size_t pos = 0;
+
+        const uint8_t* take(uint64_t n) {
+            if (data.size() - pos < n) {
+                throw RpcError(-22, "Block decode failed");
+            }
+            const uint8_t* p = data.data() + pos;
+            pos += n;
+            return p;
+        }
+
+        uint64_t varint() {
+            const uint8_t first = *take(1);
+            if (first < 0xfd) {
+                return first;
+            }
+            const int size = first == 0xfd ? 2 : first == 0xfe ? 4 : 8;
+            const uint8_t* p = take(size);
+            uint64_t value = 0;
+            for (int i = 0; i < size; ++i) {
+                value |= uint64_t(p[i]) << (8 * i);
+            }
+            return value;
+        }
+    };
+
+    /**
+     * Lê uma transação (com ou sem witness) e devolve o txid em ordem interna,
+     * calculado sobre a serialização sem witness.
+     */
+    std::string readTxid(Reader& r) {
+        std::vector<uint8_t> stripped;
+        auto copyFrom = [&](std::size_t from) {
+            stripped.insert(stripped.end(), r.data.begin() + from, r.data.begin() + r.pos);
+        };
+        std::size_t start = r.pos;
+        r.take(4);
+        copyFrom(start);
+        bool witness = false;
+        if (r.data.size() - r.pos >= 2 && r.data[r.pos] == 0 && r.data[r.pos + 1] == 1) {
+            witness = true;
+            r.take(2);
+        }
+        start = r.pos;
+        const uint64_t inputs = r.varint();
+        for (uint64_t i = 0; i < inputs; ++i) {
+            r.take(36);
+            r.take(r.varint());
+            r.take(4);
+        }
+        const uint64_t outputs = r.varint();
+        for (uint64_t i = 0; i < outputs; ++i) {
+            r.take(8);
+            r.take(r.varint());
+        }
+        copyFrom(start);
+        if (witness) {
+            for (uint64_t i = 0; i < inputs; ++i) {
+                const uint64_t items = r.varint();
+                for (uint64_t j = 0; j < items; ++j) {
+                    r.take(r.varint());
+                }
+            }
+        }
+        start = r.pos;
+        r.take(4);
+        copyFrom(start);
+        return bytesToHex(doubleSHA256(stripped));
+    }
+
+    /**
+     * scriptSig da coinbase que começa em offset (pula versão e marker/flag).
+     */
+    std::string coinbaseScript(const std::vector<uint8_t>& block, std::size_t offset) {
+        Reader r{block, offset};
+        r.take(4);
+        if (block.size() - r.pos >= 2 && block[r.pos] == 0 && block[r.pos + 1] == 1) {
+            r.take(2);
+        }
+        if (r.varint() != 1) {
+            throw RpcError(-22, "Block decode failed");
+        }
+        r.take(36);
+        const uint64_t size = r.varint();
+        const uint8_t* script = r.take(size);
+        return encodeHex(script, size);
+    }
+
+} // namespace
+
+MockNode::MockNode(const MockNodeConfig& config)
+    : config_(config) {
+    tip_ = reverseHexBytes(bytesToHex(doubleSHA256(std::vector<uint8_t>{'n', 'e', 'r', 'd'})));
+    newTemplate();
+}
+
+void MockNode::start() {
+    using tcp = boost::asio::ip::tcp;
+    boost::asio::io_context io;
+    tcp::acceptor acceptor(io, tcp::endpoint(tcp::v4(), config_.port));
+    std::cout << "Mock node listening on port " << config_.port << " (bits " << hexU32(config_.bits) << ")" << std::endl;
+    for (;;) {
+        tcp::socket socket(io);
+        acceptor.accept(socket);
+        // Uma thread por conexão: o long poll bloqueia a sua até o template mudar.
+        std::thread(&MockNode::serve, this, std::move(socket)).detach();
+    }
+}
+
+void MockNode::serve(boost::asio::ip::tcp::socket socket) {
+    namespace beast = boost::beast;
+    namespace http = beast::http;
+    beast::flat_buffer buffer;
+    for (;;) {
+        http::request<http::string_body> req;
+        beast::error_code ec;
+        http::read(socket, buffer, req, ec);
+        if (ec) {
+            return;
+        }
+
+        json reply = {{"result", nullptr}, {"error", nullptr}, {"id", nullptr}};
+        http::status status = http::status::ok;
+        try {
+            json body = json::parse(req.body(), nullptr, false);
+            if (body.is_discarded() || !body.is_object()) {
+                throw RpcError(-32700, "Parse error");
+            }
+            reply["id"] = body.value("id", json());
+            json params = body.value("params", json::array());
+            reply["result"] = dispatch(body.at("method").get<std::string>(), params);
+        } catch (const RpcError& e) {
+            reply["error"] = {{"code", e.code}, {"message", e.what()}};
+            status = http::status::internal_server_error;
+        } catch (const std::exception& e) {
+            reply["error"] = {{"code", -32700}, {"message", e.what()}};
+            status = http::status::internal_server_error;
+        }
+
+        http::response<http::string_body> res{status, req.version()};
+        res.set(http::field::content_type, "application/json");
+        res.keep_alive(req.keep_alive());
+        res.body() = reply.dump() + "\n";
+        res.prepare_payload();
+        http::write(socket, res, ec);
+        if (ec || !res.keep_alive()) {
+            return;
+        }
+    }
+}
+
+json MockNode::dispatch(const std::string& method, const json& params) {
+    if (method == "getblocktemplate") {
+        return blockTemplate(params.empty() ? json::object() : params[0]);
+    } else if (method == "submitblock") {
+        if (params.empty() || !params[0].is_string()) {
+            throw RpcError(-1, "submitblock \"hexdata\"");
+        }
+        return submitBlock(params[0].get<std::string>());
+    } else if (method == "validateaddress") {
+        const std::string address = params.empty() ? "" : params[0].get<std::string>();
+        if (address.empty()) {
+            return {{"isvalid", false}};
+        }
+        // Script P2WPKH determinístico derivado do endereço; o nó falso não decodifica bech32.
+        auto digest = doubleSHA256(std::vector<uint8_t>(address.begin(), address.end()));
+        return {{"isvalid", true}, {"address", address}, {"scriptPubKey", "0014" + encodeHex(digest.data(), 20)}};
+    }
+    throw RpcError(-32601, "Method not found");
+}
+
+/**
+ * Responde o getblocktemplate; com longpollid igual ao atual, espera o
+ * template mudar (ou o timeout do long poll).
+ */
+json MockNode::blockTemplate(const json& request) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    const std::string current = tip_ + std::to_string(templateSerial_);
+    if (request.is_object() && request.value("longpollid", "") == current) {
+        const uint64_t serial = templateSerial_;
+        changed_.wait_for(lock, std::chrono::seconds(config_.longpollSeconds),
+            [&] { return templateSerial_ != serial; });
+    }
+
+    json transactions = json::array();
+    uint64_t fees = 0;
+    for (std::size_t i = 0; i < txData_.size(); ++i) {
+        const std::string txid = reverseHexBytes(txids_[i]);
+        transactions.push_back({{"data", txData_[i]}, {"txid", txid}, {"hash", txid}, {"fee", 1000},
+            {"weight", txData_[i].size() * 2}});
+        fees += 1000;
+    }
+
+    // Commitment BIP 141: wtxid da coinbase é zero; as demais não têm witness.
+    std::vector<std::string> wtxids{std::string(64, '0')};
+    wtxids.insert(wtxids.end(), txids_.begin(), txids_.end());
+    const std::vector<uint8_t> commitment = doubleSHA256(decodeHex(merkleRootOf(wtxids) + std::string(64, '0')));
+
+    const uint32_t now = static_cast<uint32_t>(std::time(nullptr));
+    return {
+        {"version", 0x20000000},
+        {"rules", json::array({"segwit"})},
+        {"previousblockhash", tip_},
+        {"transactions", transactions},
+        {"coinbasevalue", 312500000ull + fees},
+        {"longpollid", tip_ + std::to_string(templateSerial_)},
+        {"target", bytesToHex(targetFromBits(config_.bits))},
+        {"mintime", now - 3600},
+        {"curtime", now},
+        {"bits", hexU32(config_.bits)},
+        {"height", height_},
+        {"default_witness_commitment", "6a24aa21a9ed" + bytesToHex(commitment)}
+    };
+}
+
+/**
+ * Valida um bloco como o bitcoind faria no essencial (encadeamento, bits,
+ * prova de trabalho, raiz Merkle, altura BIP 34, transações do template).
+ * @return null se aceito, ou o motivo da rejeição no formato do bitcoind.
+ */
+json MockNode::submitBlock(const std::string& blockHex) {
+    std::vector<uint8_t> block;
+    try {
+        block = decodeHex(blockHex);
+    } catch (const std::invalid_argument&) {
+        throw RpcError(-22, "Block decode failed");
+    }
+    Reader r{block};
+    const uint8_t* header = r.take(80);
+    std::vector<uint8_t> headerBytes(header, header + 80);
+    const std::string prev = reverseHexBytes(encodeHex(header + 4, 32));
+    const uint32_t bits = header[72] | (header[73] << 8) | (header[74] << 16) | (uint32_t(header[75]) << 24);
+    const std::vector<uint8_t> hash = doubleSHA256(headerBytes);
+
+    const uint64_t count = r.varint();
+    const std::size_t coinbaseOffset = r.pos;
+    std::vector<std::string> txids;
+    for (uint64_t i = 0; i < count; ++i) {
+        txids.push_back(readTxid(r));
+    }
+    if (r.pos != block.size() || txids.empty()) {
+        throw RpcError(-22, "Block decode failed");
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (prev != tip_) {
+        return "prev-blk-not-found";
+    }
+    if (bits != config_.bits) {
+        return "bad-diffbits";
+    }
+    if (!isHashBelowTarget(hash, targetFromBits(bits))) {
+        return "high-hash";
+    }
+    if (merkleRootOf(txids) != encodeHex(header + 36, 32)) {
+        return "bad-txnmrklroot";
+    }
+    if (coinbaseScript(block, coinbaseOffset).rfind(pushScriptNum(height_), 0) != 0) {
+        return "bad-cb-height";
+    }
+    if (std::vector<std::string>(txids.begin() + 1, txids.end()) != txids_) {
+        return "bad-txns-inputs-missingorspent";
+    }
+
+    tip_ = reverseHexBytes(bytesToHex(hash));
+    std::cout << "Mock node: accepted block " << tip_ << " at height " << height_ << std::endl;
+    height_++;
+    newTemplate();
+    changed_.notify_all();
+    return nullptr;
+}
+
+/**
+ * Gera um mempool sintético para o próximo bloco. Chamado com mutex_ travado.
+ */
+void MockNode::newTemplate() {
+    templateSerial_++;
+    txData_.clear();
+    txids_.clear();
+    for (std::size_t i = 0; i < config_.mempoolSize; ++i) {
+        const std::string seed = tip_ + std::to_string(templateSerial_) + ":" + std::to_string(i);
+        const std::vector<uint8_t> prevout = doubleSHA256(std::vector<uint8_t>(seed.begin(), seed.end()));
+        const std::string tx = "02000000" "01" + bytesToHex(prevout) + "00000000" "00" "ffffffff"
+            "01" "e803000000000000" "01" "51" "00000000";
+        txData_.push_back(tx);
+        txids_.push_back(bytesToHex(doubleSHA256(decodeHex(tx))));
+    }
+}
+
+} // namespace nerdminer
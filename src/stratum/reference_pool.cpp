@@ -0,0 +1,475 @@
+/**
+* Project: nerdminer-rpi
+* File: reference_pool.cpp
+* Description: local reference pool serving synthetic jobs over Stratum V1 JSON or Stratum V2 frames
+*
+* Author: Regis Araujo Melo
+* Date: 2025-04-21
+* Version: 0.1.0
+*
+* MIT License
+* © 2025 Regis Araujo Melo
+*/
+
+#include "nerdminer/reference_pool.h"
+#include "nerdminer/hex.h"
+#include "nerdminer/nerdminer_block.h"
+#include "nerdminer/offline_work_source.h"
+#include "nerdminer/sv2_codec.h"
+#include "nerdminer/trace.h"
+#include <iostream>
+
+namespace nerdminer {
+
+using tcp = boost::asio::ip::tcp;
+
+// Conexão de um minerador. Escritas enfileiradas e agrupadas como no cliente.
+class ReferencePool::Session : public std::enable_shared_from_this<Session> {
+public:
+    Session(ReferencePool& pool, tcp::socket socket, uint32_t extranonce1)
+        : pool_(pool), socket_(std::move(socket)), extranonce1_(hexU32(extranonce1)) {}
+    virtual ~Session() = default;
+
+    virtual void start() = 0;
+    virtual void sendJob(const PoolJob& job) = 0;
+
+protected:
+    void send(std::string bytes) {
+        queue_.push_back(std::move(bytes));
+        if (!writing_) {
+            doWrite();
+        }
+    }
+
+    void send(const std::vector<uint8_t>& frame) {
+        send(std::string(frame.begin(), frame.end()));
+    }
+
+    ReferencePool& pool_;
+    tcp::socket socket_;
+    std::string extranonce1_;
+
+private:
+    void doWrite() {
+        inFlight_.clear();
+        while (!queue_.empty()) {
+            inFlight_.push_back(std::move(queue_.front()));
+            queue_.pop_front();
+        }
+        if (inFlight_.empty()) {
+            writing_ = false;
+            return;
+        }
+        std::vector<boost::asio::const_buffer> buffers;
+        for (const auto& msg : inFlight_) {
+            buffers.push_back(boost::asio::buffer(msg));
+        }
+        writing_ = true;
+        auto self = shared_from_this();
+        boost::asio::async_write(socket_, buffers,
+            [this, self](const boost::system::error_code& ec, std::size_t bytes) {
+                if (ec) {
+                    writing_ = false;
+                    return;
+                }
+                pool_.bytesOut_ += bytes;
+                doWrite();
+            });
+    }
+
+    std::deque<std::string> queue_;
+    std::vector<std::string> inFlight_;
+    bool writing_ = false;
+};
+
+// Stratum V1: json-rpc por linha, extranonce2 de 4 bytes.
+class ReferencePool::JsonSession : public ReferencePool::Session {
+public:
+    using Session::Session;
+
+    void start() override {
+        doRead();
+    }
+
+    void sendJob(const PoolJob& pool) override {
+        if (!authorized_) {
+            return;
+        }
+        const MiningJob& job = pool.job;
+        json note = {
+            {"id", nullptr},
+            {"method", "mining.notify"},
+            {"params", {job.jobId, job.prevHash, job.coinbase1, job.coinbase2, job.merkleBranches,
+                job.version, job.nBits, job.nTime, job.cleanJobs}}
+        };
+        send(note.dump() + "\n");
+    }
+
+private:
+    void doRead() {
+        auto self = shared_from_this();
+        boost::asio::async_read_until(socket_, buffer_, '\n',
+            [this, self](const boost::system::error_code& ec, std::size_t bytes) {
+                if (ec) {
+                    return;
+                }
+                pool_.bytesIn_ += bytes;
+                std::istream is(&buffer_);
+                std::string line;
+                std::getline(is, line);
+                json request = json::parse(line, nullptr, false);
+                if (request.is_object()) {
+                    handle(request);
+                }
+                doRead();
+            });
+    }
+
+    void reply(const json& id, const json& result, const json& error = nullptr) {
+        send(json({{"id", id}, {"result", result}, {"error", error}}).dump() + "\n");
+    }
+
+    void handle(const json& request) {
+        const json id = request.value("id", json());
+        const std::string method = request.value("method", "");
+        const json params = request.value("params", json::array());
+        if (method == "mining.subscribe") {
+            // Retomada: [user_agent, session_id] com um id já emitido devolve o
+            // mesmo extranonce1 (aqui o id da sessão é o próprio extranonce1).
+            uint32_t previous = 0;
+            if (params.is_array() && params.size() >= 2 && params[1].is_string() &&
+                parseHexU32(params[1].get<std::string>(), previous) && previous != 0 &&
+                previous < pool_.nextExtranonce1_) {
+                extranonce1_ = hexU32(previous);
+            }
+            reply(id, {json::array({json::array({"mining.notify", extranonce1_})}), extranonce1_, 4});
+        } else if (method == "mining.authorize") {
+            authorized_ = true;
+            reply(id, true);
+            send(json({{"id", nullptr}, {"method", "mining.set_difficulty"},
+                {"params", {pool_.config_.difficulty}}}).dump() + "\n");
+            if (!pool_.jobs_.empty()) {
+                sendJob(pool_.jobs_.front());
+            }
+        } else if (method == "mining.submit") {
+            submit(id, params);
+        } else {
+            reply(id, nullptr, {20, "Unsupported method", nullptr});
+        }
+    }
+
+    void submit(const json& id, const json& params) {
+        uint32_t serial = 0;
+        uint32_t ntime = 0;
+        uint32_t nonce = 0;
+        if (!params.is_array() || params.size() < 5 || !params[1].is_string() || !params[2].is_string() ||
+            !params[3].is_string() || !params[4].is_string() || !parseHexU32(params[1].get<std::string>(), serial) ||
+            !parseHexU32(params[3].get<std::string>(), ntime) || !parseHexU32(params[4].get<std::string>(), nonce) ||
+            !isHex(params[2].get<std::string>(), 4)) {
+            pool_.rejected_++;
+            reply(id, nullptr, {20, "Malformed submit", nullptr});
+            return;
+        }
+        const PoolJob* job = pool_.findJob(serial);
+        if (job == nullptr || job != &pool_.jobs_.front()) {
+            pool_.rejected_++;
+            reply(id, nullptr, {21, job ? "Stale job" : "Job not found", nullptr});
+            return;
+        }
+        if (!pool_.checkShare(job->job, extranonce1_, params[2].get<std::string>(), ntime, nonce)) {
+            pool_.rejected_++;
+            reply(id, nullptr, {23, "Low difficulty share", nullptr});
+            return;
+        }
+        pool_.accepted_++;
+        reply(id, true);
+    }
+
+    boost::asio::streambuf buffer_;
+    bool authorized_ = false;
+};
+
+// Stratum V2: frames binários, um canal padrão por conexão. O prefixo de
+// extranonce do canal é o extranonce1 seguido de 4 bytes zero, de modo que a
+// raiz Merkle do canal é a mesma que um minerador V1 obteria com extranonce2 0.
+class ReferencePool::Sv2Session : public ReferencePool::Session {
+public:
+    using Session::Session;
+
+    void start() override {
+        doReadHeader();
+    }
+
+    void sendJob(const PoolJob& pool) override {
+        if (!channelOpen_) {
+            return;
+        }
+        const MiningJob& job = pool.job;
+        sv2::NewMiningJob newJob;
+        newJob.channelId = channelId_;
+        newJob.jobId = pool.serial;
+        newJob.version = job.versionInt;
+        const std::vector<uint8_t> root = decodeHex(channelMerkleRoot(job));
+        std::copy(root.begin(), root.end(), newJob.merkleRoot.begin());
+
+        sv2::SetNewPrevHash prevHash;
+        prevHash.channelId = channelId_;
+        prevHash.jobId = pool.serial;
+        std::array<uint8_t, 32> prev;
+        decodeHex(job.prevHash, prev);
+        for (std::size_t i = 0; i < prev.size(); i += 4) {
+            std::swap(prev[i], prev[i + 3]);
+            std::swap(prev[i + 1], prev[i + 2]);
+        }
+        prevHash.prevHash = prev;
+        prevHash.minNtime = job.ntime;
+        prevHash.nbits = job.bits;
+
+        send(newJob.encode());
+        send(prevHash.encode());
+    }
+
+private:
+    std::string channelMerkleRoot(const MiningJob& job) const {
+        return calculateMerkleRoot(buildCoinbaseTransaction(job.coinbase1, extranonce1_ + "00000000", job.coinbase2),
+            job.merkleBranches);
+    }
+
+    void doReadHeader() {
+        auto self = shared_from_this();
+        boost::asio::async_read(socket_, boost::asio::buffer(headerBuf_),
+            [this, self](const boost::system::error_code& ec, std::size_t) {
+                if (ec) {
+                    return;
+                }
+                header_ = sv2::parseFrameHeader(headerBuf_.data());
+                if (header_.length > sv2::kMaxPayloadSize) {
+                    boost::system::error_code ignored;
+                    socket_.close(ignored);
+                    return;
+                }
+                payload_.resize(header_.length);
+                boost::asio::async_read(socket_, boost::asio::buffer(payload_),
+                    [this, self](const boost::system::error_code& ec, std::size_t) {
+                        if (ec) {
+                            return;
+                        }
+                        pool_.bytesIn_ += sv2::kFrameHeaderSize + payload_.size();
+                        try {
+                            sv2::Reader reader(payload_.data(), payload_.size());
+                            handle(reader);
+                        } catch (const std::invalid_argument& e) {
+                            std::cerr << "Reference pool: malformed SV2 message: " << e.what() << std::endl;
+                        }
+                        doReadHeader();
+                    });
+            });
+    }
+
+    void handle(sv2::Reader& reader) {
+        switch (header_.msgType) {
+        case sv2::kSetupConnection: {
+            auto setup = sv2::SetupConnection::decode(reader);
+            if (setup.protocol != sv2::kMiningProtocol || setup.minVersion > sv2::kProtocolVersion ||
+                setup.maxVersion < sv2::kProtocolVersion) {
+                sv2::SetupConnectionError error;
+                error.errorCode = setup.protocol != sv2::kMiningProtocol ? "unsupported-protocol"
+                                                                          : "protocol-version-mismatch";
+                send(error.encode());
+                return;
+            }
+            send(sv2::SetupConnectionSuccess().encode());
+            break;
+        }
+        case sv2::kOpenStandardMiningChannel: {
+            auto open = sv2::OpenStandardMiningChannel::decode(reader);
+            channelId_ = static_cast<uint32_t>(std::stoul(extranonce1_, nullptr, 16));
+            sv2::OpenStandardMiningChannelSuccess success;
+            success.requestId = open.requestId;
+            success.channelId = channelId_;
+            success.target = sv2::toU256(pool_.shareTarget_);
+            success.extranoncePrefix = decodeHex(extranonce1_ + "00000000");
+            send(success.encode());
+            channelOpen_ = true;
+            if (!pool_.jobs_.empty()) {
+                sendJob(pool_.jobs_.front());
+            }
+            break;
+        }
+        case sv2::kSubmitSharesStandard:
+            submit(sv2::SubmitSharesStandard::decode(reader));
+            break;
+        default:
+            std::cerr << "Reference pool: ignored SV2 message 0x" << std::hex << int(header_.msgType) << std::dec
+                      << std::endl;
+        }
+    }
+
+    void submit(const sv2::SubmitSharesStandard& share) {
+        const PoolJob* job = pool_.findJob(share.jobId);
+        std::string error;
+        if (share.channelId != channelId_ || !channelOpen_) {
+            error = "invalid-channel-id";
+        } else if (job == nullptr) {
+            error = "invalid-job-id";
+        } else if (job != &pool_.jobs_.front()) {
+            error = "stale-share";
+        } else {
+            MiningJob header = job->job;
+            header.versionInt = share.version;
+            header.merkleRoot = channelMerkleRoot(job->job);
+            if (!pool_.checkShare(header, "", "", share.ntime, share.nonce)) {
+                error = "difficulty-too-low";
+            }
+        }
+        if (!error.empty()) {
+            pool_.rejected_++;
+            sv2::SubmitSharesError reply;
+            reply.channelId = share.channelId;
+            reply.sequenceNumber = share.sequenceNumber;
+            reply.errorCode = error;
+            send(reply.encode());
+            return;
+        }
+        pool_.accepted_++;
+        sharesSum_++;
+        sv2::SubmitSharesSuccess reply;
+        reply.channelId = channelId_;
+        reply.lastSequenceNumber = share.sequenceNumber;
+        reply.newSubmitsAcceptedCount = 1;
+        reply.newSharesSum = sharesSum_;
+        send(reply.encode());
+    }
+
+    std::array<uint8_t, sv2::kFrameHeaderSize> headerBuf_{};
+    sv2::FrameHeader header_;
+    std::vector<uint8_t> payload_;
+    bool channelOpen_ = false;
+    uint32_t channelId_ = 0;
+    uint64_t sharesSum_ = 0;
+};
+
+ReferencePool::ReferencePool(const ReferencePoolConfig& config)
+    : config_(config), shareTarget_(targetFromDifficulty(config.difficulty)), acceptor_(io_), timer_(io_) {}
+
+ReferencePool::~ReferencePool() {
+    stop();
+}
+
+void ReferencePool::start() {
+    tcp::endpoint endpoint(boost::asio::ip::make_address("127.0.0.1"), config_.port);
+    acceptor_.open(endpoint.protocol());
+    acceptor_.set_option(tcp::acceptor::reuse_address(true));
+    acceptor_.bind(endpoint);
+    acceptor_.listen();
+    port_ = acceptor_.local_endpoint().port();
+    std::cout << "Reference pool (" << (config_.protocol == PoolProtocol::Sv2 ? "sv2" : "json")
+              << ") listening on 127.0.0.1:" << port_ << std::endl;
+
+    doAccept();
+    boost::asio::post(io_, [this] { broadcast(); });
+    if (config_.jobSeconds > 0) {
+        scheduleJob();
+    }
+    thread_ = std::thread([this] {
+        traceSetThreadName("reference-pool");
+        io_.run();
+    });
+}
+
+void ReferencePool::stop() {
+    io_.stop();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+void ReferencePool::doAccept() {
+    acceptor_.async_accept([this](const boost::system::error_code& ec, tcp::socket socket) {
+        if (ec) {
+            return;
+        }
+        socket.set_option(tcp::no_delay(true));
+        std::shared_ptr<Session> session;
+        if (config_.protocol == PoolProtocol::Sv2) {
+            session = std::make_shared<Sv2Session>(*this, std::move(socket), nextExtranonce1_++);
+        } else {
+            session = std::make_shared<JsonSession>(*this, std::move(socket), nextExtranonce1_++);
+        }
+        session->start();
+        sessions_.push_back(session);
+        doAccept();
+    });
+}
+
+void ReferencePool::scheduleJob() {
+    timer_.expires_after(std::chrono::seconds(config_.jobSeconds));
+    timer_.async_wait([this](const boost::system::error_code& ec) {
+        if (ec) {
+            return;
+        }
+        broadcast();
+        scheduleJob();
+    });
+}
+
+void ReferencePool::publishJob() {
+    boost::asio::post(io_, [this] { broadcast(); });
+}
+
+void ReferencePool::broadcast() {
+    PoolJob job;
+    job.serial = nextSerial_++;
+    job.job = syntheticJob(job.serial);
+    jobs_.push_front(std::move(job));
+    if (jobs_.size() > 4) {
+        jobs_.pop_back();
+    }
+    jobCount_++;
+
+    for (auto it = sessions_.begin(); it != sessions_.end();) {
+        if (auto session = it->lock()) {
+            session->sendJob(jobs_.front());
+            ++it;
+        } else {
+            it = sessions_.erase(it);
+        }
+    }
+}
+
+const ReferencePool::PoolJob* ReferencePool::findJob(uint32_t serial) const {
+    for (const auto& job : jobs_) {
+        if (job.serial == serial) {
+            return &job;
+        }
+    }
+    return nullptr;
+}
+
+/**
+ * Reconstrói o cabeçalho do share e confere o hash contra o alvo do pool.
+ * @param job O job (com raiz Merkle pronta, no caso do canal padrão).
+ * @param extranonce1 Extranonce1 da sessão (vazio no canal padrão).
+ * @param extranonce2 Extranonce2 enviado pelo minerador (vazio no canal padrão).
+ * @param ntime ntime do share.
+ * @param nonce Nonce do share.
+ * @return True se o hash atinge o alvo.
+ */
+bool ReferencePool::checkShare(const MiningJob& job, const std::string& extranonce1, const std::string& extranonce2,
+    uint32_t ntime, uint32_t nonce) const {
+    BlockHeader header = job.buildHeader(extranonce1, extranonce2, nonce);
+    header.timestamp = ntime;
+    return isHashBelowTarget(doubleSHA256(buildBlockHeader(header)), shareTarget_);
+}
+
+ReferencePoolStats ReferencePool::stats() const {
+    ReferencePoolStats stats;
+    stats.bytesIn = bytesIn_;
+    stats.bytesOut = bytesOut_;
+    stats.jobs = jobCount_;
+    stats.accepted = accepted_;
+    stats.rejected = rejected_;
+    return stats;
+}
+
+} // namespace nerdminer
@@ -13,17 +13,14 @@
 
 #include <nerdminer/stratum_client.h>
 #include <nerdminer/miner_job.h>
+#include <nerdminer/hex.h>
+#include <nerdminer/trace.h>
+#include <nerdminer/version.h>
 #include <nlohmann/json.hpp>
 #include <string>
 #include <iostream>
 #include <functional>
-#include <iomanip>
-
-static std::string toHex(uint32_t value, int width = 8) {
-    std::stringstream ss;
-    ss << std::hex << std::setfill('0') << std::setw(width) << value;
-    return ss.str();
-}
+#include <algorithm>
 
  namespace nerdminer {
 
@@ -34,7 +31,8 @@ static std::string toHex(uint32_t value, int width = 8) {
         port_(port),
         user_(user), 
         password_(password), 
-        requestId_(0) {}
+        requestId_(0),
+        reconnectTimer_(ioContext_) {}
     
     StratumClient::~StratumClient() {
         if (socket_.is_open()) {
@@ -46,13 +44,83 @@ static std::string toHex(uint32_t value, int width = 8) {
         tcp::resolver resolver(ioContext_);
         auto endpoints = resolver.resolve(host_, std::to_string(port_));
         boost::asio::connect(socket_, endpoints);
+        connected_ = true;
+    }
+
+    /**
+     * Conexão perdida (erro de leitura ou escrita): descarta a assinatura e a
+     * fila de escrita e agenda a reconexão. Handlers pendentes do socket antigo
+     * voltam com operation_aborted e são ignorados.
+     */
+    void StratumClient::connectionLost(const std::string& reason) {
+        if (!socket_.is_open()) {
+            return;
+        }
+        std::cerr << "Pool connection lost (" << reason << "), reconnecting in " << reconnectDelay_.count() << "s" << std::endl;
+        boost::system::error_code ec;
+        socket_.close(ec);
+        connected_ = false;
+        subscribed_ = false;
+        writeQueue_.clear();
+        buffer_.consume(buffer_.size());
+        // Pede de volta a mesma sessão; o pool decide se retoma.
+        if (!sessionId_.empty()) {
+            resumeSessionId_ = sessionId_;
+        }
+        if (onDisconnected) {
+            onDisconnected();
+        }
+        scheduleReconnect();
+    }
+
+    void StratumClient::scheduleReconnect() {
+        reconnectTimer_.expires_after(reconnectDelay_);
+        reconnectDelay_ = std::min(reconnectDelay_ * 2, std::chrono::seconds(60));
+        reconnectTimer_.async_wait([this](const boost::system::error_code& ec) {
+            if (ec) {
+                return;
+            }
+            auto resolver = std::make_shared<tcp::resolver>(ioContext_);
+            resolver->async_resolve(host_, std::to_string(port_),
+                [this, resolver](const boost::system::error_code& ec, tcp::resolver::results_type results) {
+                    if (ec) {
+                        std::cerr << "Pool reconnect failed: " << ec.message() << std::endl;
+                        scheduleReconnect();
+                        return;
+                    }
+                    boost::asio::async_connect(socket_, results,
+                        [this](const boost::system::error_code& ec, const tcp::endpoint&) {
+                            if (ec) {
+                                std::cerr << "Pool reconnect failed: " << ec.message() << std::endl;
+                                scheduleReconnect();
+                                return;
+                            }
+                            std::cout << "Reconnected to pool " << host_ << ":" << port_ << std::endl;
+                            reconnectDelay_ = std::chrono::seconds(1);
+                            connected_ = true;
+                            subscribe();
+                            authorize();
+                            doRead();
+                        });
+                });
+        });
     }
 
+    /**
+     * Envia o mining.subscribe. Com um id de sessão anterior, manda
+     * [user_agent, session_id] para o pool poder retomar a sessão (mesmo
+     * extranonce1); sem ele, parâmetros vazios como antes.
+     */
     void StratumClient::subscribe() {
+        subscribeId_ = requestId_++;
+        json params = json::array();
+        if (!resumeSessionId_.empty()) {
+            params = {std::string(PROJECT_NAME) + "/" + std::string(PROJECT_VERSION), resumeSessionId_};
+        }
         json req = {
-            {"id", requestId_++},
+            {"id", subscribeId_},
             {"method", "mining.subscribe"},
-            {"params", json::array()}
+            {"params", params}
         };
         sendRequest(req);
     }
@@ -66,15 +134,50 @@ static std::string toHex(uint32_t value, int width = 8) {
         sendRequest(req);
     }
 
-    void StratumClient::sendRequest(const json& req) {
+    /**
+     * Enfileira uma requisição para envio. Pode ser chamada de qualquer thread:
+     * a escrita em si sempre acontece na thread do io_context.
+     * @param req Requisição json-rpc (com "id" já preenchido).
+     * @return O id da requisição, ou -1 se ela não tiver id numérico.
+     */
+    int StratumClient::sendRequest(const json& req) {
+        int id = (req.contains("id") && req["id"].is_number_integer()) ? req["id"].get<int>() : -1;
         std::string msg = req.dump() + "\n";
-        boost::asio::async_write(socket_, boost::asio::buffer(msg),
+        boost::asio::post(ioContext_, [this, msg = std::move(msg)]() mutable {
+            if (!connected_) {
+                return;
+            }
+            writeQueue_.push_back(std::move(msg));
+            if (!writing_) {
+                doWrite();
+            }
+        });
+        return id;
+    }
+
+    void StratumClient::doWrite() {
+        inFlight_.clear();
+        std::vector<boost::asio::const_buffer> buffers;
+        while (!writeQueue_.empty()) {
+            inFlight_.push_back(std::move(writeQueue_.front()));
+            writeQueue_.pop_front();
+        }
+        if (inFlight_.empty()) {
+            writing_ = false;
+            return;
+        }
+        for (const auto& msg : inFlight_) {
+            buffers.push_back(boost::asio::buffer(msg));
+        }
+        writing_ = true;
+        boost::asio::async_write(socket_, buffers,
             [this](const boost::system::error_code& ec, std::size_t bytes_transferred) {
                 handleWrite(ec, bytes_transferred);
             });
     }
 
     void StratumClient::listen() {
+        traceSetThreadName("stratum-io");
         doRead();
         ioContext_.run();
     }
@@ -89,29 +192,91 @@ static std::string toHex(uint32_t value, int width = 8) {
     void StratumClient::handleRead(const boost::system::error_code& ec, std::size_t bytes_transferred) {
         (void)bytes_transferred;  // evitar warning de parâmetro não usado
         if (!ec) {
+            lastReadNs_ = traceEnabled() ? traceNow() : 0;
+            TraceSpan span("stratum.read");
             std::istream is(&buffer_);
             std::string line;
             std::getline(is, line);
-            json resp = json::parse(line);
+            json resp;
+            {
+                TraceSpan parseSpan("stratum.parse");
+                resp = json::parse(line, nullptr, false);
+            }
 
-            if (resp.contains("method")) {
-                onNotification(resp);
+            // Linha que não é JSON (lixo do pool ou da rede) é descartada sem
+            // derrubar a thread de IO.
+            if (resp.is_discarded()) {
+                std::cerr << "Ignoring malformed line from pool: " << line.substr(0, 200) << std::endl;
+            } else if (resp.contains("method")) {
+                if (onNotification) {
+                    onNotification(resp);
+                }
             } else if (resp.contains("result")) {
-                onResponse(resp);
+                if (!subscribed_ && resp.contains("id") && resp["id"] == subscribeId_) {
+                    handleSubscribeResult(resp);
+                }
+                if (onResponse) {
+                    onResponse(resp);
+                }
             } else {
                 std::cerr << "Unexpected response: " << resp.dump() << std::endl;
             }
 
             doRead();
-        } else {
-            std::cerr << "Read error: " << ec.message() << std::endl;
+        } else if (ec != boost::asio::error::operation_aborted) {
+            connectionLost("read: " + ec.message());
+        }
+    }
+
+    /**
+     * Extrai extranonce1 e o tamanho do extranonce2 da resposta ao mining.subscribe.
+     * Formato: {"result": [[subscriptions...], "extranonce1", extranonce2_size]}
+     * @param resp Resposta do pool.
+     */
+    void StratumClient::handleSubscribeResult(const json& resp) {
+        const auto& result = resp["result"];
+        // extranonce1 vai direto para a coinbase nas threads de mineração, onde
+        // um hex inválido lançaria exceção; aqui é recusado de saída.
+        if (!result.is_array() || result.size() < 3 || !result[1].is_string() || !result[2].is_number_unsigned()
+            || !isHex(result[1].get<std::string>()) || result[1].get<std::string>().size() > 2 * kMaxExtranonce1Size
+            || result[2].get<std::size_t>() == 0 || result[2].get<std::size_t>() > kMaxExtranonce2Size) {
+            std::cerr << "Invalid mining.subscribe result: " << resp.dump().substr(0, 200) << std::endl;
+            return;
+        }
+        extranonce1_ = result[1].get<std::string>();
+        extranonce2Size_ = result[2].get<std::size_t>();
+        // Assinaturas: [["mining.notify", id], ...] ou um único par.
+        const auto& subscriptions = result[0];
+        auto matchNotify = [this](const json& pair) {
+            if (pair.is_array() && pair.size() >= 2 && pair[0] == "mining.notify" && pair[1].is_string()) {
+                sessionId_ = pair[1].get<std::string>();
+            }
+        };
+        if (subscriptions.is_array() && !subscriptions.empty() && subscriptions[0].is_string()) {
+            matchNotify(subscriptions);
+        } else if (subscriptions.is_array()) {
+            for (const auto& pair : subscriptions) {
+                matchNotify(pair);
+            }
+        }
+        subscribed_ = true;
+        std::cout << "Subscribed: extranonce1=" << extranonce1_
+                  << " extranonce2_size=" << extranonce2Size_
+                  << (sessionId_.empty() ? "" : " session=" + sessionId_) << std::endl;
+        if (onSubscribed) {
+            onSubscribed();
         }
     }
 
     void StratumClient::handleWrite(const boost::system::error_code& ec, std::size_t) {
         if (ec) {
-            std::cerr << "Write error: " << ec.message() << std::endl;
+            writing_ = false;
+            if (ec != boost::asio::error::operation_aborted) {
+                connectionLost("write: " + ec.message());
+            }
+            return;
         }
+        doWrite();
     }
 
     void StratumClient::submitShare(const nerdminer::MiningJob& job, uint32_t nonce) {
@@ -123,7 +288,7 @@ static std::string toHex(uint32_t value, int width = 8) {
                 job.jobId,                 // job_id
                 job.extraNonce,            // extranonce2
                 job.nTime,                 // ntime (timestamp já string em hexadecimal)
-                toHex(nonce)            // nonce convertido para string hexadecimal
+                hexU32(nonce)           // nonce convertido para string hexadecimal
             }}
         };
 
@@ -132,6 +297,20 @@ static std::string toHex(uint32_t value, int width = 8) {
         sendRequest(req);
     }
 
+    /**
+     * Envia um mining.submit com extranonce2 e ntime explícitos.
+     * @return O id da requisição, para casar com a resposta do pool.
+     */
+    int StratumClient::submitShare(const std::string& jobId, const std::string& extranonce2,
+        const std::string& ntime, uint32_t nonce) {
+        json req = {
+            {"id", requestId_++},
+            {"method", "mining.submit"},
+            {"params", {user_, jobId, extranonce2, ntime, hexU32(nonce)}}
+        };
+        return sendRequest(req);
+    }
+
     void nerdminer::StratumClient::handleSubmitResponse(const json& response) {
         if (response.contains("result") && response["result"].is_boolean()) {
             if (response["result"].get<bool>()) {
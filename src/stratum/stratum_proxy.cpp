@@ -0,0 +1,459 @@
+/**
+ * Project: nerdminer-rpi
+ * File: stratum_proxy.cpp
+ * Description: implements the Stratum proxy (one upstream, many local rigs)
+ *
+ * Author: Regis Araujo Melo
+ * Date: 2025-04-21
+ * Version: 0.1.0
+ *
+ * MIT License
+ * © 2025 Regis Araujo Melo
+ */
+
+#include <nerdminer/stratum_proxy.h>
+#include <nerdminer/hex.h>
+#include <deque>
+#include <iostream>
+
+namespace nerdminer {
+
+/**
+ * Conexão de um rig local. Tudo roda na thread do io_context do upstream,
+ * então não há locks; a memória por conexão é limitada pelo tamanho máximo
+ * da linha lida e pelo total de bytes enfileirados para escrita.
+ */
+class StratumProxy::Downstream : public std::enable_shared_from_this<StratumProxy::Downstream> {
+public:
+    Downstream(StratumProxy& proxy, tcp::socket socket, uint64_t id)
+        : proxy_(proxy),
+        socket_(std::move(socket)),
+        buffer_(proxy.config_.maxLineLength),
+        idleTimer_(socket_.get_executor()),
+        id_(id) {}
+
+    void start() {
+        armIdleTimer();
+        doRead();
+    }
+
+    void send(const std::shared_ptr<const std::string>& msg) {
+        if (closed_) {
+            return;
+        }
+        // Rig lento demais para acompanhar: derruba em vez de crescer a fila.
+        if (queuedBytes_ + msg->size() > proxy_.config_.maxQueuedBytes) {
+            std::cerr << "Proxy: downstream " << id_ << " write queue full, closing" << std::endl;
+            close();
+            return;
+        }
+        queuedBytes_ += msg->size();
+        writeQueue_.push_back(msg);
+        if (!writing_) {
+            doWrite();
+        }
+    }
+
+    void reply(const json& id, const json& result, const json& error = nullptr) {
+        json resp = {{"id", id}, {"result", result}, {"error", error}};
+        send(std::make_shared<const std::string>(resp.dump() + "\n"));
+    }
+
+    void close() {
+        if (closed_) {
+            return;
+        }
+        closed_ = true;
+        boost::system::error_code ec;
+        socket_.close(ec);
+        idleTimer_.cancel();
+        if (hasPrefix_) {
+            proxy_.releasePrefix(id_, prefix_);
+            hasPrefix_ = false;
+        }
+        proxy_.removeSession(id_);
+    }
+
+private:
+    /**
+     * Prazo de leitura: renovado a cada linha recebida; ao vencer, o rig
+     * parado é desconectado e o prefixo dele volta para o pool.
+     */
+    void armIdleTimer() {
+        idleTimer_.expires_after(proxy_.config_.idleTimeout);
+        auto self = shared_from_this();
+        idleTimer_.async_wait([this, self](const boost::system::error_code& ec) {
+            if (ec || closed_) {
+                return;
+            }
+            std::cerr << "Proxy: downstream " << id_ << " idle, closing" << std::endl;
+            close();
+        });
+    }
+
+    void doRead() {
+        auto self = shared_from_this();
+        boost::asio::async_read_until(socket_, buffer_, '\n',
+            [this, self](const boost::system::error_code& ec, std::size_t) {
+                if (ec) {
+                    close();
+                    return;
+                }
+                std::istream is(&buffer_);
+                std::string line;
+                std::getline(is, line);
+                armIdleTimer();
+                if (!line.empty() && !handleLine(line)) {
+                    close();
+                    return;
+                }
+                if (!closed_) {
+                    doRead();
+                }
+            });
+    }
+
+    void doWrite() {
+        std::vector<boost::asio::const_buffer> buffers;
+        inFlight_.assign(writeQueue_.begin(), writeQueue_.end());
+        writeQueue_.clear();
+        for (const auto& msg : inFlight_) {
+            buffers.push_back(boost::asio::buffer(*msg));
+        }
+        writing_ = true;
+        auto self = shared_from_this();
+        boost::asio::async_write(socket_, buffers,
+            [this, self](const boost::system::error_code& ec, std::size_t bytes) {
+                queuedBytes_ -= bytes;
+                inFlight_.clear();
+                writing_ = false;
+                if (ec) {
+                    close();
+                    return;
+                }
+                if (!writeQueue_.empty()) {
+                    doWrite();
+                }
+            });
+    }
+
+    bool handleLine(const std::string& line) {
+        json req = json::parse(line, nullptr, false);
+        if (req.is_discarded() || !req.is_object() || !req.contains("method") || !req["method"].is_string()) {
+            return false;
+        }
+        const json id = req.value("id", json());
+        const std::string method = req["method"].get<std::string>();
+        const json params = req.value("params", json::array());
+
+        if (method == "mining.subscribe") {
+            // Upstream reconectando: o rig tenta de novo depois.
+            if (!proxy_.client_.subscribed()) {
+                reply(id, nullptr, json::array({20, "Upstream unavailable", nullptr}));
+                return false;
+            }
+            if (!hasPrefix_) {
+                if (!proxy_.acquirePrefix(prefix_)) {
+                    reply(id, nullptr, json::array({20, "No extranonce space left", nullptr}));
+                    return false;
+                }
+                hasPrefix_ = true;
+                prefixHex_ = hexU32(prefix_).substr(8 - 2 * proxy_.config_.prefixBytes);
+            }
+            const std::string subId = std::to_string(id_);
+            json subscriptions = json::array({
+                json::array({"mining.set_difficulty", subId}),
+                json::array({"mining.notify", subId})
+            });
+            reply(id, json::array({
+                subscriptions,
+                proxy_.client_.extranonce1() + prefixHex_,
+                proxy_.client_.extranonce2Size() - proxy_.config_.prefixBytes
+            }));
+            if (proxy_.lastDifficulty_) {
+                send(proxy_.lastDifficulty_);
+            }
+            if (proxy_.lastNotify_) {
+                send(proxy_.lastNotify_);
+            }
+        } else if (method == "mining.authorize") {
+            // O upstream só conhece o usuário do proxy; os rigs locais são aceitos.
+            reply(id, true);
+        } else if (method == "mining.submit") {
+            const std::size_t en2Bytes = proxy_.client_.extranonce2Size() - proxy_.config_.prefixBytes;
+            if (!hasPrefix_ || !params.is_array() || params.size() < 5
+                || !params[1].is_string() || !params[2].is_string()
+                || !params[3].is_string() || !params[4].is_string()
+                || !isHex(params[2].get<std::string>(), en2Bytes)
+                || !isHex(params[3].get<std::string>(), 4)) {
+                reply(id, false, json::array({20, "Malformed submit", nullptr}));
+                return true;
+            }
+            uint32_t nonce = 0;
+            if (!parseHexU32(params[4].get<std::string>(), nonce)) {
+                reply(id, false, json::array({20, "Malformed nonce", nullptr}));
+                return true;
+            }
+            if (!proxy_.forwardSubmit(shared_from_this(), id_, id, params[1].get<std::string>(),
+                prefixHex_ + params[2].get<std::string>(), params[3].get<std::string>(), nonce)) {
+                reply(id, false, json::array({20, "Too many pending submits", nullptr}));
+            }
+        } else if (method == "mining.extranonce.subscribe") {
+            reply(id, false);
+        } else {
+            reply(id, nullptr, json::array({20, "Unsupported method: " + method, nullptr}));
+        }
+        return true;
+    }
+
+    StratumProxy& proxy_;
+    tcp::socket socket_;
+    boost::asio::streambuf buffer_;
+    boost::asio::steady_timer idleTimer_;
+    uint64_t id_;
+    uint32_t prefix_ = 0;
+    bool hasPrefix_ = false;
+    std::string prefixHex_;
+    std::deque<std::shared_ptr<const std::string>> writeQueue_;
+    std::vector<std::shared_ptr<const std::string>> inFlight_;
+    std::size_t queuedBytes_ = 0;
+    bool writing_ = false;
+    bool closed_ = false;
+};
+
+StratumProxy::StratumProxy(const std::string& host, uint16_t port,
+    const std::string& user, const std::string& password,
+    const StratumProxyConfig& config)
+    : client_(host, port, user, password),
+    config_(config),
+    acceptor_(client_.ioContext()),
+    expiryTimer_(client_.ioContext()) {
+    client_.onNotification = [this](const json& note) {
+        handleUpstreamNotification(note);
+    };
+    client_.onResponse = [this](const json& resp) {
+        handleUpstreamResponse(resp);
+    };
+    client_.onSubscribed = [this]() {
+        handleUpstreamSubscribed();
+    };
+    client_.onDisconnected = [this]() {
+        handleUpstreamLost();
+    };
+}
+
+bool StratumProxy::start() {
+    std::cout << "Connecting proxy upstream...\n";
+    client_.connect();
+    client_.subscribe();
+    client_.authorize();
+    client_.listen();
+    return !failed_;
+}
+
+/**
+ * Upstream assinado (na partida ou depois de reconectar): começa a aceitar
+ * rigs. Um extranonce2 sem espaço para os prefixos é erro de configuração
+ * e encerra o proxy.
+ */
+void StratumProxy::handleUpstreamSubscribed() {
+    if (client_.extranonce2Size() <= config_.prefixBytes || config_.prefixBytes > 4) {
+        std::cerr << "Error: upstream extranonce2_size " << client_.extranonce2Size()
+                  << " is too small for " << config_.prefixBytes << "-byte prefixes" << std::endl;
+        failed_ = true;
+        client_.ioContext().stop();
+        return;
+    }
+    if (!accepting_) {
+        accepting_ = true;
+        startAccept();
+        scheduleExpiry();
+    }
+}
+
+/**
+ * Upstream caiu: o extranonce1 da próxima sessão pode ser outro, então os
+ * rigs são desconectados (voltam a assinar quando o upstream voltar), os
+ * submits em voo são descartados e os prefixos recomeçam do zero.
+ */
+void StratumProxy::handleUpstreamLost() {
+    pendingSubmits_.clear();
+    pendingPerSession_.clear();
+    drainingPrefixes_.clear();
+    std::vector<std::shared_ptr<Downstream>> targets;
+    for (const auto& entry : sessions_) {
+        targets.push_back(entry.second);
+    }
+    for (const auto& session : targets) {
+        session->close();
+    }
+    freePrefixes_.clear();
+    nextPrefix_ = 0;
+    lastNotify_.reset();
+    lastDifficulty_.reset();
+}
+
+void StratumProxy::startAccept() {
+    if (!acceptor_.is_open()) {
+        tcp::endpoint endpoint(tcp::v4(), config_.listenPort);
+        acceptor_.open(endpoint.protocol());
+        acceptor_.set_option(tcp::acceptor::reuse_address(true));
+        acceptor_.bind(endpoint);
+        acceptor_.listen(boost::asio::socket_base::max_listen_connections);
+        std::cout << "Proxy listening on port " << config_.listenPort << std::endl;
+    }
+    acceptor_.async_accept([this](const boost::system::error_code& ec, tcp::socket socket) {
+        if (!ec) {
+            boost::system::error_code optEc;
+            socket.set_option(tcp::no_delay(true), optEc);
+            auto session = std::make_shared<Downstream>(*this, std::move(socket), nextSessionId_++);
+            sessions_.emplace(nextSessionId_ - 1, session);
+            session->start();
+        } else {
+            std::cerr << "Proxy accept error: " << ec.message() << std::endl;
+        }
+        startAccept();
+    });
+}
+
+/**
+ * Repassa mining.notify e mining.set_difficulty para todos os rigs.
+ * A mensagem é serializada uma única vez e compartilhada entre as conexões.
+ */
+void StratumProxy::handleUpstreamNotification(const json& note) {
+    if (!note["method"].is_string()) {
+        return;
+    }
+    const std::string method = note["method"].get<std::string>();
+    if (method != "mining.notify" && method != "mining.set_difficulty") {
+        std::cout << "Proxy: ignored upstream notification: " << method << std::endl;
+        return;
+    }
+    auto msg = std::make_shared<const std::string>(note.dump() + "\n");
+    if (method == "mining.notify") {
+        lastNotify_ = msg;
+    } else {
+        lastDifficulty_ = msg;
+    }
+    broadcast(msg);
+}
+
+void StratumProxy::handleUpstreamResponse(const json& response) {
+    if (!response.contains("id") || !response["id"].is_number_integer()) {
+        return;
+    }
+    auto it = pendingSubmits_.find(response["id"].get<int>());
+    if (it == pendingSubmits_.end()) {
+        return;
+    }
+    if (auto session = it->second.session.lock()) {
+        session->reply(it->second.downstreamId, response.value("result", json()), response.value("error", json()));
+    }
+    const uint64_t sessionId = it->second.sessionId;
+    pendingSubmits_.erase(it);
+    submitResolved(sessionId);
+}
+
+/**
+ * Uma vez por segundo, responde com erro os submits que o upstream não
+ * respondeu dentro de submitTimeout, para que pendingSubmits_ não cresça sem
+ * limite quando o pool perde respostas.
+ */
+void StratumProxy::scheduleExpiry() {
+    expiryTimer_.expires_after(std::chrono::seconds(1));
+    expiryTimer_.async_wait([this](const boost::system::error_code& ec) {
+        if (ec) {
+            return;
+        }
+        const auto now = std::chrono::steady_clock::now();
+        for (auto it = pendingSubmits_.begin(); it != pendingSubmits_.end();) {
+            if (it->second.deadline > now) {
+                ++it;
+                continue;
+            }
+            if (auto session = it->second.session.lock()) {
+                session->reply(it->second.downstreamId, false, json::array({20, "Upstream did not answer", nullptr}));
+            }
+            const uint64_t sessionId = it->second.sessionId;
+            it = pendingSubmits_.erase(it);
+            submitResolved(sessionId);
+        }
+        scheduleExpiry();
+    });
+}
+
+void StratumProxy::broadcast(const std::shared_ptr<const std::string>& msg) {
+    // send() pode fechar a conexão e removê-la de sessions_ durante a iteração.
+    std::vector<std::shared_ptr<Downstream>> targets;
+    targets.reserve(sessions_.size());
+    for (const auto& entry : sessions_) {
+        targets.push_back(entry.second);
+    }
+    for (const auto& session : targets) {
+        session->send(msg);
+    }
+}
+
+/**
+ * Envia o submit de um rig ao upstream e guarda a quem responder.
+ * @return False se o rig já tem maxPendingSubmits aguardando resposta.
+ */
+bool StratumProxy::forwardSubmit(const std::shared_ptr<Downstream>& session, uint64_t sessionId,
+    const json& downstreamId, const std::string& jobId, const std::string& extranonce2,
+    const std::string& ntime, uint32_t nonce) {
+    auto pending = pendingPerSession_.find(sessionId);
+    if ((pending == pendingPerSession_.end() ? 0 : pending->second) >= config_.maxPendingSubmits) {
+        return false;
+    }
+    pendingPerSession_[sessionId]++;
+    int upstreamId = client_.submitShare(jobId, extranonce2, ntime, nonce);
+    pendingSubmits_[upstreamId] = PendingSubmit{session, sessionId, downstreamId,
+        std::chrono::steady_clock::now() + config_.submitTimeout};
+    return true;
+}
+
+bool StratumProxy::acquirePrefix(uint32_t& prefix) {
+    if (!freePrefixes_.empty()) {
+        prefix = freePrefixes_.back();
+        freePrefixes_.pop_back();
+        return true;
+    }
+    const uint64_t capacity = 1ull << (8 * config_.prefixBytes);
+    if (nextPrefix_ >= capacity) {
+        return false;
+    }
+    prefix = nextPrefix_++;
+    return true;
+}
+
+/**
+ * Devolve o prefixo de um rig que saiu. Se ainda houver submits dele em voo,
+ * o prefixo só é reaproveitado quando forem respondidos ou expirarem, para o
+ * upstream nunca ver dois donos do mesmo prefixo ao mesmo tempo.
+ */
+void StratumProxy::releasePrefix(uint64_t sessionId, uint32_t prefix) {
+    if (pendingPerSession_.count(sessionId)) {
+        drainingPrefixes_[sessionId] = prefix;
+        return;
+    }
+    freePrefixes_.push_back(prefix);
+}
+
+void StratumProxy::submitResolved(uint64_t sessionId) {
+    auto it = pendingPerSession_.find(sessionId);
+    if (it == pendingPerSession_.end() || --it->second > 0) {
+        return;
+    }
+    pendingPerSession_.erase(it);
+    auto draining = drainingPrefixes_.find(sessionId);
+    if (draining != drainingPrefixes_.end()) {
+        freePrefixes_.push_back(draining->second);
+        drainingPrefixes_.erase(draining);
+    }
+}
+
+void StratumProxy::removeSession(uint64_t id) {
+    sessions_.erase(id);
+}
+
+} // namespace nerdminer
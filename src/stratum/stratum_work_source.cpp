@@ -0,0 +1,213 @@
+/**
+* Project: nerdminer-rpi
+* File: stratum_work_source.cpp
+* Description: Stratum pool work source (mining.notify in, mining.submit out)
+*
+* Author: Regis Araujo Melo
+* Date: 2025-04-21
+* Version: 0.1.0
+*
+* MIT License
+* © 2025 Regis Araujo Melo
+*/
+
+#include "nerdminer/stratum_work_source.h"
+#include "nerdminer/hex.h"
+#include "nerdminer/trace.h"
+#include <iostream>
+
+namespace nerdminer {
+
+StratumWorkSource::StratumWorkSource(const std::string& host, uint16_t port, const std::string& user, const std::string& password)
+    : host_(host), port_(port), client_(host, port, user, password), traceScope_(traceNewScope()) {
+    client_.onResponse = [this](const json& resp) {
+        std::cout << "Response: " << resp.dump() << std::endl;
+        handleResponse(resp);
+    };
+
+    client_.onNotification = [this](const json& note) {
+        handleNotification(note);
+    };
+
+    client_.onSubscribed = [this] {
+        {
+            std::lock_guard<std::mutex> lock(submitMutex_);
+            liveExtranonce1_ = client_.extranonce1();
+        }
+        if (!resumeExtranonce1_.empty()) {
+            if (client_.extranonce1() == resumeExtranonce1_) {
+                std::cout << "Pool resumed session " << client_.sessionId() << std::endl;
+            } else {
+                std::cout << "Pool started a new session (previous extranonce1 " << resumeExtranonce1_ << ")" << std::endl;
+            }
+        }
+    };
+
+    client_.onDisconnected = [this] {
+        // O cliente reconecta sozinho; até o primeiro job da nova sessão o
+        // engine não minera o job antigo, e submits em voo não terão resposta.
+        {
+            std::lock_guard<std::mutex> lock(submitMutex_);
+            for (const auto& pending : pendingSubmits_) {
+                traceAsyncEnd("share.submit_to_ack", static_cast<uint64_t>(pending.first), traceScope_);
+            }
+            pendingSubmits_.clear();
+            liveExtranonce1_.clear();
+        }
+        submitCv_.notify_all();
+        if (onWorkLost) {
+            onWorkLost();
+        }
+    };
+}
+
+StratumWorkSource::~StratumWorkSource() {
+    stop();
+}
+
+std::string StratumWorkSource::name() const {
+    return host_ + ":" + std::to_string(port_);
+}
+
+void StratumWorkSource::start() {
+    std::cout << "Connecting to pool server " << name() << "...\n";
+    client_.connect();
+    client_.subscribe();
+    client_.authorize();
+    io_ = std::thread([this] { client_.listen(); });
+}
+
+void StratumWorkSource::stop() {
+    client_.ioContext().stop();
+    if (io_.joinable()) {
+        io_.join();
+    }
+}
+
+void StratumWorkSource::handleNotification(const json& note) {
+    if (note.contains("method")) {
+        if (!note["method"].is_string()) {
+            std::cerr << "Ignoring notification with a non-string method: " << note.dump().substr(0, 200) << std::endl;
+            return;
+        }
+        const std::string method = note["method"].get<std::string>();
+        if (method == "mining.notify") {
+            MiningJob newJob = MiningJob::fromNotification(note);
+            if (newJob.valid) {
+                if (onJob) {
+                    onJob(newJob, client_.extranonce1(), client_.extranonce2Size(), client_.lastReadTimestamp());
+                }
+                std::cout << "Current job: " << newJob.jobId << std::endl;
+            } else {
+                std::cerr << "Received invalid mining job." << std::endl;
+            }
+        } else if (method == "mining.set_difficulty") {
+            // Vale a partir do próximo mining.notify, como no protocolo.
+            const json params = note.value("params", json());
+            if (params.is_array() && !params.empty() && params[0].is_number() && params[0].get<double>() > 0) {
+                std::cout << "Pool difficulty: " << params[0].get<double>() << std::endl;
+                if (onDifficulty) {
+                    onDifficulty(params[0].get<double>());
+                }
+            } else {
+                std::cerr << "Received invalid mining.set_difficulty." << std::endl;
+            }
+        } else {
+            std::cout << "Ignored notification: " << method << std::endl;
+        }
+    }
+}
+
+void StratumWorkSource::handleResponse(const json& response) {
+    if (response.contains("id") && response["id"].is_number()) {
+        int respId = response["id"].get<int>();
+
+        // Verificando se o ID de resposta está na lista de pendentes
+        bool pending = false;
+        {
+            std::lock_guard<std::mutex> lock(submitMutex_);
+            pending = pendingSubmits_.erase(respId) > 0;
+        }
+        submitCv_.notify_all();
+        if (pending) {
+            traceAsyncEnd("share.submit_to_ack", static_cast<uint64_t>(respId), traceScope_);
+            std::cout << "[*] Found pending submit for response ID: " << respId << std::endl;
+            handleSubmitResponse(response);
+        } else {
+            std::cout << "[*] No pending submit for response ID: " << respId << std::endl;
+        }
+    }
+}
+
+void StratumWorkSource::handleSubmitResponse(const json& response) {
+    if (response.contains("result") && response["result"].is_boolean()) {
+        if (response["result"].get<bool>()) {
+            std::cout << "\033[1;32m[*] Share accepted!\033[0m" << std::endl;
+        } else {
+            std::cout << "\033[1;31m[!] Share rejected!\033[0m" << std::endl;
+        }
+    } else if (response.contains("error") && !response["error"].is_null()) {
+        std::cout << "\033[1;31m[!] Share rejected with error: " << response["error"].dump() << "\033[0m" << std::endl;
+    } else {
+        std::cout << "[?] Unknown response to share submission." << std::endl;
+    }
+}
+
+/**
+ * Envia ao pool um share que já passou pela verificação de referência.
+ * Roda na thread do verificador.
+ * @param share O share verificado.
+ */
+void StratumWorkSource::submitShare(const ShareCandidate& share) {
+    std::cout << "Submitting share: Job ID: " << share.job.jobId << ", Nonce: " << share.nonce
+              << " (kernel " << share.kernel << ")" << std::endl;
+    TraceSpan span("share.submit", share.nonce);
+    // Registra o pendente antes de a resposta poder ser processada na thread de IO.
+    std::lock_guard<std::mutex> lock(submitMutex_);
+    if (share.extranonce1 != liveExtranonce1_) {
+        std::cerr << "Share for job " << share.job.jobId << " from a previous pool session dropped" << std::endl;
+        return;
+    }
+    int id = client_.submitShare(share.job.jobId, share.extranonce2, hexU32(share.ntime), share.nonce);
+    traceAsyncBegin("share.submit_to_ack", static_cast<uint64_t>(id), 0, traceScope_);
+    pendingSubmits_[id] = std::chrono::steady_clock::now();
+}
+
+/**
+ * Espera as respostas dos submits pendentes, até o limite.
+ * @param timeout Tempo máximo de espera.
+ */
+void StratumWorkSource::drain(std::chrono::milliseconds timeout) {
+    std::unique_lock<std::mutex> lock(submitMutex_);
+    if (pendingSubmits_.empty()) {
+        return;
+    }
+    std::cout << "Waiting for " << pendingSubmits_.size() << " pending submit(s) on " << name() << "..." << std::endl;
+    if (!submitCv_.wait_for(lock, timeout, [this] { return pendingSubmits_.empty(); })) {
+        std::cerr << "Gave up on " << pendingSubmits_.size() << " unanswered submit(s) on " << name() << std::endl;
+    }
+}
+
+json StratumWorkSource::sessionState() const {
+    if (!client_.subscribed()) {
+        return json();
+    }
+    return {
+        {"session_id", client_.sessionId()},
+        {"extranonce1", client_.extranonce1()},
+        {"extranonce2_size", client_.extranonce2Size()}
+    };
+}
+
+void StratumWorkSource::resumeSession(const json& state) {
+    if (!state.is_object() || !state.contains("session_id") || !state["session_id"].is_string() ||
+        state["session_id"].get<std::string>().empty()) {
+        return;
+    }
+    client_.setResumeSessionId(state["session_id"].get<std::string>());
+    if (state.contains("extranonce1") && state["extranonce1"].is_string()) {
+        resumeExtranonce1_ = state["extranonce1"].get<std::string>();
+    }
+}
+
+} // namespace nerdminer
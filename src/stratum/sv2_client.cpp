@@ -0,0 +1,266 @@
+/**
+* Project: nerdminer-rpi
+* File: sv2_client.cpp
+* Description: Stratum V2 client: binary framing, connection setup and standard channel
+*
+* Author: Regis Araujo Melo
+* Date: 2025-04-21
+* Version: 0.1.0
+*
+* MIT License
+* © 2025 Regis Araujo Melo
+*/
+
+#include "nerdminer/sv2_client.h"
+#include "nerdminer/trace.h"
+#include <iostream>
+
+namespace nerdminer {
+
+Sv2Client::Sv2Client(const std::string& host, uint16_t port, const std::string& user)
+    : socket_(ioContext_), host_(host), port_(port), user_(user), reconnectTimer_(ioContext_) {}
+
+Sv2Client::~Sv2Client() {
+    if (socket_.is_open()) {
+        boost::system::error_code ec;
+        socket_.close(ec);
+    }
+}
+
+void Sv2Client::connect() {
+    tcp::resolver resolver(ioContext_);
+    boost::asio::connect(socket_, resolver.resolve(host_, std::to_string(port_)));
+    socket_.set_option(tcp::no_delay(true));
+    connected_ = true;
+    sendSetup();
+}
+
+void Sv2Client::sendSetup() {
+    sv2::SetupConnection setup;
+    setup.endpointHost = host_;
+    setup.endpointPort = port_;
+    setup.vendor = "nerdminer-rpi";
+    setup.firmware = "0.1.0";
+    send(setup.encode());
+}
+
+void Sv2Client::disconnect() {
+    boost::system::error_code ec;
+    reconnectTimer_.cancel();
+    socket_.close(ec);
+    connected_ = false;
+    channelOpen_ = false;
+    writeQueue_.clear();
+    writing_ = false;
+}
+
+/**
+ * Conexão perdida (erro de leitura/escrita ou frame inválido): descarta o
+ * canal e o que estava na fila e agenda a reconexão. Os handlers ainda
+ * pendentes do socket antigo voltam com operation_aborted e são ignorados.
+ */
+void Sv2Client::connectionLost(const std::string& reason) {
+    if (!socket_.is_open()) {
+        return;
+    }
+    std::cerr << "SV2 connection lost (" << reason << "), reconnecting in " << reconnectDelay_.count() << "s" << std::endl;
+    boost::system::error_code ec;
+    socket_.close(ec);
+    connected_ = false;
+    channelOpen_ = false;
+    writeQueue_.clear();
+    if (onDisconnected) {
+        onDisconnected();
+    }
+    scheduleReconnect();
+}
+
+void Sv2Client::scheduleReconnect() {
+    reconnectTimer_.expires_after(reconnectDelay_);
+    reconnectDelay_ = std::min(reconnectDelay_ * 2, std::chrono::seconds(60));
+    reconnectTimer_.async_wait([this](const boost::system::error_code& ec) {
+        if (ec) {
+            return;
+        }
+        auto resolver = std::make_shared<tcp::resolver>(ioContext_);
+        resolver->async_resolve(host_, std::to_string(port_),
+            [this, resolver](const boost::system::error_code& ec, tcp::resolver::results_type results) {
+                if (ec) {
+                    std::cerr << "SV2 reconnect failed: " << ec.message() << std::endl;
+                    scheduleReconnect();
+                    return;
+                }
+                boost::asio::async_connect(socket_, results,
+                    [this](const boost::system::error_code& ec, const tcp::endpoint&) {
+                        if (ec) {
+                            std::cerr << "SV2 reconnect failed: " << ec.message() << std::endl;
+                            scheduleReconnect();
+                            return;
+                        }
+                        boost::system::error_code optEc;
+                        socket_.set_option(tcp::no_delay(true), optEc);
+                        std::cout << "SV2 reconnected to " << host_ << ":" << port_ << std::endl;
+                        reconnectDelay_ = std::chrono::seconds(1);
+                        connected_ = true;
+                        sendSetup();
+                        doReadHeader();
+                    });
+            });
+    });
+}
+
+void Sv2Client::openChannel() {
+    sv2::OpenStandardMiningChannel open;
+    open.requestId = 1;
+    open.userIdentity = user_;
+    open.maxTarget.fill(0xff);
+    send(open.encode());
+}
+
+/**
+ * Enfileira um frame para envio; a escrita acontece na thread do io_context.
+ * @param frame Frame completo (cabeçalho + payload).
+ */
+void Sv2Client::send(std::vector<uint8_t> frame) {
+    boost::asio::post(ioContext_, [this, frame = std::move(frame)]() mutable {
+        if (!connected_) {
+            return;
+        }
+        writeQueue_.push_back(std::move(frame));
+        if (!writing_) {
+            doWrite();
+        }
+    });
+}
+
+void Sv2Client::doWrite() {
+    inFlight_.clear();
+    while (!writeQueue_.empty()) {
+        inFlight_.push_back(std::move(writeQueue_.front()));
+        writeQueue_.pop_front();
+    }
+    if (inFlight_.empty()) {
+        writing_ = false;
+        return;
+    }
+    std::vector<boost::asio::const_buffer> buffers;
+    for (const auto& frame : inFlight_) {
+        buffers.push_back(boost::asio::buffer(frame));
+    }
+    writing_ = true;
+    boost::asio::async_write(socket_, buffers,
+        [this](const boost::system::error_code& ec, std::size_t bytes) {
+            if (ec) {
+                writing_ = false;
+                if (ec != boost::asio::error::operation_aborted) {
+                    connectionLost("write: " + ec.message());
+                }
+                return;
+            }
+            bytesWritten_ += bytes;
+            doWrite();
+        });
+}
+
+void Sv2Client::listen() {
+    traceSetThreadName("sv2-io");
+    doReadHeader();
+    ioContext_.run();
+}
+
+void Sv2Client::doReadHeader() {
+    boost::asio::async_read(socket_, boost::asio::buffer(headerBuf_),
+        [this](const boost::system::error_code& ec, std::size_t) {
+            if (ec) {
+                if (ec != boost::asio::error::operation_aborted) {
+                    connectionLost("read: " + ec.message());
+                }
+                return;
+            }
+            header_ = sv2::parseFrameHeader(headerBuf_.data());
+            if (header_.length > sv2::kMaxPayloadSize) {
+                connectionLost("frame too large: " + std::to_string(header_.length) + " bytes");
+                return;
+            }
+            payload_.resize(header_.length);
+            doReadPayload();
+        });
+}
+
+void Sv2Client::doReadPayload() {
+    boost::asio::async_read(socket_, boost::asio::buffer(payload_),
+        [this](const boost::system::error_code& ec, std::size_t) {
+            if (ec) {
+                if (ec != boost::asio::error::operation_aborted) {
+                    connectionLost("read: " + ec.message());
+                }
+                return;
+            }
+            bytesRead_ += sv2::kFrameHeaderSize + payload_.size();
+            lastReadNs_ = traceEnabled() ? traceNow() : 0;
+            try {
+                TraceSpan span("sv2.read");
+                dispatch();
+            } catch (const std::invalid_argument& e) {
+                std::cerr << "Malformed SV2 message 0x" << std::hex << int(header_.msgType) << std::dec
+                          << ": " << e.what() << std::endl;
+            }
+            doReadHeader();
+        });
+}
+
+/**
+ * Trata as mensagens de conexão e de abertura de canal; o resto segue
+ * para onMessage.
+ */
+void Sv2Client::dispatch() {
+    sv2::Reader reader(payload_.data(), payload_.size());
+    switch (header_.msgType) {
+    case sv2::kSetupConnectionSuccess: {
+        auto msg = sv2::SetupConnectionSuccess::decode(reader);
+        std::cout << "SV2 connection set up (version " << msg.usedVersion << ")" << std::endl;
+        openChannel();
+        break;
+    }
+    case sv2::kSetupConnectionError: {
+        auto msg = sv2::SetupConnectionError::decode(reader);
+        std::cerr << "SV2 SetupConnection rejected: " << msg.errorCode << std::endl;
+        break;
+    }
+    case sv2::kOpenStandardMiningChannelSuccess: {
+        auto msg = sv2::OpenStandardMiningChannelSuccess::decode(reader);
+        channelId_ = msg.channelId;
+        groupChannelId_ = msg.groupChannelId;
+        target_ = sv2::fromU256(msg.target);
+        channelOpen_ = true;
+        std::cout << "SV2 standard channel " << channelId_ << " open" << std::endl;
+        if (onChannelOpened) {
+            onChannelOpened();
+        }
+        break;
+    }
+    case sv2::kOpenMiningChannelError: {
+        auto msg = sv2::OpenMiningChannelError::decode(reader);
+        std::cerr << "SV2 OpenStandardMiningChannel rejected: " << msg.errorCode << std::endl;
+        break;
+    }
+    default:
+        if (onMessage) {
+            onMessage(header_, reader);
+        }
+    }
+}
+
+uint32_t Sv2Client::submitShare(uint32_t jobId, uint32_t nonce, uint32_t ntime, uint32_t version) {
+    sv2::SubmitSharesStandard submit;
+    submit.channelId = channelId_;
+    submit.sequenceNumber = sequence_++;
+    submit.jobId = jobId;
+    submit.nonce = nonce;
+    submit.ntime = ntime;
+    submit.version = version;
+    send(submit.encode());
+    return submit.sequenceNumber;
+}
+
+} // namespace nerdminer
@@ -0,0 +1,391 @@
+/**
+* Project: nerdminer-rpi
+* File: sv2_codec.cpp
+* Description: Stratum V2 binary framing and mining message (de)serialization
+*
+* Author: Regis Araujo Melo
+* Date: 2025-04-21
+* Version: 0.1.0
+*
+* MIT License
+* © 2025 Regis Araujo Melo
+*/
+
+#include "nerdminer/sv2_codec.h"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace nerdminer {
+namespace sv2 {
+
+FrameHeader parseFrameHeader(const uint8_t* data) {
+    FrameHeader header;
+    header.extensionType = static_cast<uint16_t>(data[0] | (data[1] << 8));
+    header.msgType = data[2];
+    header.length = static_cast<uint32_t>(data[3]) | (static_cast<uint32_t>(data[4]) << 8) |
+                    (static_cast<uint32_t>(data[5]) << 16);
+    return header;
+}
+
+void Writer::u16(uint16_t v) {
+    buf_.push_back(static_cast<uint8_t>(v));
+    buf_.push_back(static_cast<uint8_t>(v >> 8));
+}
+
+void Writer::u32(uint32_t v) {
+    for (int i = 0; i < 4; ++i) {
+        buf_.push_back(static_cast<uint8_t>(v >> (8 * i)));
+    }
+}
+
+void Writer::u64(uint64_t v) {
+    for (int i = 0; i < 8; ++i) {
+        buf_.push_back(static_cast<uint8_t>(v >> (8 * i)));
+    }
+}
+
+void Writer::f32(float v) {
+    uint32_t bits;
+    std::memcpy(&bits, &v, sizeof(bits));
+    u32(bits);
+}
+
+void Writer::str0_255(const std::string& s) {
+    if (s.size() > 255) {
+        throw std::invalid_argument("STR0_255 longer than 255 bytes");
+    }
+    buf_.push_back(static_cast<uint8_t>(s.size()));
+    buf_.insert(buf_.end(), s.begin(), s.end());
+}
+
+void Writer::b0_32(const std::vector<uint8_t>& b) {
+    if (b.size() > 32) {
+        throw std::invalid_argument("B0_32 longer than 32 bytes");
+    }
+    buf_.push_back(static_cast<uint8_t>(b.size()));
+    buf_.insert(buf_.end(), b.begin(), b.end());
+}
+
+/**
+ * Monta o frame completo (cabeçalho de 6 bytes + payload).
+ * @param msgType Tipo da mensagem.
+ * @param channelMsg Se a mensagem é específica de um canal.
+ * @return Bytes prontos para o socket.
+ */
+std::vector<uint8_t> Writer::frame(uint8_t msgType, bool channelMsg) const {
+    const uint16_t extension = channelMsg ? kChannelMsgBit : 0;
+    const uint32_t length = static_cast<uint32_t>(buf_.size());
+    std::vector<uint8_t> out;
+    out.reserve(kFrameHeaderSize + buf_.size());
+    out.push_back(static_cast<uint8_t>(extension));
+    out.push_back(static_cast<uint8_t>(extension >> 8));
+    out.push_back(msgType);
+    out.push_back(static_cast<uint8_t>(length));
+    out.push_back(static_cast<uint8_t>(length >> 8));
+    out.push_back(static_cast<uint8_t>(length >> 16));
+    out.insert(out.end(), buf_.begin(), buf_.end());
+    return out;
+}
+
+const uint8_t* Reader::take(std::size_t n) {
+    if (size_ - pos_ < n) {
+        throw std::invalid_argument("SV2 message truncated");
+    }
+    const uint8_t* p = data_ + pos_;
+    pos_ += n;
+    return p;
+}
+
+uint8_t Reader::u8() {
+    return *take(1);
+}
+
+uint16_t Reader::u16() {
+    const uint8_t* p = take(2);
+    return static_cast<uint16_t>(p[0] | (p[1] << 8));
+}
+
+uint32_t Reader::u32() {
+    const uint8_t* p = take(4);
+    return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
+           (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+}
+
+uint64_t Reader::u64() {
+    const uint64_t lo = u32();
+    const uint64_t hi = u32();
+    return lo | (hi << 32);
+}
+
+float Reader::f32() {
+    const uint32_t bits = u32();
+    float v;
+    std::memcpy(&v, &bits, sizeof(v));
+    return v;
+}
+
+U256 Reader::u256() {
+    U256 v;
+    const uint8_t* p = take(v.size());
+    std::copy(p, p + v.size(), v.begin());
+    return v;
+}
+
+std::string Reader::str0_255() {
+    const uint8_t n = u8();
+    const uint8_t* p = take(n);
+    return std::string(reinterpret_cast<const char*>(p), n);
+}
+
+std::vector<uint8_t> Reader::b0_32() {
+    const uint8_t n = u8();
+    if (n > 32) {
+        throw std::invalid_argument("B0_32 longer than 32 bytes");
+    }
+    const uint8_t* p = take(n);
+    return std::vector<uint8_t>(p, p + n);
+}
+
+std::vector<uint8_t> SetupConnection::encode() const {
+    Writer w;
+    w.u8(protocol);
+    w.u16(minVersion);
+    w.u16(maxVersion);
+    w.u32(flags);
+    w.str0_255(endpointHost);
+    w.u16(endpointPort);
+    w.str0_255(vendor);
+    w.str0_255(hardwareVersion);
+    w.str0_255(firmware);
+    w.str0_255(deviceId);
+    return w.frame(kSetupConnection, false);
+}
+
+SetupConnection SetupConnection::decode(Reader& r) {
+    SetupConnection m;
+    m.protocol = r.u8();
+    m.minVersion = r.u16();
+    m.maxVersion = r.u16();
+    m.flags = r.u32();
+    m.endpointHost = r.str0_255();
+    m.endpointPort = r.u16();
+    m.vendor = r.str0_255();
+    m.hardwareVersion = r.str0_255();
+    m.firmware = r.str0_255();
+    m.deviceId = r.str0_255();
+    return m;
+}
+
+std::vector<uint8_t> SetupConnectionSuccess::encode() const {
+    Writer w;
+    w.u16(usedVersion);
+    w.u32(flags);
+    return w.frame(kSetupConnectionSuccess, false);
+}
+
+SetupConnectionSuccess SetupConnectionSuccess::decode(Reader& r) {
+    SetupConnectionSuccess m;
+    m.usedVersion = r.u16();
+    m.flags = r.u32();
+    return m;
+}
+
+std::vector<uint8_t> SetupConnectionError::encode() const {
+    Writer w;
+    w.u32(flags);
+    w.str0_255(errorCode);
+    return w.frame(kSetupConnectionError, false);
+}
+
+SetupConnectionError SetupConnectionError::decode(Reader& r) {
+    SetupConnectionError m;
+    m.flags = r.u32();
+    m.errorCode = r.str0_255();
+    return m;
+}
+
+std::vector<uint8_t> OpenStandardMiningChannel::encode() const {
+    Writer w;
+    w.u32(requestId);
+    w.str0_255(userIdentity);
+    w.f32(nominalHashRate);
+    w.u256(maxTarget);
+    return w.frame(kOpenStandardMiningChannel, false);
+}
+
+OpenStandardMiningChannel OpenStandardMiningChannel::decode(Reader& r) {
+    OpenStandardMiningChannel m;
+    m.requestId = r.u32();
+    m.userIdentity = r.str0_255();
+    m.nominalHashRate = r.f32();
+    m.maxTarget = r.u256();
+    return m;
+}
+
+std::vector<uint8_t> OpenStandardMiningChannelSuccess::encode() const {
+    Writer w;
+    w.u32(requestId);
+    w.u32(channelId);
+    w.u256(target);
+    w.b0_32(extranoncePrefix);
+    w.u32(groupChannelId);
+    return w.frame(kOpenStandardMiningChannelSuccess, false);
+}
+
+OpenStandardMiningChannelSuccess OpenStandardMiningChannelSuccess::decode(Reader& r) {
+    OpenStandardMiningChannelSuccess m;
+    m.requestId = r.u32();
+    m.channelId = r.u32();
+    m.target = r.u256();
+    m.extranoncePrefix = r.b0_32();
+    m.groupChannelId = r.u32();
+    return m;
+}
+
+std::vector<uint8_t> OpenMiningChannelError::encode() const {
+    Writer w;
+    w.u32(requestId);
+    w.str0_255(errorCode);
+    return w.frame(kOpenMiningChannelError, false);
+}
+
+OpenMiningChannelError OpenMiningChannelError::decode(Reader& r) {
+    OpenMiningChannelError m;
+    m.requestId = r.u32();
+    m.errorCode = r.str0_255();
+    return m;
+}
+
+std::vector<uint8_t> NewMiningJob::encode() const {
+    Writer w;
+    w.u32(channelId);
+    w.u32(jobId);
+    // OPTION[U32]: um byte de presença seguido do valor.
+    w.u8(hasMinNtime ? 1 : 0);
+    if (hasMinNtime) {
+        w.u32(minNtime);
+    }
+    w.u32(version);
+    w.u256(merkleRoot);
+    return w.frame(kNewMiningJob, true);
+}
+
+NewMiningJob NewMiningJob::decode(Reader& r) {
+    NewMiningJob m;
+    m.channelId = r.u32();
+    m.jobId = r.u32();
+    m.hasMinNtime = r.u8() != 0;
+    if (m.hasMinNtime) {
+        m.minNtime = r.u32();
+    }
+    m.version = r.u32();
+    m.merkleRoot = r.u256();
+    return m;
+}
+
+std::vector<uint8_t> SetNewPrevHash::encode() const {
+    Writer w;
+    w.u32(channelId);
+    w.u32(jobId);
+    w.u256(prevHash);
+    w.u32(minNtime);
+    w.u32(nbits);
+    return w.frame(kSetNewPrevHash, true);
+}
+
+SetNewPrevHash SetNewPrevHash::decode(Reader& r) {
+    SetNewPrevHash m;
+    m.channelId = r.u32();
+    m.jobId = r.u32();
+    m.prevHash = r.u256();
+    m.minNtime = r.u32();
+    m.nbits = r.u32();
+    return m;
+}
+
+std::vector<uint8_t> SetTarget::encode() const {
+    Writer w;
+    w.u32(channelId);
+    w.u256(maximumTarget);
+    return w.frame(kSetTarget, true);
+}
+
+SetTarget SetTarget::decode(Reader& r) {
+    SetTarget m;
+    m.channelId = r.u32();
+    m.maximumTarget = r.u256();
+    return m;
+}
+
+std::vector<uint8_t> SubmitSharesStandard::encode() const {
+    Writer w;
+    w.u32(channelId);
+    w.u32(sequenceNumber);
+    w.u32(jobId);
+    w.u32(nonce);
+    w.u32(ntime);
+    w.u32(version);
+    return w.frame(kSubmitSharesStandard, true);
+}
+
+SubmitSharesStandard SubmitSharesStandard::decode(Reader& r) {
+    SubmitSharesStandard m;
+    m.channelId = r.u32();
+    m.sequenceNumber = r.u32();
+    m.jobId = r.u32();
+    m.nonce = r.u32();
+    m.ntime = r.u32();
+    m.version = r.u32();
+    return m;
+}
+
+std::vector<uint8_t> SubmitSharesSuccess::encode() const {
+    Writer w;
+    w.u32(channelId);
+    w.u32(lastSequenceNumber);
+    w.u32(newSubmitsAcceptedCount);
+    w.u64(newSharesSum);
+    return w.frame(kSubmitSharesSuccess, true);
+}
+
+SubmitSharesSuccess SubmitSharesSuccess::decode(Reader& r) {
+    SubmitSharesSuccess m;
+    m.channelId = r.u32();
+    m.lastSequenceNumber = r.u32();
+    m.newSubmitsAcceptedCount = r.u32();
+    m.newSharesSum = r.u64();
+    return m;
+}
+
+std::vector<uint8_t> SubmitSharesError::encode() const {
+    Writer w;
+    w.u32(channelId);
+    w.u32(sequenceNumber);
+    w.str0_255(errorCode);
+    return w.frame(kSubmitSharesError, true);
+}
+
+SubmitSharesError SubmitSharesError::decode(Reader& r) {
+    SubmitSharesError m;
+    m.channelId = r.u32();
+    m.sequenceNumber = r.u32();
+    m.errorCode = r.str0_255();
+    return m;
+}
+
+U256 toU256(const std::vector<uint8_t>& bigEndian) {
+    if (bigEndian.size() != 32) {
+        throw std::invalid_argument("target must be 32 bytes");
+    }
+    U256 v;
+    std::reverse_copy(bigEndian.begin(), bigEndian.end(), v.begin());
+    return v;
+}
+
+std::vector<uint8_t> fromU256(const U256& value) {
+    return std::vector<uint8_t>(value.rbegin(), value.rend());
+}
+
+} // namespace sv2
+} // namespace nerdminer
@@ -0,0 +1,251 @@
+/**
+* Project: nerdminer-rpi
+* File: sv2_work_source.cpp
+* Description: Stratum V2 pool work source (standard channel jobs in, SubmitSharesStandard out)
+*
+* Author: Regis Araujo Melo
+* Date: 2025-04-21
+* Version: 0.1.0
+*
+* MIT License
+* © 2025 Regis Araujo Melo
+*/
+
+#include "nerdminer/sv2_work_source.h"
+#include "nerdminer/hex.h"
+#include "nerdminer/trace.h"
+#include <algorithm>
+#include <charconv>
+#include <iostream>
+
+namespace nerdminer {
+
+Sv2WorkSource::Sv2WorkSource(const std::string& host, uint16_t port, const std::string& user)
+    : host_(host), port_(port), client_(host, port, user), traceScope_(traceNewScope()) {
+    client_.onChannelOpened = [this] {
+        target_ = client_.initialTarget();
+    };
+    client_.onMessage = [this](const sv2::FrameHeader& header, sv2::Reader& reader) {
+        handleMessage(header, reader);
+    };
+    client_.onDisconnected = [this] {
+        // Canal novo na reconexão: jobs, prevhash e submits do antigo não valem
+        // mais, e o engine para de minerar o job antigo até o primeiro do canal novo.
+        futureJobs_.clear();
+        hasPrevHash_ = false;
+        current_.valid = false;
+        {
+            std::lock_guard<std::mutex> lock(submitMutex_);
+            for (const auto& pending : pendingSubmits_) {
+                traceAsyncEnd("share.submit_to_ack", pending.first, traceScope_);
+            }
+            pendingSubmits_.clear();
+            channelJobs_.clear();
+        }
+        submitCv_.notify_all();
+        if (onWorkLost) {
+            onWorkLost();
+        }
+    };
+}
+
+Sv2WorkSource::~Sv2WorkSource() {
+    stop();
+}
+
+std::string Sv2WorkSource::name() const {
+    return "sv2://" + host_ + ":" + std::to_string(port_);
+}
+
+void Sv2WorkSource::start() {
+    std::cout << "Connecting to SV2 pool " << name() << "...\n";
+    // Depois de um stop() o io_context fica parado até o restart().
+    client_.ioContext().restart();
+    client_.connect();
+    io_ = std::thread([this] { client_.listen(); });
+}
+
+void Sv2WorkSource::stop() {
+    client_.ioContext().stop();
+    if (io_.joinable()) {
+        io_.join();
+    }
+    client_.disconnect();
+    client_.ioContext().restart();
+}
+
+void Sv2WorkSource::handleMessage(const sv2::FrameHeader& header, sv2::Reader& reader) {
+    switch (header.msgType) {
+    case sv2::kNewMiningJob: {
+        auto job = sv2::NewMiningJob::decode(reader);
+        if (!client_.isOurChannel(job.channelId)) {
+            std::cerr << "SV2 NewMiningJob for foreign channel " << job.channelId << " ignored" << std::endl;
+            break;
+        }
+        if (!job.hasMinNtime || !hasPrevHash_) {
+            // Job futuro, ou job ativo que chegou antes do primeiro prevhash:
+            // só vale quando o SetNewPrevHash correspondente chegar.
+            futureJobs_[job.jobId] = job;
+        } else {
+            activate(job, job.minNtime, false);
+        }
+        break;
+    }
+    case sv2::kSetNewPrevHash: {
+        auto msg = sv2::SetNewPrevHash::decode(reader);
+        if (!client_.isOurChannel(msg.channelId)) {
+            std::cerr << "SV2 SetNewPrevHash for foreign channel " << msg.channelId << " ignored" << std::endl;
+            break;
+        }
+        prevHash_ = msg;
+        hasPrevHash_ = true;
+        auto it = futureJobs_.find(prevHash_.jobId);
+        if (it != futureJobs_.end()) {
+            const sv2::NewMiningJob& job = it->second;
+            const uint32_t ntime = job.hasMinNtime ? std::max(job.minNtime, prevHash_.minNtime) : prevHash_.minNtime;
+            activate(job, ntime, true);
+        } else {
+            std::cerr << "SV2 SetNewPrevHash for unknown job " << prevHash_.jobId << std::endl;
+        }
+        // Jobs futuros anteriores ficam inválidos com o novo prevhash.
+        futureJobs_.clear();
+        break;
+    }
+    case sv2::kSetTarget: {
+        auto msg = sv2::SetTarget::decode(reader);
+        if (!client_.isOurChannel(msg.channelId)) {
+            break;
+        }
+        target_ = sv2::fromU256(msg.maximumTarget);
+        std::cout << "Pool target: " << encodeHex(target_.data(), target_.size()) << std::endl;
+        // O alvo novo vale já para o job atual, sem recomeçar a busca dele
+        // (republicar o job faria as threads refazerem nonces já enviados).
+        if (current_.valid) {
+            current_.shareTarget = target_;
+            if (onTarget) {
+                onTarget(target_);
+            }
+        }
+        break;
+    }
+    case sv2::kSubmitSharesSuccess: {
+        auto msg = sv2::SubmitSharesSuccess::decode(reader);
+        if (!client_.isOurChannel(msg.channelId)) {
+            break;
+        }
+        // Um Success confirma todos os submits até last_sequence_number.
+        {
+            std::lock_guard<std::mutex> lock(submitMutex_);
+            auto end = pendingSubmits_.upper_bound(msg.lastSequenceNumber);
+            for (auto it = pendingSubmits_.begin(); it != end; ++it) {
+                traceAsyncEnd("share.submit_to_ack", it->first, traceScope_);
+            }
+            pendingSubmits_.erase(pendingSubmits_.begin(), end);
+        }
+        submitCv_.notify_all();
+        std::cout << "\033[1;32m[*] Share accepted! (" << msg.newSubmitsAcceptedCount << " new)\033[0m" << std::endl;
+        break;
+    }
+    case sv2::kSubmitSharesError: {
+        auto msg = sv2::SubmitSharesError::decode(reader);
+        if (!client_.isOurChannel(msg.channelId)) {
+            break;
+        }
+        {
+            std::lock_guard<std::mutex> lock(submitMutex_);
+            if (pendingSubmits_.erase(msg.sequenceNumber) > 0) {
+                traceAsyncEnd("share.submit_to_ack", msg.sequenceNumber, traceScope_);
+            }
+        }
+        submitCv_.notify_all();
+        std::cout << "\033[1;31m[!] Share rejected with error: " << msg.errorCode << "\033[0m" << std::endl;
+        break;
+    }
+    default:
+        std::cout << "Ignored SV2 message 0x" << std::hex << int(header.msgType) << std::dec << std::endl;
+    }
+}
+
+/**
+ * Converte um job do canal padrão para o formato do engine.
+ * @param job O NewMiningJob.
+ * @param ntime ntime inicial (min_ntime do job ou do prevhash).
+ * @param clean Se o prevhash mudou (trabalho anterior virou obsoleto).
+ */
+void Sv2WorkSource::activate(const sv2::NewMiningJob& job, uint32_t ntime, bool clean) {
+    // O engine guarda o prevhash como o Stratum V1: palavras de 32 bits com
+    // os bytes invertidos em relação à ordem interna do U256.
+    std::array<uint8_t, 32> prev = prevHash_.prevHash;
+    for (std::size_t i = 0; i < prev.size(); i += 4) {
+        std::swap(prev[i], prev[i + 3]);
+        std::swap(prev[i + 1], prev[i + 2]);
+    }
+
+    MiningJob mining;
+    mining.jobId = std::to_string(job.jobId);
+    mining.prevHash = encodeHex(prev.data(), prev.size());
+    mining.merkleRoot = encodeHex(job.merkleRoot.data(), job.merkleRoot.size());
+    mining.shareTarget = target_;
+    mining.versionInt = job.version;
+    mining.bits = prevHash_.nbits;
+    mining.ntime = ntime;
+    mining.version = hexU32(mining.versionInt);
+    mining.nBits = hexU32(mining.bits);
+    mining.nTime = hexU32(mining.ntime);
+    mining.cleanJobs = clean;
+    mining.valid = true;
+    current_ = mining;
+    {
+        std::lock_guard<std::mutex> lock(submitMutex_);
+        // Prevhash novo: jobs anteriores viraram obsoletos e o pool os recusaria.
+        if (clean) {
+            channelJobs_.clear();
+        }
+        channelJobs_[job.jobId] = mining.merkleRoot;
+    }
+    if (onJob) {
+        onJob(mining, "", 0, client_.lastReadTimestamp());
+    }
+    std::cout << "Current job: " << mining.jobId << std::endl;
+}
+
+/**
+ * Envia ao pool um share que já passou pela verificação de referência.
+ * Roda na thread do verificador.
+ * @param share O share verificado.
+ */
+void Sv2WorkSource::submitShare(const ShareCandidate& share) {
+    std::cout << "Submitting share: Job ID: " << share.job.jobId << ", Nonce: " << share.nonce
+              << " (kernel " << share.kernel << ")" << std::endl;
+    TraceSpan span("share.submit", share.nonce);
+    uint32_t jobId = 0;
+    const std::string& text = share.job.jobId;
+    const auto parsed = std::from_chars(text.data(), text.data() + text.size(), jobId);
+    if (parsed.ec != std::errc() || parsed.ptr != text.data() + text.size()) {
+        std::cerr << "SV2 share with invalid job id '" << text << "' dropped" << std::endl;
+        return;
+    }
+    std::lock_guard<std::mutex> lock(submitMutex_);
+    // Share de um job de antes da reconexão: o canal novo só o recusaria.
+    auto live = channelJobs_.find(jobId);
+    if (live == channelJobs_.end() || live->second != share.job.merkleRoot) {
+        std::cerr << "SV2 share for job " << text << " from a previous connection dropped" << std::endl;
+        return;
+    }
+    const uint32_t sequence = client_.submitShare(jobId, share.nonce, share.ntime, share.job.versionInt);
+    traceAsyncBegin("share.submit_to_ack", sequence, 0, traceScope_);
+    pendingSubmits_[sequence] = std::chrono::steady_clock::now();
+}
+
+void Sv2WorkSource::drain(std::chrono::milliseconds timeout) {
+    std::unique_lock<std::mutex> lock(submitMutex_);
+    if (pendingSubmits_.empty()) {
+        return;
+    }
+    std::cout << "Waiting for " << pendingSubmits_.size() << " pending submit(s) on " << name() << "..." << std::endl;
+    if (!submitCv_.wait_for(lock, timeout, [this] { return pendingSubmits_.empty(); })) {
+        std::cerr << "Gave up on " << pendingSubmits_.size() << " unanswered submit(s) on " << name() << std::endl;
+    }
+}
+
+} // namespace nerdminer
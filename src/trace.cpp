@@ -0,0 +1,194 @@
+/**
+* Project: nerdminer-rpi
+* File: trace.cpp
+* Description: per-thread trace buffers and Chrome trace JSON export
+*
+* Author: Regis Araujo Melo
+* Date: 2025-04-21
+* Version: 0.1.0
+*
+* MIT License
+* © 2025 Regis Araujo Melo
+*/
+
+#include "nerdminer/trace.h"
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <nlohmann/json.hpp>
+
+namespace nerdminer {
+
+std::atomic<bool> gTraceEnabled{false};
+
+namespace {
+
+    struct TraceEvent {
+        const char* name;
+        char phase;
+        uint64_t ts;
+        uint64_t dur;
+        uint64_t id;
+        uint64_t scope;
+    };
+
+    // Um buffer por thread. O mutex só disputa com writeTrace(), então na
+    // prática é sempre livre no caminho quente.
+    struct ThreadBuffer {
+        std::mutex mutex;
+        long tid = 0;
+        std::string name;
+        std::vector<TraceEvent> events;
+        uint64_t dropped = 0;
+    };
+
+    std::mutex gRegistryMutex;
+    std::vector<std::unique_ptr<ThreadBuffer>> gBuffers;
+    std::size_t gMaxEvents = 1 << 16;
+    std::atomic<uint64_t> gNextScope{1};
+    const auto gEpoch = std::chrono::steady_clock::now();
+
+    // Bits baixos do id exportado ficam com o id do chamador, os altos com o scope.
+    constexpr int kScopeShift = 40;
+
+    ThreadBuffer& localBuffer() {
+        thread_local ThreadBuffer* buffer = nullptr;
+        if (!buffer) {
+            auto owned = std::make_unique<ThreadBuffer>();
+            owned->tid = static_cast<long>(syscall(SYS_gettid));
+            owned->events.reserve(1024);
+            buffer = owned.get();
+            std::lock_guard<std::mutex> lock(gRegistryMutex);
+            gBuffers.push_back(std::move(owned));
+        }
+        return *buffer;
+    }
+
+    void record(const char* name, char phase, uint64_t ts, uint64_t dur, uint64_t id, uint64_t scope = 0) {
+        ThreadBuffer& buffer = localBuffer();
+        std::lock_guard<std::mutex> lock(buffer.mutex);
+        if (buffer.events.size() >= gMaxEvents) {
+            buffer.dropped++;
+            return;
+        }
+        buffer.events.push_back(TraceEvent{name, phase, ts, dur, id, scope});
+    }
+
+} // namespace
+
+void traceEnable(std::size_t maxEventsPerThread) {
+    gMaxEvents = maxEventsPerThread;
+    gTraceEnabled.store(true, std::memory_order_relaxed);
+}
+
+void traceSetThreadName(const std::string& name) {
+    if (!traceEnabled()) {
+        return;
+    }
+    ThreadBuffer& buffer = localBuffer();
+    std::lock_guard<std::mutex> lock(buffer.mutex);
+    buffer.name = name;
+}
+
+/**
+ * Nanossegundos desde o início do processo (steady_clock). Nunca retorna 0,
+ * que TraceSpan usa como "trace desligado".
+ */
+uint64_t traceNow() {
+    auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - gEpoch).count();
+    return static_cast<uint64_t>(ns) + 1;
+}
+
+void traceComplete(const char* name, uint64_t startNs, uint64_t endNs, uint64_t id) {
+    if (traceEnabled()) {
+        record(name, 'X', startNs, endNs - startNs, id);
+    }
+}
+
+void traceInstant(const char* name, uint64_t id) {
+    if (traceEnabled()) {
+        record(name, 'i', traceNow(), 0, id);
+    }
+}
+
+void traceAsyncBegin(const char* name, uint64_t id, uint64_t tsNs, uint64_t scope) {
+    if (traceEnabled()) {
+        record(name, 'b', tsNs ? tsNs : traceNow(), 0, id, scope);
+    }
+}
+
+void traceAsyncEnd(const char* name, uint64_t id, uint64_t scope) {
+    if (traceEnabled()) {
+        record(name, 'e', traceNow(), 0, id, scope);
+    }
+}
+
+/**
+ * Scope novo para ids de eventos assíncronos; 0 é o scope global.
+ */
+uint64_t traceNewScope() {
+    return gNextScope.fetch_add(1, std::memory_order_relaxed);
+}
+
+/**
+ * Grava todos os buffers no formato JSON do Chrome trace (abre no Perfetto
+ * e em chrome://tracing). Os buffers continuam acumulando depois.
+ * @param path Arquivo de saída.
+ * @return False se o arquivo não puder ser escrito.
+ */
+bool writeTrace(const std::string& path) {
+    using json = nlohmann::json;
+    const long pid = static_cast<long>(getpid());
+    json events = json::array();
+
+    std::lock_guard<std::mutex> registryLock(gRegistryMutex);
+    for (const auto& buffer : gBuffers) {
+        std::lock_guard<std::mutex> lock(buffer->mutex);
+        if (!buffer->name.empty()) {
+            events.push_back({{"ph", "M"}, {"name", "thread_name"}, {"pid", pid}, {"tid", buffer->tid},
+                {"args", {{"name", buffer->name}}}});
+        }
+        for (const auto& ev : buffer->events) {
+            const char* dot = std::strchr(ev.name, '.');
+            json e = {
+                {"name", ev.name},
+                {"cat", dot ? std::string(ev.name, dot) : std::string(ev.name)},
+                {"ph", std::string(1, ev.phase)},
+                {"ts", ev.ts / 1000.0},
+                {"pid", pid},
+                {"tid", buffer->tid}
+            };
+            if (ev.phase == 'X') {
+                e["dur"] = ev.dur / 1000.0;
+            } else if (ev.phase == 'i') {
+                e["s"] = "t";
+            }
+            if (ev.phase == 'b' || ev.phase == 'e') {
+                // id2.local: ids valem só dentro deste processo.
+                e["id2"] = {{"local", (ev.scope << kScopeShift) | (ev.id & ((uint64_t(1) << kScopeShift) - 1))}};
+                e["args"] = {{"id", ev.id}, {"scope", ev.scope}};
+            } else if (ev.id != 0) {
+                e["args"] = {{"id", ev.id}};
+            }
+            events.push_back(std::move(e));
+        }
+        if (buffer->dropped) {
+            events.push_back({{"ph", "i"}, {"name", "trace.dropped"}, {"s", "t"}, {"pid", pid},
+                {"tid", buffer->tid}, {"ts", traceNow() / 1000.0}, {"args", {{"count", buffer->dropped}}}});
+        }
+    }
+
+    std::ofstream out(path);
+    if (!out) {
+        return false;
+    }
+    out << json{{"traceEvents", events}, {"displayTimeUnit", "ms"}}.dump() << "\n";
+    return static_cast<bool>(out);
+}
+
+} // namespace nerdminer
@@ -0,0 +1,74 @@
+/**
+* Project: nerdminer-rpi
+* File: check.h
+* Description: minimal assertion helpers shared by the unit tests
+*
+* Author: Regis Araujo Melo
+* Date: 2025-04-21
+* Version: 0.1.0
+*
+* MIT License
+* © 2025 Regis Araujo Melo
+*/
+
+#pragma once
+
+#include <iostream>
+#include <sstream>
+#include <string>
+
+namespace nerdminer::test {
+
+    // Cada teste é um executável: as verificações que falham são contadas e
+    // o main devolve report(), que vira o código de saída do processo.
+    inline int& failures() {
+        static int count = 0;
+        return count;
+    }
+
+    inline void fail(const char* file, int line, const std::string& what) {
+        std::cerr << file << ":" << line << ": " << what << std::endl;
+        ++failures();
+    }
+
+    inline int report(const char* name) {
+        if (failures() == 0) {
+            std::cout << name << ": ok" << std::endl;
+            return 0;
+        }
+        std::cout << name << ": " << failures() << " failure(s)" << std::endl;
+        return 1;
+    }
+
+} // namespace nerdminer::test
+
+#define CHECK(cond)                                                             \
+    do {                                                                        \
+        if (!(cond)) {                                                          \
+            nerdminer::test::fail(__FILE__, __LINE__, "CHECK(" #cond ")");      \
+        }                                                                       \
+    } while (0)
+
+#define CHECK_EQ(a, b)                                                          \
+    do {                                                                        \
+        const auto& checkA_ = (a);                                              \
+        const auto& checkB_ = (b);                                              \
+        if (!(checkA_ == checkB_)) {                                            \
+            std::ostringstream checkOs_;                                        \
+            checkOs_ << "CHECK_EQ(" #a ", " #b "): " << checkA_ << " != " << checkB_; \
+            nerdminer::test::fail(__FILE__, __LINE__, checkOs_.str());          \
+        }                                                                       \
+    } while (0)
+
+#define CHECK_THROWS(expr, type)                                                \
+    do {                                                                        \
+        bool checkThrown_ = false;                                              \
+        try {                                                                   \
+            (void)(expr);                                                       \
+        } catch (const type&) {                                                 \
+            checkThrown_ = true;                                                \
+        }                                                                       \
+        if (!checkThrown_) {                                                    \
+            nerdminer::test::fail(__FILE__, __LINE__, "CHECK_THROWS(" #expr ", " #type ")"); \
+        }                                                                       \
+    } while (0)
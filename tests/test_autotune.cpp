@@ -0,0 +1,126 @@
+/**
+* Project: nerdminer-rpi
+* File: test_autotune.cpp
+* Description: tests the autotune cache: round trip, CPU and build keys, reuse by resolveTuning
+*
+* Author: Regis Araujo Melo
+* Date: 2025-04-21
+* Version: 0.1.0
+*
+* MIT License
+* © 2025 Regis Araujo Melo
+*/
+
+#include "check.h"
+#include <nerdminer/autotune.h>
+#include <nerdminer/hash_kernel.h>
+#include <nlohmann/json.hpp>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <unistd.h>
+
+using namespace nerdminer;
+using json = nlohmann::json;
+
+namespace {
+
+// Diretório temporário próprio do teste; o cache fica num subdiretório
+// para exercitar a criação dos diretórios intermediários.
+std::string tempDir() {
+    char pattern[] = "/tmp/nerdminer-autotune-XXXXXX";
+    const char* dir = ::mkdtemp(pattern);
+    CHECK(dir != nullptr);
+    return dir ? dir : "/tmp";
+}
+
+// Um kernel que existe nesta build e que não é a referência.
+std::string someKernel() {
+    for (const auto& name : kernelNames()) {
+        if (name != "reference") {
+            return name;
+        }
+    }
+    return "reference";
+}
+
+void testRoundTrip(const std::string& path) {
+    TuneResult saved;
+    saved.kernel = someKernel();
+    saved.batchSize = 777;
+    saved.hashrate = 1234.5;
+    CHECK(saveTuneResult(path, "cpu-a", saved));
+
+    TuneResult loaded;
+    CHECK(loadTuneResult(path, "cpu-a", loaded));
+    CHECK_EQ(loaded.kernel, saved.kernel);
+    CHECK_EQ(loaded.batchSize, 777u);
+    CHECK_EQ(loaded.hashrate, 1234.5);
+
+    // Uma segunda CPU entra no mesmo arquivo sem apagar a primeira.
+    TuneResult other = saved;
+    other.batchSize = 1024;
+    CHECK(saveTuneResult(path, "cpu-b", other));
+    CHECK(loadTuneResult(path, "cpu-a", loaded));
+    CHECK_EQ(loaded.batchSize, 777u);
+    CHECK(loadTuneResult(path, "cpu-b", loaded));
+    CHECK_EQ(loaded.batchSize, 1024u);
+}
+
+void testForeignEntriesIgnored(const std::string& path) {
+    TuneResult saved;
+    saved.kernel = someKernel();
+    saved.batchSize = 2048;
+    CHECK(saveTuneResult(path, "cpu-a", saved));
+
+    TuneResult loaded;
+    CHECK(!loadTuneResult(path, "cpu-other", loaded));
+
+    // Entradas de outra build, sem build ou com kernel inexistente não valem.
+    json cache = {
+        {"old-build", {{"kernel", saved.kernel}, {"batchSize", 2048}, {"build", "some other compiler"}}},
+        {"no-build", {{"kernel", saved.kernel}, {"batchSize", 2048}}},
+        {"gone-kernel", {{"kernel", "no-such-kernel"}, {"batchSize", 2048}, {"build", buildId()}}},
+        {"current", {{"kernel", saved.kernel}, {"batchSize", 2048}, {"build", buildId()}}}
+    };
+    std::ofstream(path) << cache.dump();
+    CHECK(!loadTuneResult(path, "old-build", loaded));
+    CHECK(!loadTuneResult(path, "no-build", loaded));
+    CHECK(!loadTuneResult(path, "gone-kernel", loaded));
+    CHECK(loadTuneResult(path, "current", loaded));
+
+    std::ofstream(path) << "{not json";
+    CHECK(!loadTuneResult(path, "current", loaded));
+    CHECK(!loadTuneResult(path + ".missing", "current", loaded));
+}
+
+/**
+ * Com um cache válido para esta CPU e build, resolveTuning não roda o
+ * autotuner: o lote 777 nunca sairia de uma medição.
+ */
+void testResolveReusesCache(const std::string& path) {
+    TuneResult saved;
+    saved.kernel = someKernel();
+    saved.batchSize = 777;
+    CHECK(saveTuneResult(path, cpuModel(), saved));
+    TuneResult resolved = resolveTuning(path, false);
+    CHECK_EQ(resolved.kernel, saved.kernel);
+    CHECK_EQ(resolved.batchSize, 777u);
+}
+
+} // namespace
+
+int main() {
+    const std::string dir = tempDir();
+    const std::string path = dir + "/cache/autotune.json";
+    testRoundTrip(path);
+    std::remove(path.c_str());
+    testForeignEntriesIgnored(path);
+    std::remove(path.c_str());
+    testResolveReusesCache(path);
+    std::remove(path.c_str());
+    ::rmdir((dir + "/cache").c_str());
+    ::rmdir(dir.c_str());
+    return test::report("autotune");
+}
@@ -0,0 +1,264 @@
+/**
+* Project: nerdminer-rpi
+* File: test_block_template.cpp
+* Description: tests the solo coinbase, Merkle branches and a block round trip against the mock node
+*
+* Author: Regis Araujo Melo
+* Date: 2025-04-21
+* Version: 0.1.0
+*
+* MIT License
+* © 2025 Regis Araujo Melo
+*/
+
+#include "check.h"
+#include <nerdminer/block_template.h>
+#include <nerdminer/gbt_client.h>
+#include <nerdminer/hex.h>
+#include <nerdminer/mock_node.h>
+#include <nerdminer/nerdminer_block.h>
+#include <boost/asio.hpp>
+#include <boost/beast.hpp>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <thread>
+#include <unistd.h>
+
+using namespace nerdminer;
+
+namespace {
+
+std::string txidOf(int i) {
+    const std::string seed = "tx" + std::to_string(i);
+    return bytesToHex(doubleSHA256(std::vector<uint8_t>(seed.begin(), seed.end())));
+}
+
+json sampleTemplate() {
+    return {
+        {"version", 0x20000000},
+        {"height", 227836},
+        {"curtime", 1700000000},
+        {"coinbasevalue", 625000000},
+        {"previousblockhash", "00000000000000000002a7c4c1e48d76c5a37902165a270156b7a8d72728a054"},
+        {"bits", "1d00ffff"},
+        {"longpollid", "lp1"},
+        {"default_witness_commitment", "6a24aa21a9ed" + std::string(64, 'e')},
+        {"transactions", json::array({{{"txid", std::string(64, 'a')}, {"data", "0200"}}})}
+    };
+}
+
+uint16_t freePort() {
+    using tcp = boost::asio::ip::tcp;
+    boost::asio::io_context io;
+    tcp::acceptor acceptor(io, tcp::endpoint(boost::asio::ip::address_v4::loopback(), 0));
+    return acceptor.local_endpoint().port();
+}
+
+// O nó falso só escuta depois que a thread dele sobe.
+json callWithRetry(const GbtClient& client, const std::string& method, const json& params) {
+    for (int attempt = 0;; ++attempt) {
+        try {
+            return client.call(method, params, std::chrono::seconds(5));
+        } catch (const std::runtime_error&) {
+            if (attempt == 100) {
+                throw;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        }
+    }
+}
+
+// POST com corpo arbitrário, para mandar ao nó o que o GbtClient nunca mandaria.
+json rawPost(uint16_t port, const std::string& body) {
+    namespace http = boost::beast::http;
+    using tcp = boost::asio::ip::tcp;
+    boost::asio::io_context io;
+    tcp::socket socket(io);
+    socket.connect(tcp::endpoint(boost::asio::ip::address_v4::loopback(), port));
+    http::request<http::string_body> req{http::verb::post, "/", 11};
+    req.set(http::field::host, "127.0.0.1");
+    req.body() = body;
+    req.prepare_payload();
+    http::write(socket, req);
+    boost::beast::flat_buffer buffer;
+    http::response<http::string_body> res;
+    http::read(socket, buffer, res);
+    return json::parse(res.body());
+}
+
+// Monta e minera um bloco completo a partir do template, como um minerador solo.
+std::string mineBlock(const BlockTemplate& tmpl) {
+    const std::string extranonce(16, '0');
+    const CoinbaseParts parts = buildSoloCoinbase(tmpl, "51", 8, "/test/");
+    const std::string coinbase = parts.coinbase1 + extranonce + parts.coinbase2;
+
+    std::vector<std::string> txids;
+    for (const std::string& txid : tmpl.txids) {
+        txids.push_back(reverseHexBytes(txid));
+    }
+    BlockHeader header;
+    header.version = tmpl.version;
+    header.prevHash = reverseHexBytes(tmpl.previousBlockHash);
+    header.merkleRoot = calculateMerkleRoot(coinbase, merkleBranchesFor(txids));
+    header.timestamp = tmpl.curtime;
+    header.bits = tmpl.bits;
+    for (header.nonce = 0;; ++header.nonce) {
+        if (isHashBelowTarget(doubleSHA256(buildBlockHeader(header)), targetFromBits(tmpl.bits))) {
+            break;
+        }
+    }
+
+    std::vector<uint8_t> headerBytes = buildBlockHeader(header);
+    std::string block = bytesToHex(headerBytes) + encodeVarInt(1 + tmpl.txData.size())
+        + addCoinbaseWitness(coinbase);
+    for (const std::string& tx : tmpl.txData) {
+        block += tx;
+    }
+    return block;
+}
+
+} // namespace
+
+int main() {
+    // Um nó falso travado não deve prender o make check para sempre.
+    alarm(30);
+
+    CHECK_EQ(reverseHexBytes("0102ab"), "ab0201");
+    CHECK_EQ(reverseHexBytes(""), "");
+
+    // CompactSize nos limites de cada largura.
+    CHECK_EQ(encodeVarInt(0), "00");
+    CHECK_EQ(encodeVarInt(0xfc), "fc");
+    CHECK_EQ(encodeVarInt(0xfd), "fdfd00");
+    CHECK_EQ(encodeVarInt(0xffff), "fdffff");
+    CHECK_EQ(encodeVarInt(0x10000), "fe00000100");
+    CHECK_EQ(encodeVarInt(0xffffffffull), "feffffffff");
+    CHECK_EQ(encodeVarInt(0x100000000ull), "ff0000000001000000");
+
+    // Números de script como o Bitcoin Core; 227836 é a altura do primeiro bloco BIP 34.
+    CHECK_EQ(pushScriptNum(0), "00");
+    CHECK_EQ(pushScriptNum(1), "51");
+    CHECK_EQ(pushScriptNum(16), "60");
+    CHECK_EQ(pushScriptNum(17), "0111");
+    CHECK_EQ(pushScriptNum(127), "017f");
+    CHECK_EQ(pushScriptNum(128), "028000");
+    CHECK_EQ(pushScriptNum(256), "020001");
+    CHECK_EQ(pushScriptNum(-1), "0181");
+    CHECK_EQ(pushScriptNum(227836), "03fc7903");
+
+    // Template: campos lidos, e campos faltando ou malformados rejeitados.
+    BlockTemplate tmpl = BlockTemplate::fromJson(sampleTemplate());
+    CHECK_EQ(tmpl.height, 227836u);
+    CHECK_EQ(tmpl.bits, 0x1d00ffffu);
+    CHECK_EQ(tmpl.coinbaseValue, 625000000u);
+    CHECK_EQ(tmpl.longpollId, "lp1");
+    CHECK_EQ(tmpl.txids.size(), 1u);
+    CHECK_EQ(tmpl.txData.size(), 1u);
+    for (const char* field : {"version", "height", "bits", "previousblockhash", "transactions"}) {
+        json broken = sampleTemplate();
+        broken.erase(field);
+        CHECK_THROWS(BlockTemplate::fromJson(broken), std::invalid_argument);
+    }
+    json badBits = sampleTemplate();
+    badBits["bits"] = "1d00fff";
+    CHECK_THROWS(BlockTemplate::fromJson(badBits), std::invalid_argument);
+    json badTx = sampleTemplate();
+    badTx["transactions"][0]["txid"] = "abcd";
+    CHECK_THROWS(BlockTemplate::fromJson(badTx), std::invalid_argument);
+
+    // Coinbase: altura BIP 34, extranonce, tag, saída de pagamento e commitment.
+    const std::string payout = "0014" + std::string(40, '1');
+    CoinbaseParts parts = buildSoloCoinbase(tmpl, payout, 8, "/nerdminer-rpi/");
+    CHECK_EQ(parts.coinbase1, "02000000" "01" + std::string(64, '0') + "ffffffff"
+        "1d"                 // 4 (altura) + 1 + 8 (extranonce) + 16 (tag)
+        "03fc7903" "08");
+    CHECK_EQ(parts.coinbase2, "0f2f6e6572646d696e65722d7270692f" "ffffffff" "02"
+        "40be402500000000" "16" + payout
+        + "0000000000000000" "26" "6a24aa21a9ed" + std::string(64, 'e')
+        + "00000000");
+
+    // Sem segwit não há saída de commitment.
+    BlockTemplate legacy = tmpl;
+    legacy.witnessCommitment.clear();
+    CHECK(buildSoloCoinbase(legacy, payout, 8, "").coinbase2.find("6a24aa21a9ed") == std::string::npos);
+
+    // O scriptSig não passa de 100 bytes: a tag é truncada, o extranonce nunca.
+    const std::string longTag(200, 'x');
+    parts = buildSoloCoinbase(tmpl, payout, 8, longTag);
+    CHECK_EQ(parts.coinbase1.substr(82, 2), "59"); // 14 + 75 (maior push direto)
+    CHECK_EQ(parts.coinbase2.substr(0, 2), "4b");
+    parts = buildSoloCoinbase(tmpl, payout, 40, longTag);
+    CHECK_EQ(parts.coinbase1.substr(82, 2), "64");
+    CHECK_THROWS(buildSoloCoinbase(tmpl, payout, 95, ""), std::invalid_argument);
+    CHECK_THROWS(buildSoloCoinbase(tmpl, "", 8, ""), std::invalid_argument);
+    CHECK_THROWS(buildSoloCoinbase(tmpl, "zz", 8, ""), std::invalid_argument);
+
+    // Witness da coinbase: marker/flag depois da versão, valor reservado antes do locktime.
+    const std::string plain = "02000000" "aabb" "00000000";
+    CHECK_EQ(addCoinbaseWitness(plain), "02000000" "0001" "aabb" "0120" + std::string(64, '0') + "00000000");
+    CHECK_THROWS(addCoinbaseWitness("0200"), std::invalid_argument);
+
+    // Raiz Merkle do bloco 100000 (txids exibidos; a raiz confere com a do header).
+    std::vector<std::string> block100k;
+    for (const char* txid : {"8c14f0db3df150123e6f3dbbf30f8b955a8249b62ac1d1ff16284aefa3d06d87",
+                             "fff2525b8931402dd09222c50775608f75787bd2b87e56995a7bdd30f79702c4",
+                             "6359f0868171b1d194cbee1af2f16ea598ae8fad666d9b012c8ed2b79a236ec4",
+                             "e9a66845e05d5abc0ad04ec80f774a7e585c6e8db975962d069a522137b80c1d"}) {
+        block100k.push_back(reverseHexBytes(txid));
+    }
+    CHECK_EQ(reverseHexBytes(merkleRootOf(block100k)),
+        "f3e94742aca4b5ef85488dc37c06c3282295ffec960994b2c0d5ac2a25a95766");
+    CHECK_EQ(merkleRootOf({txidOf(0)}), txidOf(0));
+    CHECK_THROWS(merkleRootOf({}), std::invalid_argument);
+
+    // Os ramos da coinbase reconstroem a mesma raiz da lista completa,
+    // inclusive com quantidades ímpares em cada nível.
+    const std::string coinbase = parts.coinbase1 + std::string(80, '0') + parts.coinbase2;
+    const std::string coinbaseTxid = bytesToHex(doubleSHA256(decodeHex(coinbase)));
+    for (int count = 0; count <= 9; ++count) {
+        std::vector<std::string> txids;
+        for (int i = 0; i < count; ++i) {
+            txids.push_back(txidOf(i));
+        }
+        std::vector<std::string> all{coinbaseTxid};
+        all.insert(all.end(), txids.begin(), txids.end());
+        const std::vector<std::string> branches = merkleBranchesFor(txids);
+        CHECK_EQ(calculateMerkleRoot(coinbase, branches), merkleRootOf(all));
+        CHECK(count != 0 || branches.empty());
+    }
+
+    // Ida e volta com o nó falso: template, bloco minerado e submitblock.
+    MockNodeConfig nodeConfig;
+    nodeConfig.port = freePort();
+    nodeConfig.bits = 0x207fffff;
+    auto* node = new MockNode(nodeConfig);
+    std::thread([node] { node->start(); }).detach();
+
+    GbtClient client("127.0.0.1", nodeConfig.port, "user", "pass");
+    const json request = json::array({{{"rules", json::array({"segwit"})}}});
+    BlockTemplate fromNode = BlockTemplate::fromJson(callWithRetry(client, "getblocktemplate", request));
+    CHECK_EQ(fromNode.txids.size(), nodeConfig.mempoolSize);
+    CHECK(!fromNode.witnessCommitment.empty());
+    const std::string block = mineBlock(fromNode);
+    CHECK(client.call("submitblock", json::array({block})).is_null());
+    // O mesmo bloco de novo já não estende a ponta.
+    CHECK_EQ(client.call("submitblock", json::array({block})).get<std::string>(), "prev-blk-not-found");
+    BlockTemplate next = BlockTemplate::fromJson(client.call("getblocktemplate", request));
+    CHECK_EQ(next.height, fromNode.height + 1);
+    CHECK_THROWS(client.call("no-such-method", json::array()), std::runtime_error);
+    // Cancelado, o cliente recusa chamadas até resume().
+    client.cancel();
+    CHECK_THROWS(client.call("getblocktemplate", request), std::runtime_error);
+    client.resume();
+    CHECK(client.call("getblocktemplate", request).is_object());
+    // Corpo que não é JSON: erro de parse do JSON-RPC, e o nó continua atendendo.
+    CHECK_EQ(rawPost(nodeConfig.port, "{not json")["error"]["code"].get<int>(), -32700);
+    CHECK_EQ(rawPost(nodeConfig.port, "[1, 2]")["error"]["code"].get<int>(), -32700);
+    CHECK_EQ(BlockTemplate::fromJson(client.call("getblocktemplate", request)).height, next.height);
+
+    // A thread do nó falso continua bloqueada no accept.
+    std::cout.flush();
+    std::_Exit(nerdminer::test::report("block_template"));
+}
@@ -0,0 +1,109 @@
+/**
+* Project: nerdminer-rpi
+* File: test_hash_kernel.cpp
+* Description: tests every hashing kernel against the reference path
+*
+* Author: Regis Araujo Melo
+* Date: 2025-04-21
+* Version: 0.1.0
+*
+* MIT License
+* © 2025 Regis Araujo Melo
+*/
+
+#include "check.h"
+#include <nerdminer/hash_kernel.h>
+#include <nerdminer/nerdminer_block.h>
+#include <algorithm>
+
+using namespace nerdminer;
+
+namespace {
+
+BlockHeader makeHeader() {
+    BlockHeader header;
+    header.version = 0x20000000;
+    header.prevHash = "00000000000000000002a7c4c1e48d76c5a37902165a270156b7a8d72728a054";
+    header.merkleRoot = "4a5e1e4baab89f3a32518a88c31bc87f618f76673e2cc77ab2127b7afdeda33b";
+    header.timestamp = 0x5f5e1000;
+    header.bits = 0x1d00ffff;
+    header.nonce = 0;
+    return header;
+}
+
+std::string describe(const std::string& kernel, uint32_t start, uint32_t count) {
+    return kernel + " start=" + std::to_string(start) + " count=" + std::to_string(count);
+}
+
+// Compara os acertos do kernel com os do caminho de referência, nonce a nonce.
+void checkAgainstReference(HashKernel& kernel, HashKernel& reference, const HeaderTemplate& tmpl,
+    uint32_t start, uint32_t count, const Target& target) {
+    std::vector<HashHit> expected;
+    std::vector<HashHit> actual;
+    CHECK_EQ(reference.hashHeaders(tmpl, start, count, target, expected), count);
+    CHECK_EQ(kernel.hashHeaders(tmpl, start, count, target, actual), count);
+    if (actual.size() != expected.size()) {
+        nerdminer::test::fail(__FILE__, __LINE__, describe(kernel.name(), start, count) + ": hit count differs");
+        return;
+    }
+    for (std::size_t i = 0; i < expected.size(); ++i) {
+        if (actual[i].nonce != expected[i].nonce || actual[i].hash != expected[i].hash) {
+            nerdminer::test::fail(__FILE__, __LINE__, describe(kernel.name(), start, count)
+                + ": hit " + std::to_string(i) + " differs");
+            return;
+        }
+    }
+}
+
+} // namespace
+
+int main() {
+    const BlockHeader header = makeHeader();
+    const HeaderTemplate tmpl = HeaderTemplate::fromHeader(header);
+    auto reference = makeKernel("reference");
+    CHECK(reference != nullptr);
+    CHECK(makeKernel("no-such-kernel") == nullptr);
+
+    // O template com o nonce gravado serializa igual ao buildBlockHeader.
+    Target everything;
+    everything.fill(0xFF);
+    std::vector<HashHit> hits;
+    reference->hashHeaders(tmpl, 12345, 1, everything, hits);
+    BlockHeader withNonce = header;
+    withNonce.nonce = 12345;
+    std::vector<uint8_t> direct = doubleSHA256(buildBlockHeader(withNonce));
+    CHECK(hits.size() == 1 && std::equal(direct.begin(), direct.end(), hits[0].hash.begin()));
+
+    // Cerca de metade dos hashes atende este alvo.
+    Target half;
+    half.fill(0xFF);
+    half[0] = 0x7F;
+    half[31] = 0x7F;
+
+    // Tamanhos que não são múltiplos das vias do kernel exercitam as sobras
+    // do fim do lote; o início perto de 2^32 exercita a volta do nonce.
+    const uint32_t counts[] = {0, 1, 3, 7, 17, 37, 64, 69, 1000};
+    const uint32_t starts[] = {0, 1000003, 0xFFFFFFF0u};
+    for (const std::string& name : kernelNames()) {
+        if (name == "reference") {
+            continue;
+        }
+        auto kernel = makeKernel(name);
+        CHECK(kernel != nullptr);
+        if (!kernel) {
+            continue;
+        }
+        for (uint32_t start : starts) {
+            for (uint32_t count : counts) {
+                checkAgainstReference(*kernel, *reference, tmpl, start, count, everything);
+                checkAgainstReference(*kernel, *reference, tmpl, start, count, half);
+            }
+        }
+        // Acertos de lotes anteriores continuam em hitsOut.
+        std::vector<HashHit> accumulated(1);
+        kernel->hashHeaders(tmpl, 0, 5, everything, accumulated);
+        CHECK_EQ(accumulated.size(), 6u);
+    }
+
+    return nerdminer::test::report("hash_kernel");
+}
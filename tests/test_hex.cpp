@@ -0,0 +1,76 @@
+/**
+* Project: nerdminer-rpi
+* File: test_hex.cpp
+* Description: tests the hex codec, including the strict validation edge cases
+*
+* Author: Regis Araujo Melo
+* Date: 2025-04-21
+* Version: 0.1.0
+*
+* MIT License
+* © 2025 Regis Araujo Melo
+*/
+
+#include "check.h"
+#include <nerdminer/hex.h>
+#include <stdexcept>
+
+using namespace nerdminer;
+
+int main() {
+    // Todos os 256 valores de byte vão e voltam sem perda.
+    std::vector<uint8_t> all(256);
+    for (int i = 0; i < 256; ++i) {
+        all[i] = static_cast<uint8_t>(i);
+    }
+    const std::string allHex = encodeHex(all.data(), all.size());
+    CHECK_EQ(allHex.size(), 512u);
+    CHECK_EQ(allHex.substr(0, 8), "00010203");
+    CHECK_EQ(allHex.substr(504), "fcfdfeff");
+    CHECK(decodeHex(allHex) == all);
+
+    // Maiúsculas e minúsculas são aceitas; a saída é sempre minúscula.
+    CHECK(decodeHex("DEADbeef") == std::vector<uint8_t>({0xde, 0xad, 0xbe, 0xef}));
+    CHECK_EQ(encodeHex(nullptr, 0), "");
+    CHECK(decodeHex("").empty());
+
+    // Tamanho ímpar e qualquer caractere fora de [0-9a-fA-F] são rejeitados,
+    // inclusive os vizinhos dos intervalos válidos e bytes não-ASCII.
+    CHECK_THROWS(decodeHex("abc"), std::invalid_argument);
+    for (const char* bad : {"0g", "g0", "/0", ":0", "@0", "G0", "`0", " 0", "0 ", "0x", "\xff" "0"}) {
+        CHECK_THROWS(decodeHex(bad), std::invalid_argument);
+        CHECK(!isHex(bad));
+    }
+    CHECK_THROWS(decodeHex(std::string("00\0" "0", 4)), std::invalid_argument);
+
+    // Versão sem alocação: o tamanho precisa bater com o destino.
+    std::array<uint8_t, 4> fixed{};
+    CHECK(decodeHex("01020304", fixed));
+    CHECK(fixed == (std::array<uint8_t, 4>{1, 2, 3, 4}));
+    CHECK(!decodeHex("010203", fixed));
+    CHECK(!decodeHex("0102030405", fixed));
+    CHECK(!decodeHex("0102030z", fixed));
+
+    CHECK(isHex("00ff", 2));
+    CHECK(!isHex("00ff", 3));
+    CHECK(!isHex("00f"));
+    CHECK(isHex(""));
+
+    // uint32 como o Stratum escreve: 8 dígitos, big-endian.
+    CHECK_EQ(hexU32(0), "00000000");
+    CHECK_EQ(hexU32(0x1d00ffff), "1d00ffff");
+    CHECK_EQ(hexU32(0xffffffff), "ffffffff");
+    uint32_t value = 0;
+    CHECK(parseHexU32("1D00FFFF", value));
+    CHECK_EQ(value, 0x1d00ffffu);
+    CHECK(parseHexU32("ffffffff", value));
+    CHECK_EQ(value, 0xffffffffu);
+    value = 7;
+    CHECK(!parseHexU32("1d00fff", value));
+    CHECK(!parseHexU32("1d00ffff0", value));
+    CHECK(!parseHexU32("-1d00fff", value));
+    CHECK(!parseHexU32("", value));
+    CHECK_EQ(value, 7u);
+
+    return nerdminer::test::report("hex");
+}
@@ -1,6 +0,0 @@
-#include <iostream>
-
-int main() {
-    std::cout << "Testes do NerdMiner ainda não implementados!" << std::endl;
-    return 0;
-}
@@ -0,0 +1,231 @@
+/**
+* Project: nerdminer-rpi
+* File: test_miner_session.cpp
+* Description: tests the miner session: state file, restart epochs and reconfiguration
+*
+* Author: Regis Araujo Melo
+* Date: 2025-04-21
+* Version: 0.1.0
+*
+* MIT License
+* © 2025 Regis Araujo Melo
+*/
+
+#include "check.h"
+#include <nerdminer/miner_session.h>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <unistd.h>
+#include <vector>
+
+using namespace nerdminer;
+
+namespace {
+
+constexpr uint32_t kJobNtime = 0x5f5e1000;
+
+// Job com alvo de 1/256 e extranonce2 de 1 byte: as épocas de restart só
+// cabem no ntime.
+MiningJob makeJob() {
+    json note = {
+        {"id", nullptr},
+        {"method", "mining.notify"},
+        {"params", json::array({"job1", std::string(64, '0'), "01000000010000", "ffffffff00000000",
+            json::array(), "20000000", "207fffff", "5f5e1000", true})}
+    };
+    MiningJob job = MiningJob::fromNotification(note);
+    job.shareTarget.assign(32, 0xff);
+    job.shareTarget[0] = 0;
+    return job;
+}
+
+using ShareKey = std::tuple<std::string, uint32_t, uint32_t>; // extranonce2, ntime, nonce
+
+// O que uma fonte falsa viu; sobrevive à fonte, que a sessão pode destruir.
+struct SourceLog {
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::vector<ShareKey> shares;
+    json resumed;
+    int starts = 0;
+    int stops = 0;
+
+    bool waitShares(std::size_t count) {
+        std::unique_lock<std::mutex> lock(mutex);
+        return cv.wait_for(lock, std::chrono::seconds(20), [&] { return shares.size() >= count; });
+    }
+
+    std::size_t shareCount() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return shares.size();
+    }
+
+    int startCount() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return starts;
+    }
+
+    int stopCount() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return stops;
+    }
+};
+
+// Fonte sem rede: publica sempre o mesmo job ao iniciar e guarda os shares.
+class FakeSource : public WorkSource {
+public:
+    FakeSource(std::string name, std::shared_ptr<SourceLog> log) : name_(std::move(name)), log_(std::move(log)) {}
+
+    std::string name() const override { return name_; }
+
+    void start() override {
+        {
+            std::lock_guard<std::mutex> lock(log_->mutex);
+            log_->starts++;
+        }
+        onJob(makeJob(), "aabbccdd", 1, 0);
+    }
+
+    void stop() override {
+        std::lock_guard<std::mutex> lock(log_->mutex);
+        if (log_->starts > log_->stops) {
+            log_->stops++;
+        }
+    }
+
+    void submitShare(const ShareCandidate& share) override {
+        std::lock_guard<std::mutex> lock(log_->mutex);
+        log_->shares.push_back(ShareKey{share.extranonce2, share.ntime, share.nonce});
+        log_->cv.notify_all();
+    }
+
+    json sessionState() const override { return {{"session_id", "sess-" + name_}}; }
+
+    void resumeSession(const json& state) override {
+        std::lock_guard<std::mutex> lock(log_->mutex);
+        log_->resumed = state;
+    }
+
+private:
+    std::string name_;
+    std::shared_ptr<SourceLog> log_;
+};
+
+json readState(const std::string& path) {
+    std::ifstream in(path);
+    return json::parse(in, nullptr, false);
+}
+
+// Roda uma sessão com uma fonte até ela receber alguns shares.
+std::shared_ptr<SourceLog> runOnce(const std::string& statePath) {
+    auto log = std::make_shared<SourceLog>();
+    MinerSession session;
+    session.addSource(std::make_unique<FakeSource>("pool-a", log));
+    session.setThreads(2);
+    session.setBatchSize(256);
+    session.setStateFile(statePath);
+    std::thread runner([&session] { session.start(); });
+    CHECK(log->waitShares(8));
+    session.stop();
+    runner.join();
+    return log;
+}
+
+/**
+ * O estado de cada fonte sobrevive ao restart junto com a época, que segue
+ * crescendo; com extranonce2 de 1 byte, a execução retomada no mesmo job
+ * não repete nenhum share da anterior.
+ */
+void testStateAndEpochs(const std::string& path) {
+    // Entradas de fontes que não estão nesta execução são preservadas.
+    std::ofstream(path) << json{{"pool-old", {{"session_id", "old"}}}}.dump();
+
+    std::set<ShareKey> seen;
+    for (uint32_t run = 0; run < 3; ++run) {
+        auto log = runOnce(path);
+        const json& resumed = log->resumed;
+        if (run == 0) {
+            CHECK(resumed.is_null());
+        } else {
+            CHECK_EQ(resumed.value("session_id", ""), std::string("sess-pool-a"));
+            CHECK_EQ(resumed.value("restart_epoch", 0u), run);
+        }
+        for (const auto& share : log->shares) {
+            CHECK_EQ(std::get<1>(share), kJobNtime + run);
+            CHECK(seen.insert(share).second);
+        }
+
+        json state = readState(path);
+        CHECK(!state.is_discarded());
+        CHECK_EQ(state["pool-a"].value("session_id", ""), std::string("sess-pool-a"));
+        CHECK_EQ(state["pool-a"].value("restart_epoch", 0u), run + 1);
+        CHECK_EQ(state["pool-old"].value("session_id", ""), std::string("old"));
+    }
+
+    // Arquivo corrompido: a sessão parte do zero e o regrava.
+    std::ofstream(path) << "{broken";
+    auto log = runOnce(path);
+    CHECK(log->resumed.is_null());
+    CHECK(!log->shares.empty() && std::get<1>(log->shares[0]) == kJobNtime);
+    CHECK_EQ(readState(path)["pool-a"].value("restart_epoch", 0u), 1u);
+}
+
+/**
+ * Reconfigurar mantém conectada a fonte de mesmo nome (sem stop/start) e
+ * ela volta a receber shares; a removida é parada e a nova iniciada.
+ */
+void testReconfigureKeepsSources() {
+    auto kept = std::make_shared<SourceLog>();
+    auto removed = std::make_shared<SourceLog>();
+    auto replacement = std::make_shared<SourceLog>();
+    auto added = std::make_shared<SourceLog>();
+    MinerSession session;
+    session.addSource(std::make_unique<FakeSource>("kept", kept));
+    session.addSource(std::make_unique<FakeSource>("removed", removed));
+    session.setThreads(2);
+    session.setBatchSize(256);
+    std::thread runner([&session] { session.start(); });
+    CHECK(kept->waitShares(4));
+    CHECK(removed->waitShares(4));
+
+    MinerSession::Reconfiguration config;
+    config.threads = 1;
+    config.sources.push_back({std::make_unique<FakeSource>("kept", replacement), 2.0});
+    config.sources.push_back({std::make_unique<FakeSource>("added", added), 1.0});
+    session.reconfigure(std::move(config));
+
+    // A fonte mantida não reconecta; a nova com o mesmo nome é descartada.
+    CHECK_EQ(kept->startCount(), 1);
+    CHECK_EQ(kept->stopCount(), 0);
+    CHECK_EQ(replacement->startCount(), 0);
+    CHECK_EQ(removed->stopCount(), 1);
+    CHECK_EQ(added->startCount(), 1);
+    const std::size_t before = kept->shareCount();
+    CHECK(kept->waitShares(before + 4));
+    CHECK(added->waitShares(4));
+
+    session.stop();
+    runner.join();
+    CHECK_EQ(kept->stopCount(), 1);
+    CHECK_EQ(added->stopCount(), 1);
+}
+
+} // namespace
+
+int main() {
+    alarm(120);
+    const std::string path = "/tmp/nerdminer-session-" + std::to_string(::getpid()) + ".json";
+    testStateAndEpochs(path);
+    std::remove(path.c_str());
+    testReconfigureKeepsSources();
+    return test::report("miner_session");
+}
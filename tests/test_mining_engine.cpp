@@ -0,0 +1,251 @@
+/**
+* Project: nerdminer-rpi
+* File: test_mining_engine.cpp
+* Description: tests the mining engine: search lanes, ntime rolling and the shares it submits
+*
+* Author: Regis Araujo Melo
+* Date: 2025-04-21
+* Version: 0.1.0
+*
+* MIT License
+* © 2025 Regis Araujo Melo
+*/
+
+#include "check.h"
+#include <nerdminer/mining_engine.h>
+#include <nerdminer/nerdminer_block.h>
+#include <nerdminer/offline_work_source.h>
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace nerdminer;
+
+namespace {
+
+constexpr uint32_t kJobNtime = 0x5f5e1000;
+
+// nBits com alvo fácil: cerca de metade dos hashes atende.
+MiningJob makeJob(const std::string& jobId = "job1") {
+    json note = {
+        {"id", nullptr},
+        {"method", "mining.notify"},
+        {"params", json::array({jobId, std::string(64, '0'), "01000000010000", "ffffffff00000000",
+            json::array(), "20000000", "207fffff", "5f5e1000", true})}
+    };
+    return MiningJob::fromNotification(note);
+}
+
+// Todos os ntimes que uma lane visita: do deslocamento inicial até a janela acabar.
+std::vector<uint32_t> laneNtimes(std::size_t extranonce2Size, uint32_t epoch, uint32_t ntimeRoll) {
+    std::vector<uint32_t> out;
+    uint32_t ntime = kJobNtime + MiningEngine::laneNtimeOffset(extranonce2Size, epoch, ntimeRoll);
+    const uint64_t now = kJobNtime;
+    do {
+        out.push_back(ntime);
+    } while (MiningEngine::rollNtime(kJobNtime, ntimeRoll, now, ntime));
+    return out;
+}
+
+/**
+ * A rolagem nunca sai da janela: ntimeRoll segundos após o ntime do job e
+ * 2 horas à frente do relógio.
+ */
+void testRollStaysInWindow() {
+    for (uint32_t roll : {0u, 1u, 5u, 300u, 7200u}) {
+        for (uint32_t epoch = 0; epoch < 20; ++epoch) {
+            const auto ntimes = laneNtimes(4, epoch << 16, roll);
+            CHECK(!ntimes.empty());
+            for (std::size_t i = 0; i < ntimes.size(); ++i) {
+                CHECK(ntimes[i] >= kJobNtime);
+                CHECK(ntimes[i] <= kJobNtime + roll);
+                if (i > 0) {
+                    CHECK_EQ(ntimes[i] - ntimes[i - 1], MiningEngine::ntimeStep(roll));
+                }
+            }
+        }
+    }
+    // Sem janela não há rolagem.
+    uint32_t ntime = kJobNtime;
+    CHECK(!MiningEngine::rollNtime(kJobNtime, 0, kJobNtime, ntime));
+    CHECK_EQ(ntime, kJobNtime);
+
+    // Com o relógio atrasado, o limite de 2 horas vale antes da janela.
+    const uint32_t step = MiningEngine::ntimeStep(7200 * 2);
+    ntime = kJobNtime + 7200 - step;
+    CHECK(MiningEngine::rollNtime(kJobNtime, 7200 * 2, kJobNtime, ntime));
+    CHECK_EQ(ntime, kJobNtime + 7200);
+    ntime = kJobNtime + 7200 - step + 1;
+    CHECK(!MiningEngine::rollNtime(kJobNtime, 7200 * 2, kJobNtime, ntime));
+}
+
+/**
+ * Extranonce2 estreito: as épocas de restart que não cabem nele vão para o
+ * ntime, e nenhuma combinação (extranonce2, ntime) se repete entre threads e
+ * épocas, mesmo com a rolagem de cada lane até o fim da janela.
+ */
+void testLanesUnique() {
+    for (std::size_t size : {0u, 1u, 2u, 4u}) {
+        for (uint32_t roll : {3u, 300u}) {
+            const uint32_t epochs = std::min(MiningEngine::kNtimeEpochs, MiningEngine::ntimeStep(roll));
+            std::set<std::pair<std::string, uint32_t>> seen;
+            for (uint32_t epoch = 0; epoch < epochs; ++epoch) {
+                // Sem extranonce as threads dividem os nonces; só a época muda a lane.
+                const int threads = size == 0 ? 1 : 8;
+                for (int thread = 0; thread < threads; ++thread) {
+                    const std::string en2 = MiningEngine::laneExtranonce2(size, epoch, thread);
+                    CHECK_EQ(en2.size(), 2 * size);
+                    for (uint32_t ntime : laneNtimes(size, epoch, roll)) {
+                        CHECK(seen.insert({en2, ntime}).second);
+                    }
+                }
+            }
+        }
+    }
+    // Com 4 bytes a época cabe no extranonce2 e o ntime parte do job.
+    CHECK_EQ(MiningEngine::laneNtimeOffset(4, 5, 300), 0u);
+    CHECK_EQ(MiningEngine::laneExtranonce2(4, 5, 3), std::string("00050003"));
+    CHECK_EQ(MiningEngine::laneExtranonce2(1, 5, 3), std::string("03"));
+    CHECK_EQ(MiningEngine::laneNtimeOffset(1, 5, 300), 5u);
+    CHECK_EQ(MiningEngine::laneNtimeOffset(2, 17, 300), 1u);
+}
+
+// Coleta os shares aprovados pelo verificador do engine.
+struct ShareSink {
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::vector<ShareCandidate> shares;
+
+    void add(const ShareCandidate& share) {
+        std::lock_guard<std::mutex> lock(mutex);
+        shares.push_back(share);
+        cv.notify_all();
+    }
+
+    bool waitFor(std::size_t count) {
+        std::unique_lock<std::mutex> lock(mutex);
+        return cv.wait_for(lock, std::chrono::seconds(20), [&] { return shares.size() >= count; });
+    }
+};
+
+/**
+ * Ponta a ponta com extranonce2 de 1 byte: o ntime deslocado pela época
+ * chega ao share e passa pelo verificador, e cada restart usa outro ntime.
+ */
+void testEpochNtimeReachesShares() {
+    ShareSink sink;
+    MiningEngine engine([&](const ShareCandidate& share) { sink.add(share); });
+    engine.setThreads(2);
+    engine.setBatchSize(64);
+    engine.setRestartEpoch(1);
+    const MiningJob job = makeJob();
+
+    for (uint32_t epoch = 1; epoch <= 2; ++epoch) {
+        CHECK_EQ(engine.restartEpoch(), epoch);
+        {
+            std::lock_guard<std::mutex> lock(sink.mutex);
+            sink.shares.clear();
+        }
+        engine.setWork(job, "aabbccdd", 1);
+        engine.start();
+        CHECK(sink.waitFor(4));
+        engine.stop();
+        engine.drainShares();
+        std::lock_guard<std::mutex> lock(sink.mutex);
+        for (const auto& share : sink.shares) {
+            CHECK_EQ(share.ntime, kJobNtime + epoch);
+            CHECK(share.extranonce2 == "00" || share.extranonce2 == "01");
+        }
+    }
+}
+
+/**
+ * Job offline com alvo de 1/256: os shares de uma thread nos primeiros
+ * kNonces nonces são exatamente os que o hash de referência aponta.
+ */
+void testOfflineJobKnownShares() {
+    constexpr uint32_t kNonces = 8192;
+    MiningJob job = syntheticJob(1);
+    job.shareTarget.assign(32, 0xff);
+    job.shareTarget[0] = 0;
+
+    // Solução conhecida: nonces da lane da thread 0 (extranonce2 zerado).
+    std::map<uint32_t, std::vector<uint8_t>> expected;
+    for (uint32_t nonce = 0; nonce < kNonces; ++nonce) {
+        auto hash = doubleSHA256(buildBlockHeader(job.buildHeader("aabbccdd", "00000000", nonce)));
+        if (isHashBelowTarget(hash, job.target())) {
+            expected[nonce] = hash;
+        }
+    }
+    CHECK(!expected.empty());
+
+    ShareSink sink;
+    MiningEngine engine([&](const ShareCandidate& share) { sink.add(share); });
+    engine.setThreads(1);
+    engine.setBatchSize(256);
+    engine.setWork(job, "aabbccdd", 4);
+    engine.start();
+    {
+        // O verificador entrega na ordem: um share além de kNonces fecha a faixa.
+        std::unique_lock<std::mutex> lock(sink.mutex);
+        CHECK(sink.cv.wait_for(lock, std::chrono::seconds(60), [&] {
+            return !sink.shares.empty() && sink.shares.back().nonce >= kNonces;
+        }));
+    }
+    engine.stop();
+    engine.drainShares();
+
+    std::lock_guard<std::mutex> lock(sink.mutex);
+    std::map<uint32_t, std::vector<uint8_t>> found;
+    for (const auto& share : sink.shares) {
+        CHECK_EQ(share.job.jobId, job.jobId);
+        CHECK_EQ(share.extranonce1, std::string("aabbccdd"));
+        CHECK_EQ(share.extranonce2, std::string("00000000"));
+        CHECK_EQ(share.ntime, job.ntime);
+        if (share.nonce < kNonces) {
+            CHECK(found.emplace(share.nonce, share.hash).second);
+        }
+    }
+    CHECK(found == expected);
+}
+
+/**
+ * Dois slots com pesos 1 e 3: as threads dividem os hashes nessa proporção.
+ */
+void testWeightedSplit() {
+    MiningEngine engine([](const ShareCandidate&) {});
+    engine.setSlots({{"light", 1.0}, {"heavy", 3.0}});
+    engine.setThreads(2);
+    engine.setBatchSize(1024);
+    MiningJob light = syntheticJob(1);
+    MiningJob heavy = syntheticJob(2);
+    engine.setWork(0, light, "aabbccdd", 4);
+    engine.setWork(1, heavy, "11223344", 4);
+    engine.start();
+    std::this_thread::sleep_for(std::chrono::milliseconds(1500));
+    engine.stop();
+
+    const double lightHashes = static_cast<double>(engine.slotHashes(0));
+    const double heavyHashes = static_cast<double>(engine.slotHashes(1));
+    CHECK(lightHashes > 0);
+    const double share = heavyHashes / (lightHashes + heavyHashes);
+    CHECK(share > 0.70 && share < 0.80);
+}
+
+} // namespace
+
+int main() {
+    testRollStaysInWindow();
+    testLanesUnique();
+    testEpochNtimeReachesShares();
+    testOfflineJobKnownShares();
+    testWeightedSplit();
+    return test::report("mining_engine");
+}
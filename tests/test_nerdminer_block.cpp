@@ -0,0 +1,127 @@
+/**
+* Project: nerdminer-rpi
+* File: test_nerdminer_block.cpp
+* Description: tests header serialization and targets against known mainnet values
+*
+* Author: Regis Araujo Melo
+* Date: 2025-04-21
+* Version: 0.1.0
+*
+* MIT License
+* © 2025 Regis Araujo Melo
+*/
+
+#include "check.h"
+#include <nerdminer/hash_kernel.h>
+#include <nerdminer/hex.h>
+#include <nerdminer/miner_job.h>
+#include <nerdminer/nerdminer_block.h>
+#include <algorithm>
+#include <stdexcept>
+
+using namespace nerdminer;
+
+namespace {
+
+std::string hexOf(const std::vector<uint8_t>& bytes) {
+    return encodeHex(bytes.data(), bytes.size());
+}
+
+std::string reversedHex(std::vector<uint8_t> bytes) {
+    std::reverse(bytes.begin(), bytes.end());
+    return hexOf(bytes);
+}
+
+// Bloco gênese: hashes na ordem interna (a exibida invertida).
+BlockHeader genesisHeader() {
+    BlockHeader header;
+    header.version = 1;
+    header.prevHash = std::string(64, '0');
+    header.merkleRoot = "3ba3edfd7a7b12b27ac72c3e67768f617fc81bc3888a51323a9fb8aa4b1e5e4a";
+    header.timestamp = 1231006505;
+    header.bits = 0x1d00ffff;
+    header.nonce = 2083236893;
+    return header;
+}
+
+const char* kGenesisHash = "000000000019d6689c085ae165831e934ff763ae46a2a6c172b3f1b60a8ce26f";
+
+} // namespace
+
+int main() {
+    // Campos de 32 bits em little-endian e hash do bloco gênese.
+    const BlockHeader genesis = genesisHeader();
+    const std::vector<uint8_t> bytes = buildBlockHeader(genesis);
+    CHECK_EQ(bytes.size(), 80u);
+    CHECK_EQ(hexOf(std::vector<uint8_t>(bytes.begin(), bytes.begin() + 4)), "01000000");
+    CHECK_EQ(hexOf(std::vector<uint8_t>(bytes.begin() + 68, bytes.end())), "29ab5f49ffff001d1dac2b7c");
+    const std::vector<uint8_t> hash = doubleSHA256(bytes);
+    CHECK_EQ(reversedHex(hash), kGenesisHash);
+    CHECK(isHashBelowTarget(hash, targetFromBits(genesis.bits)));
+
+    // Todos os kernels encontram o nonce do gênese contra o alvo real.
+    const HeaderTemplate tmpl = HeaderTemplate::fromHeader(genesis);
+    const Target target = makeTarget(genesis.bits);
+    for (const std::string& name : kernelNames()) {
+        auto kernel = makeKernel(name);
+        std::vector<HashHit> hits;
+        kernel->hashHeaders(tmpl, genesis.nonce - 40, 64, target, hits);
+        CHECK(hits.size() == 1 && hits[0].nonce == genesis.nonce);
+        if (hits.size() == 1) {
+            CHECK_EQ(reversedHex(std::vector<uint8_t>(hits[0].hash.begin(), hits[0].hash.end())), kGenesisHash);
+        }
+    }
+
+    // Formato compacto: alvo big-endian de 32 bytes.
+    const std::string zeros(64, '0');
+    CHECK_EQ(hexOf(targetFromBits(0x1d00ffff)), "00000000ffff" + zeros.substr(12));
+    CHECK_EQ(hexOf(targetFromBits(0x1b0404cb)), "00000000000404cb" + zeros.substr(16));
+    CHECK_EQ(hexOf(targetFromBits(0x207fffff)), "7fffff" + zeros.substr(6));
+    CHECK_EQ(hexOf(targetFromBits(0x03123456)), zeros.substr(6) + "123456");
+    CHECK_EQ(hexOf(targetFromBits(0x02123456)), zeros.substr(4) + "1234");
+    CHECK_EQ(hexOf(targetFromBits(0x01123456)), zeros.substr(2) + "12");
+    // Mantissa negativa ou expoente grande demais: alvo impossível.
+    CHECK_EQ(hexOf(targetFromBits(0x1d800000)), zeros);
+    CHECK_EQ(hexOf(targetFromBits(0x21010000)), zeros);
+
+    // Dificuldade do pool: diff 1 é o alvo de 0x1d00ffff.
+    CHECK(targetFromDifficulty(1.0) == targetFromBits(0x1d00ffff));
+    CHECK_EQ(hexOf(targetFromDifficulty(2.0)), "000000007fff8" + zeros.substr(13));
+    CHECK_EQ(hexOf(targetFromDifficulty(0.5)), "00000001fffe" + zeros.substr(12));
+    CHECK_EQ(hexOf(targetFromDifficulty(0)), std::string(64, 'f'));
+
+    // O hash é comparado como número little-endian (byte 31 é o mais significativo).
+    std::vector<uint8_t> low(32, 0xFF);
+    low[31] = 0x00;
+    low[30] = 0x00;
+    low[29] = 0x00;
+    low[28] = 0x00;
+    low[27] = 0xFE;
+    CHECK(isHashBelowTarget(low, targetFromBits(0x1d00ffff)));
+    low[27] = 0xFF;
+    CHECK(!isHashBelowTarget(low, targetFromBits(0x1d00ffff)));
+    std::vector<uint8_t> equal(targetFromBits(0x1d00ffff));
+    std::reverse(equal.begin(), equal.end());
+    CHECK(isHashBelowTarget(equal, targetFromBits(0x1d00ffff)));
+
+    CHECK_THROWS(makeTarget(std::vector<uint8_t>(31, 0)), std::invalid_argument);
+
+    // O prevhash do Stratum vem com as palavras de 32 bits invertidas.
+    json note = {
+        {"id", nullptr},
+        {"method", "mining.notify"},
+        {"params", json::array({"job1", "00112233445566778899aabbccddeeff00112233445566778899aabbccddeeff",
+            "01", "02", json::array(), "20000000", "1d00ffff", "5f5e1000", true})}
+    };
+    MiningJob job = MiningJob::fromNotification(note);
+    CHECK(job.valid);
+    CHECK_EQ(job.buildHeader("", "", 0).prevHash,
+        "3322110077665544bbaa9988ffeeddcc3322110077665544bbaa9988ffeeddcc");
+
+    // Sem mining.set_difficulty o alvo é o do bloco; com ele, o do pool.
+    CHECK(job.target() == targetFromBits(0x1d00ffff));
+    job.difficulty = 2.0;
+    CHECK(job.target() == targetFromDifficulty(2.0));
+
+    return nerdminer::test::report("nerdminer_block");
+}
@@ -0,0 +1,140 @@
+/**
+* Project: nerdminer-rpi
+* File: test_perf_counters.cpp
+* Description: tests hardware counter scaling and the per-hash perf line
+*
+* Author: Regis Araujo Melo
+* Date: 2025-04-21
+* Version: 0.1.0
+*
+* MIT License
+* © 2025 Regis Araujo Melo
+*/
+
+#include "check.h"
+#include <nerdminer/perf_counters.h>
+#include <iomanip>
+#include <sstream>
+#include <string>
+
+using namespace nerdminer;
+
+namespace {
+
+/**
+ * Com a PMU multiplexada o grupo rodou metade do tempo: os valores dobram.
+ * Eventos que não abriram ficam inválidos, e sem tempo rodando não há amostra.
+ */
+void testDeltaScaling() {
+    PerfReading start;
+    start.values[PerfCycles] = 1000;
+    start.values[PerfInstructions] = 2000;
+    start.present[PerfCycles] = start.present[PerfInstructions] = true;
+    start.enabled = 100;
+    start.running = 100;
+    PerfReading now = start;
+    now.values[PerfCycles] = 3000;
+    now.values[PerfInstructions] = 6000;
+    now.enabled = 300;
+    now.running = 200;
+
+    PerfSample sample = perfDelta(start, now);
+    CHECK(sample.valid[PerfCycles]);
+    CHECK(sample.valid[PerfInstructions]);
+    CHECK(!sample.valid[PerfCacheMisses]);
+    CHECK(!sample.valid[PerfBranchMisses]);
+    CHECK_EQ(sample.values[PerfCycles], 4000u);
+    CHECK_EQ(sample.values[PerfInstructions], 8000u);
+
+    // Sem multiplexação o valor é a diferença crua.
+    now.enabled = now.running = 200;
+    CHECK_EQ(perfDelta(start, now).values[PerfCycles], 2000u);
+
+    now.running = start.running;
+    PerfSample idle = perfDelta(start, now);
+    for (int i = 0; i < PerfEventCount; ++i) {
+        CHECK(!idle.valid[i]);
+        CHECK_EQ(idle.values[i], 0u);
+    }
+
+    // A soma mantém válido o que já era válido em qualquer lado.
+    PerfSample total;
+    total += sample;
+    total += idle;
+    total += sample;
+    CHECK(total.valid[PerfCycles]);
+    CHECK(!total.valid[PerfCacheMisses]);
+    CHECK_EQ(total.values[PerfCycles], 8000u);
+}
+
+void testPerfLine() {
+    PerfSample sample;
+    sample.values[PerfCycles] = 1000;
+    sample.values[PerfInstructions] = 2500;
+    sample.values[PerfCacheMisses] = 5;
+    sample.values[PerfBranchMisses] = 3;
+    for (int i = 0; i < PerfEventCount; ++i) {
+        sample.valid[i] = true;
+    }
+
+    // Os formatos do stream do chamador não mudam.
+    std::ostringstream os;
+    os << std::setprecision(4);
+    const auto flags = os.flags();
+    printPerfLine(os, "k", sample, 10);
+    CHECK_EQ(os.str(), std::string("Perf [k]: cycles/hash=100.0 IPC=2.50 cache-miss/khash=500.0 branch-miss/khash=300.0\n"));
+    CHECK(os.flags() == flags);
+    CHECK_EQ(os.precision(), 4);
+
+    // Só o que a CPU mediu aparece.
+    PerfSample partial;
+    partial.values[PerfCycles] = 150;
+    partial.valid[PerfCycles] = true;
+    std::ostringstream cyclesOnly;
+    printPerfLine(cyclesOnly, "k", partial, 4);
+    CHECK_EQ(cyclesOnly.str(), std::string("Perf [k]: cycles/hash=37.5\n"));
+
+    std::ostringstream noHashes;
+    printPerfLine(noHashes, "k", sample, 0);
+    CHECK_EQ(noHashes.str(), std::string("Perf [k]: counters unavailable\n"));
+
+    std::ostringstream noCounters;
+    printPerfLine(noCounters, "k", PerfSample(), 10);
+    CHECK_EQ(noCounters.str(), std::string("Perf [k]: counters unavailable\n"));
+}
+
+/**
+ * Contadores reais quando o kernel permitir; senão begin()/end() não
+ * acumulam nada.
+ */
+void testLiveCounters() {
+    PerfCounters counters;
+    volatile uint64_t sink = 0;
+    counters.begin();
+    for (uint64_t i = 0; i < 1000000; ++i) {
+        sink = sink + i;
+    }
+    counters.end();
+    PerfSample sample = counters.take();
+    if (counters.available()) {
+        CHECK(!sample.valid[PerfCycles] || sample.values[PerfCycles] > 0);
+    } else {
+        for (int i = 0; i < PerfEventCount; ++i) {
+            CHECK(!sample.valid[i]);
+        }
+    }
+    // take() zera o acumulado.
+    PerfSample empty = counters.take();
+    for (int i = 0; i < PerfEventCount; ++i) {
+        CHECK_EQ(empty.values[i], 0u);
+    }
+}
+
+} // namespace
+
+int main() {
+    testDeltaScaling();
+    testPerfLine();
+    testLiveCounters();
+    return test::report("perf_counters");
+}
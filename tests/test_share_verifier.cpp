@@ -0,0 +1,136 @@
+/**
+* Project: nerdminer-rpi
+* File: test_share_verifier.cpp
+* Description: tests that the share verifier only submits shares the reference path accepts
+*
+* Author: Regis Araujo Melo
+* Date: 2025-04-21
+* Version: 0.1.0
+*
+* MIT License
+* © 2025 Regis Araujo Melo
+*/
+
+#include "check.h"
+#include <nerdminer/miner_job.h>
+#include <nerdminer/nerdminer_block.h>
+#include <nerdminer/share_verifier.h>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+using namespace nerdminer;
+
+namespace {
+
+// nBits com alvo fácil: cerca de metade dos hashes atende.
+MiningJob makeJob() {
+    json note = {
+        {"id", nullptr},
+        {"method", "mining.notify"},
+        {"params", json::array({"job1", std::string(64, '0'), "01000000010000", "ffffffff00000000",
+            json::array(), "20000000", "207fffff", "5f5e1000", true})}
+    };
+    return MiningJob::fromNotification(note);
+}
+
+// Primeiro nonce a partir de start cujo hash de referência atende (ou não) o
+// alvo, com o header no ntime do job avançado de ntimeOffset segundos.
+ShareCandidate findCandidate(const MiningJob& job, bool meetsTarget, uint32_t start = 0, uint32_t ntimeOffset = 0) {
+    ShareCandidate candidate;
+    candidate.kernel = "test";
+    candidate.job = job;
+    candidate.extranonce1 = "aabbccdd";
+    candidate.extranonce2 = "00000001";
+    candidate.ntime = job.ntime + ntimeOffset;
+    for (uint32_t nonce = start;; ++nonce) {
+        BlockHeader header = job.buildHeader(candidate.extranonce1, candidate.extranonce2, nonce);
+        header.timestamp = candidate.ntime;
+        auto hash = doubleSHA256(buildBlockHeader(header));
+        if (isHashBelowTarget(hash, targetFromBits(job.bits)) == meetsTarget) {
+            candidate.nonce = nonce;
+            candidate.hash = hash;
+            return candidate;
+        }
+    }
+}
+
+bool waitVerified(const ShareVerifier& verifier, const std::string& kernel, uint64_t count) {
+    for (int i = 0; i < 500; ++i) {
+        auto stats = verifier.stats();
+        auto it = stats.find(kernel);
+        if (it != stats.end() && it->second.verified >= count) {
+            return true;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return false;
+}
+
+} // namespace
+
+int main() {
+    const MiningJob job = makeJob();
+
+    std::mutex mutex;
+    std::vector<uint32_t> submitted;
+    ShareVerifier verifier([&](const ShareCandidate& share) {
+        std::lock_guard<std::mutex> lock(mutex);
+        submitted.push_back(share.nonce);
+    }, 2);
+
+    // Share correto: vai para o pool.
+    ShareCandidate good = findCandidate(job, true);
+    good.kernel = "good";
+    verifier.enqueue(good);
+    CHECK(waitVerified(verifier, "good", 1));
+
+    // ntime rolado: o verificador refaz o header com o ntime do share.
+    ShareCandidate rolled = findCandidate(job, true, 0, 17);
+    rolled.kernel = "rolled";
+    verifier.enqueue(rolled);
+    CHECK(waitVerified(verifier, "rolled", 1));
+    // O mesmo hash informado com o ntime do job não confere.
+    ShareCandidate unrolled = rolled;
+    unrolled.kernel = "unrolled";
+    unrolled.ntime = job.ntime;
+    verifier.enqueue(unrolled);
+    CHECK(waitVerified(verifier, "unrolled", 1));
+
+    // Hash informado diferente do recalculado: não é enviado.
+    ShareCandidate wrongHash = findCandidate(job, true, good.nonce + 1);
+    wrongHash.kernel = "bad";
+    wrongHash.hash[0] ^= 0x01;
+    verifier.enqueue(wrongHash);
+    CHECK(waitVerified(verifier, "bad", 1));
+    CHECK(!verifier.disabledFlag("bad"));
+
+    // Hash correto mas acima do alvo: também não é enviado e desativa o
+    // kernel ao chegar em maxMismatches.
+    ShareCandidate aboveTarget = findCandidate(job, false);
+    aboveTarget.kernel = "bad";
+    verifier.enqueue(aboveTarget);
+    CHECK(waitVerified(verifier, "bad", 2));
+    CHECK(verifier.disabledFlag("bad"));
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        CHECK_EQ(submitted.size(), 2u);
+        CHECK(submitted.size() == 2 && submitted[0] == good.nonce && submitted[1] == rolled.nonce);
+    }
+    auto stats = verifier.stats();
+    CHECK_EQ(stats["good"].mismatches, 0u);
+    CHECK(!stats["good"].disabled);
+    CHECK_EQ(stats["bad"].mismatches, 2u);
+    CHECK_EQ(stats["rolled"].mismatches, 0u);
+    CHECK_EQ(stats["unrolled"].mismatches, 1u);
+
+    // Fila cheia: o candidato é descartado sem bloquear quem minera.
+    ShareVerifier full([](const ShareCandidate&) {}, 1, 0);
+    full.enqueue(good);
+    CHECK_EQ(full.stats()["good"].dropped, 1u);
+    CHECK_EQ(full.stats()["good"].verified, 0u);
+
+    return nerdminer::test::report("share_verifier");
+}
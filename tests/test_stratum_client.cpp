@@ -0,0 +1,321 @@
+/**
+* Project: nerdminer-rpi
+* File: test_stratum_client.cpp
+* Description: tests the Stratum V1 client and work source against a scripted fake pool
+*
+* Author: Regis Araujo Melo
+* Date: 2025-04-21
+* Version: 0.1.0
+*
+* MIT License
+* © 2025 Regis Araujo Melo
+*/
+
+#include "check.h"
+#include <nerdminer/stratum_client.h>
+#include <nerdminer/stratum_work_source.h>
+#include <boost/asio.hpp>
+#include <nlohmann/json.hpp>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unistd.h>
+
+using namespace nerdminer;
+using tcp = boost::asio::ip::tcp;
+using json = nlohmann::json;
+
+namespace {
+
+// Uma conexão do pool falso, com leitura e escrita síncronas de linhas json.
+class PoolConnection {
+public:
+    explicit PoolConnection(tcp::socket socket) : socket_(std::move(socket)) {}
+
+    // Próxima linha; json descartado quando a conexão fecha.
+    json read() {
+        boost::system::error_code ec;
+        boost::asio::read_until(socket_, buffer_, '\n', ec);
+        if (ec) {
+            return json::parse("", nullptr, false);
+        }
+        std::istream is(&buffer_);
+        std::string line;
+        std::getline(is, line);
+        return json::parse(line);
+    }
+
+    // Lê até chegar uma requisição com o método pedido.
+    json readMethod(const std::string& method) {
+        for (;;) {
+            json req = read();
+            if (req.is_discarded() || req.value("method", "") == method) {
+                return req;
+            }
+        }
+    }
+
+    void write(const json& msg) {
+        boost::asio::write(socket_, boost::asio::buffer(msg.dump() + "\n"));
+    }
+
+    void writeRaw(const std::string& line) {
+        boost::asio::write(socket_, boost::asio::buffer(line + "\n"));
+    }
+
+private:
+    tcp::socket socket_;
+    boost::asio::streambuf buffer_;
+};
+
+class FakePool {
+public:
+    FakePool() : acceptor_(io_, tcp::endpoint(boost::asio::ip::address_v4::loopback(), 0)) {}
+
+    uint16_t port() const { return acceptor_.local_endpoint().port(); }
+
+    std::unique_ptr<PoolConnection> accept() {
+        tcp::socket socket(io_);
+        acceptor_.accept(socket);
+        return std::make_unique<PoolConnection>(std::move(socket));
+    }
+
+private:
+    boost::asio::io_context io_;
+    tcp::acceptor acceptor_;
+};
+
+json notify(const std::string& jobId) {
+    return {{"id", nullptr}, {"method", "mining.notify"},
+        {"params", json::array({jobId, std::string(64, '0'), "01", "02", json::array(),
+            "20000000", "1d00ffff", "5f5e1000", true})}};
+}
+
+// Espera (com limite) por uma condição atualizada em outra thread.
+template <typename Pred>
+bool waitFor(std::mutex& mutex, std::condition_variable& cv, Pred pred) {
+    std::unique_lock<std::mutex> lock(mutex);
+    return cv.wait_for(lock, std::chrono::seconds(10), pred);
+}
+
+/**
+ * Respostas de mining.subscribe malformadas são recusadas: o extranonce1
+ * iria para a coinbase dentro das threads de mineração.
+ */
+void testSubscribeValidation() {
+    const json cases[] = {
+        json::array({json::array(), "abc", 4}),        // tamanho ímpar
+        json::array({json::array(), "zzzz", 4}),       // não é hex
+        json::array({json::array(), "aabbccdd", 0}),   // sem extranonce2
+        json::array({json::array(), "aabbccdd", 64}),  // extranonce2 grande demais
+        json::array({json::array(), std::string(66, 'a'), 4}),
+        json::array({json::array(), "aabbccdd", -1}),
+    };
+    for (const json& result : cases) {
+        FakePool pool;
+        StratumClient client("127.0.0.1", pool.port(), "user", "x");
+        std::mutex mutex;
+        std::condition_variable cv;
+        bool pinged = false;
+        // A notificação depois da resposta marca que ela já foi tratada.
+        client.onNotification = [&](const json&) {
+            std::lock_guard<std::mutex> lock(mutex);
+            pinged = true;
+            cv.notify_all();
+        };
+        std::thread server([&pool, &result] {
+            auto conn = pool.accept();
+            json req = conn->readMethod("mining.subscribe");
+            conn->write({{"id", req["id"]}, {"result", result}, {"error", nullptr}});
+            conn->write({{"id", nullptr}, {"method", "client.ping"}, {"params", json::array()}});
+        });
+        client.connect();
+        client.subscribe();
+        std::thread io([&client] { client.listen(); });
+        CHECK(waitFor(mutex, cv, [&] { return pinged; }));
+        CHECK(!client.subscribed());
+        CHECK(client.extranonce1().empty());
+        client.ioContext().stop();
+        io.join();
+        server.join();
+    }
+}
+
+/**
+ * Um "method" que não é string é descartado sem derrubar a thread de IO:
+ * o job seguinte ainda chega.
+ */
+void testNonStringMethod() {
+    // O pool fica vivo até o fim do processo: a thread dele só sai quando a
+    // fonte for destruída e fechar a conexão.
+    FakePool& pool = *new FakePool;
+    StratumWorkSource source("127.0.0.1", pool.port(), "user", "x");
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::vector<std::string> jobs;
+    source.onJob = [&](const MiningJob& job, const std::string& extranonce1, std::size_t extranonce2Size, uint64_t) {
+        CHECK_EQ(extranonce1, std::string("aabbccdd"));
+        CHECK_EQ(extranonce2Size, 4u);
+        std::lock_guard<std::mutex> lock(mutex);
+        jobs.push_back(job.jobId);
+        cv.notify_all();
+    };
+    std::thread([&pool] {
+        auto conn = pool.accept();
+        json req = conn->readMethod("mining.subscribe");
+        conn->write({{"id", req["id"]}, {"result", json::array({json::array(), "aabbccdd", 4})}, {"error", nullptr}});
+        conn->write({{"id", nullptr}, {"method", 5}, {"params", json::array()}});
+        conn->write({{"id", nullptr}, {"method", "mining.set_difficulty"}});
+        conn->writeRaw("{\"id\":null,\"method\":\"mining.notify\"}");
+        conn->write(notify("job-ok"));
+        while (!conn->read().is_discarded()) {
+        }
+    }).detach();
+    source.start();
+    CHECK(waitFor(mutex, cv, [&] { return !jobs.empty(); }));
+    source.stop();
+    std::lock_guard<std::mutex> lock(mutex);
+    CHECK_EQ(jobs.size(), 1u);
+    if (!jobs.empty()) {
+        CHECK_EQ(jobs[0], std::string("job-ok"));
+    }
+}
+
+/**
+ * Um share com ntime rolado sai no mining.submit com o ntime dele, não com
+ * o do job.
+ */
+void testRolledNtimeSubmit() {
+    FakePool& pool = *new FakePool;
+    StratumWorkSource source("127.0.0.1", pool.port(), "user", "x");
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::vector<MiningJob> jobs;
+    json submit;
+    source.onJob = [&](const MiningJob& job, const std::string&, std::size_t, uint64_t) {
+        std::lock_guard<std::mutex> lock(mutex);
+        jobs.push_back(job);
+        cv.notify_all();
+    };
+    std::thread([&pool, &mutex, &cv, &submit] {
+        auto conn = pool.accept();
+        json req = conn->readMethod("mining.subscribe");
+        conn->write({{"id", req["id"]}, {"result", json::array({json::array(), "aabbccdd", 4})}, {"error", nullptr}});
+        conn->write(notify("job-roll"));
+        json sent = conn->readMethod("mining.submit");
+        if (!sent.is_discarded()) {
+            conn->write({{"id", sent["id"]}, {"result", true}, {"error", nullptr}});
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            submit = sent;
+            cv.notify_all();
+        }
+        while (!conn->read().is_discarded()) {
+        }
+    }).detach();
+    source.start();
+    CHECK(waitFor(mutex, cv, [&] { return !jobs.empty(); }));
+
+    ShareCandidate share;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        share.job = jobs[0];
+    }
+    share.extranonce1 = "aabbccdd";
+    share.extranonce2 = "00010002";
+    share.ntime = share.job.ntime + 42;
+    share.nonce = 0x1234;
+    source.submitShare(share);
+    CHECK(waitFor(mutex, cv, [&] { return !submit.is_null(); }));
+    source.drain(std::chrono::seconds(5));
+    source.stop();
+
+    std::lock_guard<std::mutex> lock(mutex);
+    CHECK(submit.contains("params") && submit["params"].size() == 5);
+    if (submit.contains("params") && submit["params"].size() == 5) {
+        CHECK_EQ(submit["params"][1].get<std::string>(), std::string("job-roll"));
+        CHECK_EQ(submit["params"][2].get<std::string>(), std::string("00010002"));
+        CHECK_EQ(submit["params"][3].get<std::string>(), std::string("5f5e102a"));
+        CHECK_EQ(submit["params"][4].get<std::string>(), std::string("00001234"));
+    }
+}
+
+/**
+ * O sessionState() guarda o id de sessão do pool, e uma fonte retomada com
+ * ele manda mining.subscribe com [user_agent, session_id].
+ */
+void testResumeSubscribe() {
+    FakePool& pool = *new FakePool;
+    std::mutex mutex;
+    std::condition_variable cv;
+    json firstParams;
+    json resumedParams;
+    std::thread([&pool, &mutex, &cv, &firstParams, &resumedParams] {
+        auto first = pool.accept();
+        json req = first->readMethod("mining.subscribe");
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            firstParams = req["params"];
+        }
+        first->write({{"id", req["id"]}, {"error", nullptr},
+            {"result", json::array({json::array({json::array({"mining.set_difficulty", "d-1"}),
+                json::array({"mining.notify", "sess-1"})}), "aabbccdd", 4})}});
+        first->write(notify("job-1"));
+        // A primeira conexão fica aberta até a fonte ser destruída.
+        auto resumed = pool.accept();
+        req = resumed->readMethod("mining.subscribe");
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            resumedParams = req["params"];
+            cv.notify_all();
+        }
+        resumed->write({{"id", req["id"]}, {"error", nullptr},
+            {"result", json::array({json::array({"mining.notify", "sess-1"}), "aabbccdd", 4})}});
+        while (!resumed->read().is_discarded()) {
+        }
+    }).detach();
+
+    json state;
+    {
+        StratumWorkSource source("127.0.0.1", pool.port(), "user", "x");
+        bool gotJob = false;
+        source.onJob = [&](const MiningJob&, const std::string&, std::size_t, uint64_t) {
+            std::lock_guard<std::mutex> lock(mutex);
+            gotJob = true;
+            cv.notify_all();
+        };
+        CHECK(source.sessionState().is_null());
+        source.start();
+        CHECK(waitFor(mutex, cv, [&] { return gotJob; }));
+        source.stop();
+        state = source.sessionState();
+    }
+    CHECK_EQ(state.value("session_id", ""), std::string("sess-1"));
+    CHECK_EQ(state.value("extranonce1", ""), std::string("aabbccdd"));
+    CHECK_EQ(state.value("extranonce2_size", 0), 4);
+
+    StratumWorkSource resumed("127.0.0.1", pool.port(), "user", "x");
+    resumed.resumeSession(state);
+    resumed.start();
+    CHECK(waitFor(mutex, cv, [&] { return !resumedParams.is_null(); }));
+    resumed.stop();
+
+    std::lock_guard<std::mutex> lock(mutex);
+    CHECK(firstParams.is_array() && firstParams.empty());
+    CHECK_EQ(resumedParams, json::array({"nerdminer-rpi/0.1.0", "sess-1"}));
+}
+
+} // namespace
+
+int main() {
+    alarm(30);
+    testSubscribeValidation();
+    testNonStringMethod();
+    testRolledNtimeSubmit();
+    testResumeSubscribe();
+    std::_Exit(test::report("stratum_client"));
+}
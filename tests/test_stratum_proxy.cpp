@@ -0,0 +1,330 @@
+/**
+* Project: nerdminer-rpi
+* File: test_stratum_proxy.cpp
+* Description: tests the proxy extranonce split against a fake upstream pool
+*
+* Author: Regis Araujo Melo
+* Date: 2025-04-21
+* Version: 0.1.0
+*
+* MIT License
+* © 2025 Regis Araujo Melo
+*/
+
+#include "check.h"
+#include <nerdminer/stratum_proxy.h>
+#include <boost/asio.hpp>
+#include <nlohmann/json.hpp>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <sys/socket.h>
+#include <unistd.h>
+
+using namespace nerdminer;
+using tcp = boost::asio::ip::tcp;
+using json = nlohmann::json;
+
+namespace {
+
+// Pool de mentira: uma conexão por vez, extranonce1 fixo por conexão.
+// Guarda os submits recebidos e aceita todos, ou não responde nenhum (silent).
+// drop() derruba a conexão atual; a próxima recebe outro extranonce1.
+class FakeUpstream {
+public:
+    explicit FakeUpstream(int extranonce2Size = 4)
+        : acceptor_(io_, tcp::endpoint(boost::asio::ip::address_v4::loopback(), 0)),
+        extranonce2Size_(extranonce2Size) {}
+
+    uint16_t port() const { return acceptor_.local_endpoint().port(); }
+
+    void start() {
+        std::thread([this] { run(); }).detach();
+    }
+
+    void setSilent(bool silent) { silent_ = silent; }
+
+    void drop(const std::string& nextExtranonce1) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        extranonce1_ = nextExtranonce1;
+        submits_.clear();
+        ::shutdown(nativeSocket_, SHUT_RDWR);
+    }
+
+    int connections() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return connections_;
+    }
+
+    json waitSubmit() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_.wait(lock, [this] { return !submits_.empty(); });
+        json submit = submits_.front();
+        submits_.erase(submits_.begin());
+        return submit;
+    }
+
+private:
+    void run() {
+        for (;;) {
+            tcp::socket socket(io_);
+            acceptor_.accept(socket);
+            std::string extranonce1;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                nativeSocket_ = socket.native_handle();
+                extranonce1 = extranonce1_;
+                ++connections_;
+            }
+            serve(socket, extranonce1);
+        }
+    }
+
+    void serve(tcp::socket& socket, const std::string& extranonce1) {
+        boost::asio::streambuf buffer;
+        boost::system::error_code ec;
+        while (boost::asio::read_until(socket, buffer, '\n', ec)) {
+            std::istream is(&buffer);
+            std::string line;
+            std::getline(is, line);
+            json req = json::parse(line);
+            const std::string method = req["method"];
+            if (method == "mining.submit") {
+                std::lock_guard<std::mutex> lock(mutex_);
+                submits_.push_back(req["params"]);
+                cv_.notify_all();
+                if (silent_) {
+                    continue;
+                }
+            }
+            json reply = {{"id", req["id"]}, {"error", nullptr}};
+            if (method == "mining.subscribe") {
+                reply["result"] = json::array({json::array({json::array({"mining.notify", "1"})}), extranonce1, extranonce2Size_});
+            } else {
+                reply["result"] = true;
+            }
+            write(socket, reply);
+            if (method == "mining.authorize") {
+                // Uma linha que não é JSON não pode derrubar o cliente do proxy.
+                boost::asio::write(socket, boost::asio::buffer(std::string("garbage{\n")));
+                write(socket, {{"id", nullptr}, {"method", "mining.notify"},
+                    {"params", json::array({"job1", std::string(64, '0'), "01", "02", json::array(),
+                        "20000000", "1d00ffff", "5f5e1000", true})}});
+            }
+        }
+    }
+
+    static void write(tcp::socket& socket, const json& msg) {
+        boost::asio::write(socket, boost::asio::buffer(msg.dump() + "\n"));
+    }
+
+    boost::asio::io_context io_;
+    tcp::acceptor acceptor_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::vector<json> submits_;
+    std::atomic<bool> silent_{false};
+    const int extranonce2Size_;
+    std::string extranonce1_ = "aabbccdd";
+    int nativeSocket_ = -1;
+    int connections_ = 0;
+};
+
+// Um rig local conectado ao proxy, com chamadas síncronas.
+class Rig {
+public:
+    explicit Rig(uint16_t port) : socket_(io_) {
+        // O proxy só escuta depois que o upstream responde ao subscribe.
+        for (int attempt = 0; attempt < 100; ++attempt) {
+            boost::system::error_code ec;
+            socket_.connect(tcp::endpoint(boost::asio::ip::address_v4::loopback(), port), ec);
+            if (!ec) {
+                return;
+            }
+            socket_.close();
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        }
+        throw std::runtime_error("proxy did not start listening");
+    }
+
+    void send(int id, const std::string& method, const json& params) {
+        json req = {{"id", id}, {"method", method}, {"params", params}};
+        boost::asio::write(socket_, boost::asio::buffer(req.dump() + "\n"));
+    }
+
+    json call(int id, const std::string& method, const json& params) {
+        send(id, method, params);
+        for (;;) {
+            json msg = readLine();
+            if (!msg.contains("method") && msg["id"] == id) {
+                return msg;
+            }
+        }
+    }
+
+    // Próxima resposta (não notificação) do proxy.
+    json readReply() {
+        for (;;) {
+            json msg = readLine();
+            if (!msg.contains("method")) {
+                return msg;
+            }
+        }
+    }
+
+    // Lê até o proxy fechar a conexão.
+    bool closedByPeer() {
+        boost::system::error_code ec;
+        while (!ec) {
+            boost::asio::read_until(socket_, buffer_, '\n', ec);
+            buffer_.consume(buffer_.size());
+        }
+        return ec == boost::asio::error::eof;
+    }
+
+    json readLine() {
+        boost::asio::read_until(socket_, buffer_, '\n');
+        std::istream is(&buffer_);
+        std::string line;
+        std::getline(is, line);
+        return json::parse(line);
+    }
+
+    void close() { socket_.close(); }
+
+private:
+    boost::asio::io_context io_;
+    tcp::socket socket_;
+    boost::asio::streambuf buffer_;
+};
+
+uint16_t freePort() {
+    boost::asio::io_context io;
+    tcp::acceptor acceptor(io, tcp::endpoint(boost::asio::ip::address_v4::loopback(), 0));
+    return acceptor.local_endpoint().port();
+}
+
+} // namespace
+
+int main() {
+    // Um proxy travado não deve prender o make check para sempre.
+    alarm(30);
+
+    FakeUpstream upstream;
+    upstream.start();
+
+    StratumProxyConfig config;
+    config.listenPort = freePort();
+    config.prefixBytes = 2;
+    config.maxPendingSubmits = 2;
+    config.submitTimeout = std::chrono::seconds(1);
+    config.idleTimeout = std::chrono::seconds(5);
+    auto* proxy = new StratumProxy("127.0.0.1", upstream.port(), "user", "x", config);
+    std::thread([proxy] { proxy->start(); }).detach();
+
+    // Cada rig recebe extranonce1 do upstream + um prefixo de 2 bytes.
+    Rig a(config.listenPort);
+    json subA = a.call(1, "mining.subscribe", json::array());
+    CHECK_EQ(subA["result"][1].get<std::string>(), "aabbccdd0000");
+    CHECK_EQ(subA["result"][2].get<int>(), 2);
+
+    Rig b(config.listenPort);
+    json subB = b.call(1, "mining.subscribe", json::array());
+    CHECK_EQ(subB["result"][1].get<std::string>(), "aabbccdd0001");
+    CHECK(b.call(2, "mining.authorize", json::array({"rig-b", "x"}))["result"] == true);
+
+    // O submit sobe com o prefixo recolocado e a resposta volta com o id do rig.
+    json ack = b.call(42, "mining.submit", json::array({"rig-b", "job1", "beef", "5f5e1000", "0000002a"}));
+    CHECK(ack["result"] == true);
+    json forwarded = upstream.waitSubmit();
+    CHECK_EQ(forwarded[1].get<std::string>(), "job1");
+    CHECK_EQ(forwarded[2].get<std::string>(), "0001beef");
+    CHECK_EQ(forwarded[4].get<std::string>(), "0000002a");
+
+    // extranonce2 com tamanho errado ou hex inválido não chega ao upstream.
+    CHECK(a.call(7, "mining.submit", json::array({"rig-a", "job1", "bee", "5f5e1000", "00000001"}))["result"] == false);
+    CHECK(a.call(8, "mining.submit", json::array({"rig-a", "job1", "zzzz", "5f5e1000", "00000001"}))["result"] == false);
+    CHECK(a.call(9, "mining.submit", json::array({"rig-a", "job1", "beef", "5f5e1000", "0000001"}))["result"] == false);
+
+    // O prefixo de um rig que saiu volta para o próximo, que já recebe o job atual.
+    a.close();
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    Rig c(config.listenPort);
+    json subC = c.call(1, "mining.subscribe", json::array());
+    CHECK_EQ(subC["result"][1].get<std::string>(), "aabbccdd0000");
+    CHECK_EQ(c.readLine()["method"].get<std::string>(), "mining.notify");
+
+    // Upstream mudo: cada rig tem no máximo maxPendingSubmits em voo, e os
+    // que o upstream não responde expiram com erro para o rig.
+    upstream.setSilent(true);
+    const json share = json::array({"rig-b", "job1", "beef", "5f5e1000", "0000002a"});
+    b.send(50, "mining.submit", share);
+    b.send(51, "mining.submit", share);
+    json capped = b.call(52, "mining.submit", share);
+    CHECK(capped["result"] == false);
+    CHECK_EQ(capped["error"][1].get<std::string>(), "Too many pending submits");
+    std::set<int> expired;
+    for (int i = 0; i < 2; ++i) {
+        json reply = b.readReply();
+        CHECK(reply["result"] == false);
+        CHECK_EQ(reply["error"][1].get<std::string>(), "Upstream did not answer");
+        expired.insert(reply["id"].get<int>());
+    }
+    CHECK(expired == (std::set<int>{50, 51}));
+
+    // O prefixo de um rig que sai com submit em voo só volta depois que ele expira.
+    // (c fala agora para não cair por inatividade antes do fim do teste.)
+    CHECK(c.call(2, "mining.authorize", json::array({"rig-c", "x"}))["result"] == true);
+    b.send(60, "mining.submit", share);
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    b.close();
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    Rig d(config.listenPort);
+    CHECK_EQ(d.call(1, "mining.subscribe", json::array())["result"][1].get<std::string>(), "aabbccdd0002");
+    std::this_thread::sleep_for(std::chrono::milliseconds(2500));
+    Rig e(config.listenPort);
+    CHECK_EQ(e.call(1, "mining.subscribe", json::array())["result"][1].get<std::string>(), "aabbccdd0001");
+
+    // Rig que não manda nada é desconectado no prazo de leitura.
+    Rig idle(config.listenPort);
+    const auto idleStart = std::chrono::steady_clock::now();
+    CHECK(idle.closedByPeer());
+    CHECK(std::chrono::steady_clock::now() - idleStart >= std::chrono::seconds(4));
+
+    // Upstream caiu: os rigs são desconectados, o proxy reconecta e assina de
+    // novo, e um rig que volta recebe o extranonce1 da nova sessão.
+    upstream.setSilent(false);
+    upstream.drop("11223344");
+    CHECK(d.closedByPeer());
+    CHECK(e.closedByPeer());
+    json resubscribed;
+    for (int attempt = 0; attempt < 50 && !resubscribed.is_array(); ++attempt) {
+        Rig f(config.listenPort);
+        resubscribed = f.call(1, "mining.subscribe", json::array())["result"];
+        if (resubscribed.is_array()) {
+            CHECK_EQ(resubscribed[1].get<std::string>(), "112233440000");
+            CHECK(f.call(2, "mining.submit", json::array({"rig-f", "job1", "cafe", "5f5e1000", "00000007"}))["result"] == true);
+            CHECK_EQ(upstream.waitSubmit()[2].get<std::string>(), "0000cafe");
+        } else {
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        }
+    }
+    CHECK(resubscribed.is_array());
+    CHECK_EQ(upstream.connections(), 2);
+
+    // Upstream sem espaço de extranonce2 para os prefixos: start() desiste.
+    FakeUpstream narrow(2);
+    narrow.start();
+    StratumProxyConfig narrowConfig = config;
+    narrowConfig.listenPort = freePort();
+    StratumProxy narrowProxy("127.0.0.1", narrow.port(), "user", "x", narrowConfig);
+    CHECK(!narrowProxy.start());
+
+    // As threads do proxy e do pool falso continuam bloqueadas em IO.
+    std::cout.flush();
+    std::_Exit(nerdminer::test::report("stratum_proxy"));
+}
@@ -0,0 +1,207 @@
+/**
+* Project: nerdminer-rpi
+* File: test_sv2_codec.cpp
+* Description: tests the Stratum V2 frame and message codec, including truncated input
+*
+* Author: Regis Araujo Melo
+* Date: 2025-04-21
+* Version: 0.1.0
+*
+* MIT License
+* © 2025 Regis Araujo Melo
+*/
+
+#include "check.h"
+#include <nerdminer/nerdminer_block.h>
+#include <nerdminer/sv2_codec.h>
+#include <stdexcept>
+
+using namespace nerdminer;
+using namespace nerdminer::sv2;
+
+namespace {
+
+U256 pattern(uint8_t seed) {
+    U256 v;
+    for (std::size_t i = 0; i < v.size(); ++i) {
+        v[i] = static_cast<uint8_t>(seed + i);
+    }
+    return v;
+}
+
+/**
+ * Codifica, confere o cabeçalho do frame e decodifica de volta. Todo prefixo
+ * estritamente menor do payload precisa ser rejeitado como truncado.
+ */
+template <typename Msg>
+Msg roundTrip(const Msg& msg, uint8_t msgType, bool channelMsg) {
+    const std::vector<uint8_t> frame = msg.encode();
+    CHECK(frame.size() >= kFrameHeaderSize);
+    const FrameHeader header = parseFrameHeader(frame.data());
+    CHECK_EQ(int(header.msgType), int(msgType));
+    CHECK_EQ(header.extensionType, channelMsg ? kChannelMsgBit : 0);
+    CHECK_EQ(header.length, frame.size() - kFrameHeaderSize);
+
+    const uint8_t* payload = frame.data() + kFrameHeaderSize;
+    for (std::size_t size = 0; size < header.length; ++size) {
+        Reader truncated(payload, size);
+        CHECK_THROWS(Msg::decode(truncated), std::invalid_argument);
+    }
+    Reader r(payload, header.length);
+    Msg decoded = Msg::decode(r);
+    CHECK(r.done());
+    return decoded;
+}
+
+} // namespace
+
+int main() {
+    // Cabeçalho: U16 + U8 + U24, little-endian.
+    const uint8_t raw[] = {0x00, 0x80, 0x15, 0x01, 0x02, 0x03};
+    FrameHeader header = parseFrameHeader(raw);
+    CHECK_EQ(header.extensionType, 0x8000);
+    CHECK_EQ(int(header.msgType), 0x15);
+    CHECK_EQ(header.length, 0x030201u);
+
+    SetupConnection setup;
+    setup.flags = 0x5;
+    setup.endpointHost = "pool.example";
+    setup.endpointPort = 3336;
+    setup.vendor = "nerdminer";
+    setup.hardwareVersion = "rpi4";
+    setup.firmware = "0.1.0";
+    setup.deviceId = "";
+    SetupConnection setupOut = roundTrip(setup, kSetupConnection, false);
+    CHECK_EQ(int(setupOut.protocol), int(kMiningProtocol));
+    CHECK_EQ(setupOut.minVersion, kProtocolVersion);
+    CHECK_EQ(setupOut.flags, 0x5u);
+    CHECK_EQ(setupOut.endpointHost, "pool.example");
+    CHECK_EQ(setupOut.endpointPort, 3336);
+    CHECK_EQ(setupOut.vendor, "nerdminer");
+    CHECK_EQ(setupOut.firmware, "0.1.0");
+    CHECK(setupOut.deviceId.empty());
+
+    SetupConnectionSuccess success;
+    success.flags = 0x3;
+    CHECK_EQ(roundTrip(success, kSetupConnectionSuccess, false).flags, 0x3u);
+
+    SetupConnectionError setupError;
+    setupError.errorCode = "unsupported-protocol";
+    CHECK_EQ(roundTrip(setupError, kSetupConnectionError, false).errorCode, "unsupported-protocol");
+
+    OpenStandardMiningChannel open;
+    open.requestId = 7;
+    open.userIdentity = "worker.1";
+    open.nominalHashRate = 1.5e6f;
+    open.maxTarget = pattern(1);
+    OpenStandardMiningChannel openOut = roundTrip(open, kOpenStandardMiningChannel, false);
+    CHECK_EQ(openOut.requestId, 7u);
+    CHECK_EQ(openOut.userIdentity, "worker.1");
+    CHECK(openOut.nominalHashRate == 1.5e6f);
+    CHECK(openOut.maxTarget == open.maxTarget);
+
+    OpenStandardMiningChannelSuccess opened;
+    opened.requestId = 7;
+    opened.channelId = 42;
+    opened.target = pattern(9);
+    opened.extranoncePrefix = {0xde, 0xad, 0xbe, 0xef};
+    opened.groupChannelId = 3;
+    OpenStandardMiningChannelSuccess openedOut = roundTrip(opened, kOpenStandardMiningChannelSuccess, false);
+    CHECK_EQ(openedOut.channelId, 42u);
+    CHECK(openedOut.target == opened.target);
+    CHECK(openedOut.extranoncePrefix == opened.extranoncePrefix);
+    CHECK_EQ(openedOut.groupChannelId, 3u);
+
+    OpenMiningChannelError openError;
+    openError.requestId = 8;
+    openError.errorCode = "max-target-out-of-range";
+    CHECK_EQ(roundTrip(openError, kOpenMiningChannelError, false).errorCode, "max-target-out-of-range");
+
+    // OPTION[U32]: presente (job ativo) e ausente (job futuro).
+    NewMiningJob job;
+    job.channelId = 42;
+    job.jobId = 1;
+    job.hasMinNtime = true;
+    job.minNtime = 0x5f5e1000;
+    job.version = 0x20000000;
+    job.merkleRoot = pattern(100);
+    NewMiningJob jobOut = roundTrip(job, kNewMiningJob, true);
+    CHECK(jobOut.hasMinNtime);
+    CHECK_EQ(jobOut.minNtime, 0x5f5e1000u);
+    CHECK_EQ(jobOut.version, 0x20000000u);
+    CHECK(jobOut.merkleRoot == job.merkleRoot);
+    job.hasMinNtime = false;
+    CHECK_EQ(job.encode().size(), kFrameHeaderSize + 4 + 4 + 1 + 4 + 32);
+    jobOut = roundTrip(job, kNewMiningJob, true);
+    CHECK(!jobOut.hasMinNtime);
+    CHECK_EQ(jobOut.jobId, 1u);
+
+    SetNewPrevHash prev;
+    prev.channelId = 42;
+    prev.jobId = 1;
+    prev.prevHash = pattern(50);
+    prev.minNtime = 0x5f5e1000;
+    prev.nbits = 0x1d00ffff;
+    SetNewPrevHash prevOut = roundTrip(prev, kSetNewPrevHash, true);
+    CHECK(prevOut.prevHash == prev.prevHash);
+    CHECK_EQ(prevOut.minNtime, 0x5f5e1000u);
+    CHECK_EQ(prevOut.nbits, 0x1d00ffffu);
+
+    SetTarget setTarget;
+    setTarget.channelId = 42;
+    setTarget.maximumTarget = pattern(200);
+    CHECK(roundTrip(setTarget, kSetTarget, true).maximumTarget == setTarget.maximumTarget);
+
+    SubmitSharesStandard submit;
+    submit.channelId = 42;
+    submit.sequenceNumber = 9;
+    submit.jobId = 1;
+    submit.nonce = 0xdeadbeef;
+    submit.ntime = 0x5f5e1001;
+    submit.version = 0x20000000;
+    SubmitSharesStandard submitOut = roundTrip(submit, kSubmitSharesStandard, true);
+    CHECK_EQ(submitOut.sequenceNumber, 9u);
+    CHECK_EQ(submitOut.nonce, 0xdeadbeefu);
+    CHECK_EQ(submitOut.ntime, 0x5f5e1001u);
+
+    SubmitSharesSuccess accepted;
+    accepted.channelId = 42;
+    accepted.lastSequenceNumber = 9;
+    accepted.newSubmitsAcceptedCount = 2;
+    accepted.newSharesSum = 0x100000000ull;
+    SubmitSharesSuccess acceptedOut = roundTrip(accepted, kSubmitSharesSuccess, true);
+    CHECK_EQ(acceptedOut.lastSequenceNumber, 9u);
+    CHECK_EQ(acceptedOut.newSharesSum, 0x100000000ull);
+
+    SubmitSharesError rejected;
+    rejected.channelId = 42;
+    rejected.sequenceNumber = 10;
+    rejected.errorCode = "difficulty-too-low";
+    CHECK_EQ(roundTrip(rejected, kSubmitSharesError, true).errorCode, "difficulty-too-low");
+
+    // Limites dos tipos de tamanho variável, na escrita e na leitura.
+    Writer w;
+    CHECK_THROWS(w.str0_255(std::string(256, 'x')), std::invalid_argument);
+    CHECK_THROWS(w.b0_32(std::vector<uint8_t>(33)), std::invalid_argument);
+    w.str0_255(std::string(255, 'x'));
+    w.b0_32(std::vector<uint8_t>(32, 0xab));
+    const std::vector<uint8_t> frame = w.frame(kSetupConnection, false);
+    Reader limits(frame.data() + kFrameHeaderSize, frame.size() - kFrameHeaderSize);
+    CHECK_EQ(limits.str0_255().size(), 255u);
+    CHECK_EQ(limits.b0_32().size(), 32u);
+    CHECK(limits.done());
+    const uint8_t oversized[] = {33};
+    Reader tooLong(oversized, sizeof(oversized));
+    CHECK_THROWS(tooLong.b0_32(), std::invalid_argument);
+
+    // Alvos: U256 little-endian no fio, big-endian no miner.
+    const std::vector<uint8_t> target = targetFromBits(0x1d00ffff);
+    const U256 wire = toU256(target);
+    CHECK_EQ(int(wire[31]), 0);
+    CHECK_EQ(int(wire[27]), 0xff);
+    CHECK_EQ(int(wire[26]), 0xff);
+    CHECK(fromU256(wire) == target);
+    CHECK_THROWS(toU256(std::vector<uint8_t>(31)), std::invalid_argument);
+
+    return nerdminer::test::report("sv2_codec");
+}
@@ -0,0 +1,333 @@
+/**
+* Project: nerdminer-rpi
+* File: test_sv2_work_source.cpp
+* Description: tests the SV2 work source against a fake pool: early jobs, channel ids, reconnection and retargeting
+*
+* Author: Regis Araujo Melo
+* Date: 2025-04-21
+* Version: 0.1.0
+*
+* MIT License
+* © 2025 Regis Araujo Melo
+*/
+
+#include "check.h"
+#include <nerdminer/miner_session.h>
+#include <nerdminer/sv2_work_source.h>
+#include <boost/asio.hpp>
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+
+using namespace nerdminer;
+using tcp = boost::asio::ip::tcp;
+
+namespace {
+
+constexpr uint32_t kChannel = 7;
+constexpr uint32_t kGroup = 9;
+
+// Alvo big-endian com `zeros` bytes zerados na frente e o resto 0xff.
+std::vector<uint8_t> easyTarget(std::size_t zeros, uint8_t next = 0xff) {
+    std::vector<uint8_t> target(32, 0xff);
+    for (std::size_t i = 0; i < zeros; ++i) {
+        target[i] = 0;
+    }
+    target[zeros] = next;
+    return target;
+}
+
+// Uma conexão do pool falso. Escritas de threads diferentes passam pelo mutex.
+class PoolConnection {
+public:
+    explicit PoolConnection(tcp::socket socket) : socket_(std::move(socket)) {}
+
+    void write(const std::vector<uint8_t>& frame) {
+        std::lock_guard<std::mutex> lock(writeMutex_);
+        boost::asio::write(socket_, boost::asio::buffer(frame));
+    }
+
+    // Lê um frame; false quando a conexão fecha.
+    bool readFrame(sv2::FrameHeader& header, std::vector<uint8_t>& payload) {
+        std::array<uint8_t, sv2::kFrameHeaderSize> raw;
+        boost::system::error_code ec;
+        boost::asio::read(socket_, boost::asio::buffer(raw), ec);
+        if (ec) {
+            return false;
+        }
+        header = sv2::parseFrameHeader(raw.data());
+        payload.resize(header.length);
+        boost::asio::read(socket_, boost::asio::buffer(payload), ec);
+        return !ec;
+    }
+
+    void sendJob(uint32_t channelId, uint32_t jobId, bool hasMinNtime, uint32_t minNtime) {
+        sv2::NewMiningJob job;
+        job.channelId = channelId;
+        job.jobId = jobId;
+        job.hasMinNtime = hasMinNtime;
+        job.minNtime = minNtime;
+        job.version = 0x20000000;
+        job.merkleRoot.fill(static_cast<uint8_t>(jobId));
+        write(job.encode());
+    }
+
+    void sendPrevHash(uint32_t channelId, uint32_t jobId, uint32_t minNtime) {
+        sv2::SetNewPrevHash prev;
+        prev.channelId = channelId;
+        prev.jobId = jobId;
+        prev.minNtime = minNtime;
+        prev.nbits = 0x1d00ffff;
+        write(prev.encode());
+    }
+
+    void sendTarget(const std::vector<uint8_t>& target) {
+        sv2::SetTarget msg;
+        msg.channelId = kChannel;
+        msg.maximumTarget = sv2::toU256(target);
+        write(msg.encode());
+    }
+
+    // Lê até a conexão fechar e devolve os submits recebidos, respondendo cada um.
+    std::vector<sv2::SubmitSharesStandard> collectSubmits(const std::function<void(std::size_t)>& onSubmit = {}) {
+        std::vector<sv2::SubmitSharesStandard> submits;
+        sv2::FrameHeader header;
+        std::vector<uint8_t> payload;
+        while (readFrame(header, payload)) {
+            if (header.msgType != sv2::kSubmitSharesStandard) {
+                continue;
+            }
+            sv2::Reader reader(payload.data(), payload.size());
+            submits.push_back(sv2::SubmitSharesStandard::decode(reader));
+            sv2::SubmitSharesSuccess ok;
+            ok.channelId = kChannel;
+            ok.lastSequenceNumber = submits.back().sequenceNumber;
+            ok.newSubmitsAcceptedCount = 1;
+            write(ok.encode());
+            if (onSubmit) {
+                onSubmit(submits.size());
+            }
+        }
+        return submits;
+    }
+
+private:
+    tcp::socket socket_;
+    std::mutex writeMutex_;
+};
+
+// Pool SV2 de mentira, síncrono: cada conexão faz o setup e abre o canal;
+// o resto do roteiro fica com o teste.
+class FakeSv2Pool {
+public:
+    FakeSv2Pool() : acceptor_(io_, tcp::endpoint(boost::asio::ip::address_v4::loopback(), 0)) {}
+
+    uint16_t port() const { return acceptor_.local_endpoint().port(); }
+
+    // Aceita uma conexão e responde SetupConnection e OpenStandardMiningChannel.
+    std::unique_ptr<PoolConnection> accept(const std::vector<uint8_t>& target = std::vector<uint8_t>(32, 0xff)) {
+        tcp::socket socket(io_);
+        acceptor_.accept(socket);
+        auto conn = std::make_unique<PoolConnection>(std::move(socket));
+        sv2::FrameHeader header;
+        std::vector<uint8_t> payload;
+        CHECK(conn->readFrame(header, payload));
+        CHECK_EQ(int(header.msgType), int(sv2::kSetupConnection));
+        conn->write(sv2::SetupConnectionSuccess().encode());
+        CHECK(conn->readFrame(header, payload));
+        CHECK_EQ(int(header.msgType), int(sv2::kOpenStandardMiningChannel));
+        sv2::OpenStandardMiningChannelSuccess open;
+        open.channelId = kChannel;
+        open.groupChannelId = kGroup;
+        open.target = sv2::toU256(target);
+        conn->write(open.encode());
+        return conn;
+    }
+
+private:
+    boost::asio::io_context io_;
+    tcp::acceptor acceptor_;
+};
+
+std::mutex eventsMutex;
+std::condition_variable eventsCv;
+// Jobs recebidos da fonte; um job inválido marca um onWorkLost.
+std::vector<MiningJob> events;
+
+MiningJob waitEvent() {
+    std::unique_lock<std::mutex> lock(eventsMutex);
+    eventsCv.wait(lock, [] { return !events.empty(); });
+    MiningJob job = events.front();
+    events.erase(events.begin());
+    return job;
+}
+
+void pushEvent(const MiningJob& job) {
+    std::lock_guard<std::mutex> lock(eventsMutex);
+    events.push_back(job);
+    eventsCv.notify_all();
+}
+
+ShareCandidate shareFor(const MiningJob& job, uint32_t nonce) {
+    ShareCandidate share;
+    share.job = job;
+    share.ntime = job.ntime;
+    share.nonce = nonce;
+    return share;
+}
+
+/**
+ * Jobs antes do prevhash, canais alheios, reconexão e stop()/start().
+ */
+void testJobsAndReconnect() {
+    FakeSv2Pool pool;
+    Sv2WorkSource source("127.0.0.1", pool.port(), "worker");
+    source.onJob = [](const MiningJob& job, const std::string&, std::size_t, uint64_t) {
+        pushEvent(job);
+    };
+    source.onWorkLost = [] {
+        pushEvent(MiningJob());
+    };
+
+    std::mutex submitsMutex;
+    std::condition_variable submitsCv;
+    std::vector<sv2::SubmitSharesStandard> reconnectSubmits;
+    bool reconnectDone = false;
+
+    std::thread([&] {
+        {
+            auto conn = pool.accept();
+            // Job ativo antes do primeiro prevhash: fica guardado até ele chegar.
+            conn->sendJob(kChannel, 1, true, 1000);
+            // Mensagens de outro canal são ignoradas.
+            conn->sendJob(99, 2, true, 1000);
+            conn->sendPrevHash(99, 2, 900);
+            // Prevhash endereçado ao grupo ativa o job 1 com o maior min_ntime.
+            conn->sendPrevHash(kGroup, 1, 900);
+            std::this_thread::sleep_for(std::chrono::milliseconds(200));
+            // Fecha a conexão: o cliente tem que voltar sozinho.
+        }
+        {
+            auto conn = pool.accept();
+            conn->sendJob(kChannel, 3, false, 0);
+            conn->sendPrevHash(kChannel, 3, 2000);
+            auto submits = conn->collectSubmits();
+            std::lock_guard<std::mutex> lock(submitsMutex);
+            reconnectSubmits = submits;
+            reconnectDone = true;
+            submitsCv.notify_all();
+        }
+        {
+            // Depois de stop()/start() a mesma fonte conecta de novo.
+            auto conn = pool.accept();
+            conn->sendJob(kChannel, 4, false, 0);
+            conn->sendPrevHash(kChannel, 4, 3000);
+            conn->collectSubmits();
+        }
+    }).detach();
+
+    source.start();
+    MiningJob first = waitEvent();
+    CHECK_EQ(first.jobId, std::string("1"));
+    CHECK_EQ(first.ntime, 1000u);
+    CHECK(first.cleanJobs);
+
+    // A queda avisa que o job antigo deixou de valer antes do job do canal novo.
+    CHECK(!waitEvent().valid);
+    MiningJob second = waitEvent();
+    CHECK_EQ(second.jobId, std::string("3"));
+    CHECK_EQ(second.ntime, 2000u);
+
+    // Share do job da conexão anterior não vai para o canal novo.
+    source.submitShare(shareFor(first, 11));
+    // Com ntime rolado o SubmitSharesStandard leva o ntime do share.
+    ShareCandidate rolled = shareFor(second, 22);
+    rolled.ntime = second.ntime + 42;
+    source.submitShare(rolled);
+    source.drain(std::chrono::seconds(5));
+
+    source.stop();
+    {
+        std::unique_lock<std::mutex> lock(submitsMutex);
+        submitsCv.wait(lock, [&] { return reconnectDone; });
+        CHECK_EQ(reconnectSubmits.size(), 1u);
+        if (!reconnectSubmits.empty()) {
+            CHECK_EQ(reconnectSubmits[0].jobId, 3u);
+            CHECK_EQ(reconnectSubmits[0].nonce, 22u);
+            CHECK_EQ(reconnectSubmits[0].ntime, 2042u);
+        }
+    }
+    source.start();
+    MiningJob third = waitEvent();
+    CHECK_EQ(third.jobId, std::string("4"));
+    CHECK_EQ(third.ntime, 3000u);
+    source.stop();
+
+    std::lock_guard<std::mutex> lock(eventsMutex);
+    CHECK(events.empty());
+}
+
+/**
+ * SetTarget no meio de um job: as threads seguem do ponto em que estavam,
+ * então nenhum share sai duas vezes.
+ */
+void testRetargetDoesNotRepeatShares() {
+    FakeSv2Pool pool;
+    MinerSession session;
+    session.addSource(std::make_unique<Sv2WorkSource>("127.0.0.1", pool.port(), "worker"));
+    session.setThreads(2);
+
+    std::vector<sv2::SubmitSharesStandard> submits;
+    std::mutex doneMutex;
+    std::condition_variable doneCv;
+    bool done = false;
+    std::thread poolThread([&] {
+        auto conn = pool.accept(easyTarget(2));
+        conn->sendJob(kChannel, 10, false, 0);
+        conn->sendPrevHash(kChannel, 10, 1700000000);
+        PoolConnection* raw = conn.get();
+        submits = conn->collectSubmits([&](std::size_t count) {
+            // Metade dos shares antes do alvo novo, metade depois.
+            if (count == 6) {
+                raw->sendTarget(easyTarget(2, 0xfe));
+            } else if (count == 12) {
+                std::lock_guard<std::mutex> lock(doneMutex);
+                done = true;
+                doneCv.notify_all();
+            }
+        });
+    });
+
+    std::thread runner([&session] { session.start(); });
+    {
+        std::unique_lock<std::mutex> lock(doneMutex);
+        doneCv.wait(lock, [&] { return done; });
+    }
+    session.stop();
+    runner.join();
+    poolThread.join();
+
+    CHECK(submits.size() >= 12);
+    std::set<std::pair<uint32_t, uint32_t>> seen;
+    for (const auto& submit : submits) {
+        CHECK_EQ(submit.jobId, 10u);
+        CHECK(seen.insert({submit.nonce, submit.ntime}).second);
+    }
+}
+
+} // namespace
+
+int main() {
+    alarm(60);
+    testJobsAndReconnect();
+    testRetargetDoesNotRepeatShares();
+    std::_Exit(test::report("sv2_work_source"));
+}
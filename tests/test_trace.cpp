@@ -0,0 +1,133 @@
+/**
+* Project: nerdminer-rpi
+* File: test_trace.cpp
+* Description: tests the Chrome trace writer: spans, async events across threads and thread names
+*
+* Author: Regis Araujo Melo
+* Date: 2025-04-21
+* Version: 0.1.0
+*
+* MIT License
+* © 2025 Regis Araujo Melo
+*/
+
+#include "check.h"
+#include <nerdminer/trace.h>
+#include <nlohmann/json.hpp>
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <set>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <unistd.h>
+
+using namespace nerdminer;
+using json = nlohmann::json;
+
+namespace {
+
+// Grava spans e eventos assíncronos que começam numa thread e terminam em outra.
+void recordEvents() {
+    traceSetThreadName("main");
+    const uint64_t scopeA = traceNewScope();
+    const uint64_t scopeB = traceNewScope();
+    CHECK(scopeA != scopeB);
+    {
+        TraceSpan span("job.prepare", 1);
+        traceInstant("share.hit", 7);
+    }
+    // Mesmo id em dois scopes: são pares distintos.
+    traceAsyncBegin("share.submit_to_ack", 5, 0, scopeA);
+    traceAsyncBegin("share.submit_to_ack", 5, 0, scopeB);
+    traceAsyncBegin("job.notify_to_first_hash", 3);
+
+    std::thread worker([scopeA, scopeB] {
+        traceSetThreadName("miner-0");
+        TraceSpan span("job.first_batch", 3);
+        traceAsyncEnd("job.notify_to_first_hash", 3);
+        traceAsyncEnd("share.submit_to_ack", 5, scopeB);
+    });
+    worker.join();
+    std::thread io([scopeA] {
+        traceSetThreadName("stratum-io");
+        traceAsyncEnd("share.submit_to_ack", 5, scopeA);
+    });
+    io.join();
+}
+
+void testWriteTrace(const std::string& path) {
+    recordEvents();
+    CHECK(writeTrace(path));
+
+    std::ifstream in(path);
+    json trace = json::parse(in, nullptr, false);
+    CHECK(!trace.is_discarded());
+    CHECK(trace.contains("traceEvents") && trace["traceEvents"].is_array());
+    if (trace.is_discarded() || !trace.contains("traceEvents")) {
+        return;
+    }
+
+    std::map<long, std::string> threadNames;
+    std::map<std::tuple<std::string, uint64_t>, double> open;
+    std::multiset<std::string> names;
+    std::size_t asyncPairs = 0;
+    for (const auto& ev : trace["traceEvents"]) {
+        CHECK(ev.contains("ph") && ev.contains("pid") && ev.contains("tid"));
+        const std::string ph = ev["ph"].get<std::string>();
+        if (ph == "M") {
+            CHECK_EQ(ev["name"].get<std::string>(), std::string("thread_name"));
+            threadNames[ev["tid"].get<long>()] = ev["args"]["name"].get<std::string>();
+            continue;
+        }
+        names.insert(ev["name"].get<std::string>());
+        CHECK(ev.contains("cat") && ev.contains("ts"));
+        if (ph == "X") {
+            CHECK(ev.contains("dur") && ev["dur"].get<double>() >= 0);
+        } else if (ph == "b" || ph == "e") {
+            CHECK(ev.contains("id2") && ev["id2"].contains("local"));
+            auto key = std::make_tuple(ev["cat"].get<std::string>(), ev["id2"]["local"].get<uint64_t>());
+            if (ph == "b") {
+                CHECK(open.count(key) == 0);
+                open[key] = ev["ts"].get<double>();
+            } else {
+                // Cada "e" fecha um "b" anterior com a mesma categoria e id.
+                auto it = open.find(key);
+                CHECK(it != open.end());
+                if (it != open.end()) {
+                    CHECK(ev["ts"].get<double>() >= it->second);
+                    open.erase(it);
+                    ++asyncPairs;
+                }
+            }
+        }
+    }
+    CHECK(open.empty());
+    CHECK_EQ(asyncPairs, 3u);
+    CHECK_EQ(names.count("job.prepare"), 1u);
+    CHECK_EQ(names.count("job.first_batch"), 1u);
+    CHECK_EQ(names.count("share.hit"), 1u);
+
+    // Toda thread que gravou eventos tem nome.
+    std::set<std::string> named;
+    for (const auto& entry : threadNames) {
+        named.insert(entry.second);
+    }
+    CHECK(named.count("main") && named.count("miner-0") && named.count("stratum-io"));
+    for (const auto& ev : trace["traceEvents"]) {
+        CHECK(threadNames.count(ev["tid"].get<long>()) == 1);
+    }
+}
+
+} // namespace
+
+int main() {
+    // Antes de ligar o trace nada é gravado.
+    traceInstant("share.hit", 99);
+    traceEnable();
+    const std::string path = "/tmp/nerdminer-trace-" + std::to_string(::getpid()) + ".json";
+    testWriteTrace(path);
+    std::remove(path.c_str());
+    return test::report("trace");
+}